@@ -29,62 +29,280 @@
  */
 
 #include "arbitragegraph.h"
-#include <set>
+#include "fastlog.h"
 #include <cmath>
 #include <iostream>
 #include <limits>
+#include <algorithm>
+#include <stdexcept>
 
 /**
- * @brief Creates a unique 64-bit key for an edge.
- * 
+ * @brief Finds the slot of the priced edge between two currencies.
+ *
+ * Edge slots follow pair IDs, so the lookup goes through the catalog: the
+ * source -> destination edge is the forward edge of pair "SOURCE-DESTINATION"
+ * or the reverse edge of pair "DESTINATION-SOURCE".
+ *
  * @param source_id The integer ID of the source currency vertex.
  * @param dest_id The integer ID of the destination currency vertex.
- * @return A unique 64-bit integer key representing the directed edge.
+ * @return The edge slot, or -1 if there is no such priced, unexpired edge.
  */
-uint64_t ArbitrageGraph::create_edge_key(int source_id, int dest_id) const {
-  return (static_cast<uint64_t>(source_id) << 32) | dest_id;
+int ArbitrageGraph::find_edge(int source_id, int dest_id) const {
+  int slot = -1;
+  int pair_id = pair_catalog.find_pair(source_id, dest_id);
+  if (pair_id >= 0) {
+    slot = 2 * pair_id;
+  } else if ((pair_id = pair_catalog.find_pair(dest_id, source_id)) >= 0) {
+    slot = 2 * pair_id + 1;
+  }
+  bool live = slot >= 0 && edges[slot].rate > 0.0 && edges[slot].expires_ns >= last_receive_ts_ns;
+  return live ? slot : -1;
 }
 
 /**
  * @brief Constructs the ArbitrageGraph.
  *
- * This constructor initializes the graph structure. It identifies all unique currencies
- * from the list of trading pairs, assigns each a unique integer ID, and sets up the
- * data structures needed for the SPFA algorithm.
+ * This constructor initializes the graph structure. It registers every trading pair in
+ * the graph's PairCatalog, which assigns each unique currency a dense integer ID, and
+ * sets up the data structures needed for the SPFA algorithm. Everything indexed by
+ * pair or currency is sized for the requested capacity, so pairs listed later only
+ * fill in slots that already exist.
+ *
+ * With an arena, each container is bound to its account in the initialiser list,
+ * before anything is sized, so nothing the graph owns touches the heap.
  *  
  * @param symbols A vector of strings, where each string is a trading pair (e.g., "BTC-USD").
+ * @param max_pairs Pair capacity; raised to the initial pair count if smaller.
+ * @param max_currencies Currency capacity; raised to the initial currency count if smaller.
+ * @param arena Arena for the graph's containers, or nullptr for the heap.
  */
-ArbitrageGraph::ArbitrageGraph(const std::vector<std::string>& symbols) {
+ArbitrageGraph::ArbitrageGraph(const std::vector<std::string>& symbols, int max_pairs, int max_currencies,
+                               EngineArena* arena)
+  : edges(arena_resource(arena, "book")),
+    adjacency_list(arena_resource(arena, "graph")),
+    listed(arena_resource(arena, "graph")),
+    cycle_index(arena_resource(arena, "cycle_index")),
+    updated_pairs(arena_resource(arena, "queues")),
+    pair_updated(arena_resource(arena, "queues")),
+    pair_ttl_ns(arena_resource(arena, "graph")),
+    expiry_wheel(0, EXPIRY_WHEEL_SLOTS, EXPIRY_TICK_NS, arena_resource(arena, "queues")),
+    pair_catalog(arena_resource(arena, "catalog")),
+    distance(arena_resource(arena, "search")),
+    fixed_distance(arena_resource(arena, "search")),
+    predecessor(arena_resource(arena, "search")),
+    update_counts(arena_resource(arena, "search")),
+    dirty_vertices(arena_resource(arena, "queues")) {
 
-  /* Fill set of currency names */
-  std::set<std::string> unique_currencies;
+  /* Currency IDs are assigned in order of first appearance */
   for (const auto& symbol : symbols) {
-    size_t delimiter_pos = symbol.find('-');
-    if (delimiter_pos != std::string::npos) {
-      unique_currencies.insert(symbol.substr(0, delimiter_pos));
-      unique_currencies.insert(symbol.substr(delimiter_pos+1));
+    if (symbol.find('-') != std::string::npos) {
+      this->pair_catalog.add_pair(symbol);
     }
   }
+  this->num_vertices = pair_catalog.num_currencies();
 
-  /* 2 maps for stirng->int conversion of currency names */
-  this->num_vertices = unique_currencies.size();
-  int current_id = 0;
-  for (const auto& currency_name : unique_currencies) {
-    this->currency_to_id[currency_name] = current_id;
-    this->id_to_currency.push_back(currency_name);
-    current_id++;
-  }
+  max_pairs = std::max(max_pairs, pair_catalog.num_pairs());
+  max_currencies = std::max(max_currencies, pair_catalog.num_currencies());
+  this->pair_catalog.reserve(max_pairs, max_currencies);
+
+  /* Both edges of every pair live at fixed slots */
+  this->edges.resize(2 * max_pairs);
+  this->listed.resize(max_pairs, 0);
+  this->pair_ttl_ns.resize(max_pairs, 0);
+  this->expiry_wheel = TimerWheel(max_pairs, EXPIRY_WHEEL_SLOTS, EXPIRY_TICK_NS, arena_resource(arena, "queues"));
 
   /* Data structure initialization for SPFA */
-  this->adjacency_list.resize(num_vertices);
-  this->distance.resize(num_vertices, std::numeric_limits<double>::infinity());
-  this->predecessor.resize(num_vertices, -1);
-  this->update_counts.resize(num_vertices, 0);
+  this->adjacency_list.resize(max_currencies);
+  this->distance.resize(max_currencies, std::numeric_limits<double>::infinity());
+  this->fixed_distance.resize(max_currencies, 0);
+  this->predecessor.resize(max_currencies, -1);
+  this->update_counts.resize(max_currencies, 0);
+  this->pair_updated.resize(max_pairs, 0);
+  this->updated_pairs.reserve(max_pairs);
+
+  for (int pair_id = 0; pair_id < pair_catalog.num_pairs(); pair_id++) {
+    attach_pair(pair_id);
+  }
   
   this->distance[0] = 0.0;
   
 }
 
+void ArbitrageGraph::attach_pair(int pair_id) {
+  int base_id = pair_catalog.base_id(pair_id);
+  int quote_id = pair_catalog.quote_id(pair_id);
+  double unpriced = std::numeric_limits<double>::infinity();
+  int64_t never = std::numeric_limits<int64_t>::max();
+  this->edges[2 * pair_id] = {base_id, quote_id, unpriced, UNPRICED_FIXED_WEIGHT, 0.0, never};
+  this->edges[2 * pair_id + 1] = {quote_id, base_id, unpriced, UNPRICED_FIXED_WEIGHT, 0.0, never};
+  this->adjacency_list[base_id].push_back(2 * pair_id);
+  this->adjacency_list[quote_id].push_back(2 * pair_id + 1);
+  this->listed[pair_id] = 1;
+  if (!cycle_index_stale) {
+    cycle_index.add_pair(pair_catalog, listed, pair_id);
+    rerank_pair_cycles(pair_id);
+  }
+}
+
+/**
+ * @brief Lists a pair at runtime.
+ *
+ * Capacity is checked before the catalog is touched, so a rejected symbol leaves
+ * the graph unchanged. The new edges start unpriced and take part in detection
+ * from the pair's first price update.
+ */
+int ArbitrageGraph::add_pair(const std::string& symbol) {
+  int pair_id = pair_catalog.find_pair(symbol);
+  if (pair_id >= 0) {
+    if (!is_listed(pair_id)) {
+      attach_pair(pair_id);
+    }
+    return pair_id;
+  }
+
+  size_t delimiter_pos = symbol.find('-');
+  if (delimiter_pos == std::string::npos) {
+    throw std::runtime_error("Invalid symbol format. Expected 'BASE-QUOTE', but received: '" + symbol + "'");
+  }
+  int new_currencies = (pair_catalog.find_currency(symbol.substr(0, delimiter_pos)) < 0 ? 1 : 0) +
+                       (pair_catalog.find_currency(symbol.substr(delimiter_pos + 1)) < 0 ? 1 : 0);
+  if (pair_catalog.num_pairs() + 1 > pair_capacity() ||
+      pair_catalog.num_currencies() + new_currencies > currency_capacity()) {
+    throw std::runtime_error("Graph capacity exceeded while listing '" + symbol + "'");
+  }
+
+  pair_id = pair_catalog.add_pair(symbol);
+  this->num_vertices = pair_catalog.num_currencies();
+  attach_pair(pair_id);
+  return pair_id;
+}
+
+/**
+ * @brief Delists a pair by unlinking its two edges from their source vertices.
+ *
+ * Each unlink is a swap-and-pop in one vertex's adjacency list, so the cost is
+ * proportional to the degree of the pair's two currencies and nothing is rebuilt.
+ */
+bool ArbitrageGraph::remove_pair(int pair_id) {
+  if (pair_id < 0 || pair_id >= pair_catalog.num_pairs() || !is_listed(pair_id)) {
+    return false;
+  }
+
+  for (uint32_t slot : {static_cast<uint32_t>(2 * pair_id), static_cast<uint32_t>(2 * pair_id + 1)}) {
+    std::pmr::vector<uint32_t>& outgoing = adjacency_list[edges[slot].source_id];
+    auto position = std::find(outgoing.begin(), outgoing.end(), slot);
+    *position = outgoing.back();
+    outgoing.pop_back();
+    edges[slot].weight = std::numeric_limits<double>::infinity();
+    edges[slot].fixed_weight = UNPRICED_FIXED_WEIGHT;
+    edges[slot].rate = 0.0;
+  }
+  this->listed[pair_id] = 0;
+  if (!cycle_index_stale) {
+    cycle_index.remove_pair(pair_id);
+  }
+  expiry_wheel.cancel(pair_id);
+  return true;
+}
+
+/**
+ * @brief Changes the weight representation and recomputes the weights of every priced edge.
+ *
+ * Weights are rebuilt from the stored rates (bid, and 1 / ask), so the ask side
+ * may differ from a fresh update in the last bit.
+ */
+void ArbitrageGraph::set_weight_mode(WeightMode mode) {
+  this->mode = mode;
+  for (int pair_id = 0; pair_id < pair_catalog.num_pairs(); pair_id++) {
+    Edge& forward = edges[2 * pair_id];
+    Edge& reverse = edges[2 * pair_id + 1];
+    if (is_listed(pair_id) && forward.rate > 0.0 && reverse.rate > 0.0) {
+      weigh_pair(pair_id, forward.rate, 1.0 / reverse.rate);
+      dirty_vertices.push_back(forward.source_id);
+    }
+  }
+}
+
+/**
+ * @brief Changes the detector and queues every priced pair for it.
+ *
+ * Indexed mode leaves weights untouched, so leaving it re-weighs each pair from
+ * its stored rates, as `set_weight_mode` does.
+ */
+void ArbitrageGraph::set_detection_mode(DetectionMode detection) {
+  this->detection = detection;
+  for (int pair_id = 0; pair_id < pair_catalog.num_pairs(); pair_id++) {
+    Edge& forward = edges[2 * pair_id];
+    Edge& reverse = edges[2 * pair_id + 1];
+    if (is_listed(pair_id) && forward.rate > 0.0 && reverse.rate > 0.0) {
+      if (detection == DetectionMode::Spfa) {
+        weigh_pair(pair_id, forward.rate, 1.0 / reverse.rate);
+      }
+      mark_updated(pair_id);
+    }
+  }
+}
+
+void ArbitrageGraph::set_cycle_index(int max_legs, const std::vector<int>& anchor_currency_ids) {
+  if (max_legs < 3 || max_legs > CycleIndex::MAX_CYCLE_LENGTH) {
+    throw std::runtime_error("Indexed cycles must have 3 to " + std::to_string(CycleIndex::MAX_CYCLE_LENGTH) +
+                             " legs, not " + std::to_string(max_legs));
+  }
+  this->cycle_max_legs = max_legs;
+  this->cycle_anchors = anchor_currency_ids;
+  this->cycle_index_stale = true;
+}
+
+const CycleIndex& ArbitrageGraph::indexed_cycles() {
+  if (cycle_index_stale) {
+    cycle_index.build(pair_catalog, listed, cycle_max_legs, cycle_anchors);
+    const double hurdle = 1.0 + RELAXATION_EPSILON;
+    cycle_index.rank_all([&](int cycle) { return rank_key(cycle_margin(cycle, hurdle, last_receive_ts_ns)); });
+    cycle_index_stale = false;
+  }
+  return cycle_index;
+}
+
+/**
+ * @brief Ranks the cycles through a pair's edges by their current margins, as detection would.
+ */
+void ArbitrageGraph::rerank_pair_cycles(int pair_id) {
+  const double hurdle = 1.0 + RELAXATION_EPSILON;
+  for (uint32_t slot : {static_cast<uint32_t>(2 * pair_id), static_cast<uint32_t>(2 * pair_id + 1)}) {
+    for (const uint32_t* cycle = cycle_index.cycles_begin(slot); cycle != cycle_index.cycles_end(slot); cycle++) {
+      if (cycle_index.is_live(static_cast<int>(*cycle))) {
+        cycle_index.rerank(static_cast<int>(*cycle), rank_key(cycle_margin(static_cast<int>(*cycle), hurdle,
+                                                                           last_receive_ts_ns)));
+      }
+    }
+  }
+}
+
+/**
+ * @brief Sets the rates and weights of a pair's two edges in the current weight mode.
+ */
+void ArbitrageGraph::weigh_pair(int pair_id, double bid, double ask) {
+  Edge& forward = edges[2 * pair_id];
+  Edge& reverse = edges[2 * pair_id + 1];
+
+  forward.rate = bid;
+  reverse.rate = 1.0 / ask;
+  if (detection == DetectionMode::Indexed) {
+    /* Indexed cycles multiply the rates directly */
+    return;
+  }
+  if (mode == WeightMode::FixedPoint) {
+    /* -log(1 / ask) is log(ask); taking it directly keeps bid == ask an exact zero-sum round trip */
+    forward.fixed_weight = -fixed_log(bid);
+    reverse.fixed_weight = fixed_log(ask);
+    forward.weight = fixed_log_to_double(forward.fixed_weight);
+    reverse.weight = fixed_log_to_double(reverse.fixed_weight);
+  } else {
+    forward.weight = -log(bid);
+    reverse.weight = -log(1.0 / ask);
+  }
+}
+
 /**
  * @brief Updates the graph with a new price tick.
  * 
@@ -99,57 +317,134 @@ ArbitrageGraph::ArbitrageGraph(const std::vector<std::string>& symbols) {
 void ArbitrageGraph::update_price(const std::string& symbol, double price) {
 
   /* Get Ids of input symbols */
-  size_t delimiter_pos = symbol.find('-');
-  if (delimiter_pos == std::string::npos) {
-    throw std::runtime_error("Invalid symbol format. Expected 'BASE-QUOTE', but received: '" + symbol + "'");
+  int pair_id = pair_catalog.find_pair(symbol);
+  if (pair_id < 0) {
+    if (symbol.find('-') == std::string::npos) {
+      throw std::runtime_error("Invalid symbol format. Expected 'BASE-QUOTE', but received: '" + symbol + "'");
+    }
+    std::cerr << "Error: The pair '" << symbol << "' is not tracked; list it with add_pair first." << std::endl;
+    return;
   }
 
-  std::string base_currency = symbol.substr(0, delimiter_pos);
-  std::string quote_currency = symbol.substr(delimiter_pos+1);
+  update_price(pair_id, price);
+}
 
-  auto const base_iter = currency_to_id.find(base_currency);
-  auto const quote_iter = currency_to_id.find(quote_currency);
+/**
+ * @brief Updates the two edges of a pair from a last traded price.
+ *
+ * A trade print carries no spread, so both directions are priced off the same
+ * price; feeds with a top of book should use `update_quote` instead.
+ */
+void ArbitrageGraph::update_price(int pair_id, double price, int64_t exchange_ts_ns, int64_t receive_ts_ns) {
+  update_quote(pair_id, price, price, exchange_ts_ns, receive_ts_ns);
+}
 
-  if (base_iter == currency_to_id.end() || quote_iter == currency_to_id.end()) {
-    std::cerr << "Error: One or both currencies in the pair '" << base_currency << "-" << quote_currency << "' are not tracked." << std::endl;
+/**
+ * @brief Updates the two edges of a pair without any symbol lookup.
+ *
+ * The forward (base -> quote) edge lives at slot 2 * pair_id and is priced at the
+ * bid; the reverse edge at 2 * pair_id + 1 is priced at one over the ask. The
+ * tick's timestamps are kept so that an opportunity found by the next
+ * `find_arbitrage_cycle` carries the update that triggered it.
+ */
+void ArbitrageGraph::update_quote(int pair_id, double bid, double ask, int64_t exchange_ts_ns,
+                                  int64_t receive_ts_ns) {
+
+  if (!is_listed(pair_id) || !(bid > 0.0) || !(ask > 0.0)) {
     return;
   }
 
-  int base_id = base_iter->second;
-  int quote_id = quote_iter->second;
+  weigh_pair(pair_id, bid, ask);
 
+  this->last_exchange_ts_ns = exchange_ts_ns;
+  this->last_receive_ts_ns = receive_ts_ns;
+  stamp_pair(pair_id, receive_ts_ns);
+  mark_updated(pair_id);
+}
 
-  /** 
-   * TODO: KEY OPTIMIZATION REQUIRED
-   * 
-   * Instead of injesting "last traded price", ingest L1 order book data (best bid and best ask)
-   * Reverse weight is its own argument, not calculated off of inputted price.
-   */
-  double weight = -log(price);
-  double reverse_weight = -log(1.0 / price);
-
-  /* Update Forward Edge */
-  uint64_t forward_key = create_edge_key(base_id, quote_id);
-  if (edge_index_map.find(forward_key) == edge_index_map.end()) {
-    adjacency_list[base_id].push_back({quote_id, weight});
-    edge_index_map[forward_key] = adjacency_list[base_id].size() - 1;
-  } else {
-    adjacency_list[base_id][edge_index_map[forward_key]].weight = weight;
+void ArbitrageGraph::mark_updated(int pair_id) {
+  if (detection == DetectionMode::Indexed) {
+    if (!pair_updated[pair_id]) {
+      pair_updated[pair_id] = 1;
+      updated_pairs.push_back(pair_id);
+    }
+    return;
   }
 
-  /* Update Reverse Edge */
-  uint64_t reverse_key = create_edge_key(quote_id, base_id);
-  if (edge_index_map.find(reverse_key) == edge_index_map.end()) {
-    adjacency_list[quote_id].push_back({base_id, reverse_weight});
-    edge_index_map[reverse_key] = adjacency_list[quote_id].size() - 1;
-  } else {
-    adjacency_list[quote_id][edge_index_map[reverse_key]].weight = reverse_weight;
+  /* Key SPFA Optimization */
+  dirty_vertices.push_back(edges[2 * pair_id].source_id);
+  dirty_vertices.push_back(edges[2 * pair_id + 1].source_id);
+}
+
+void ArbitrageGraph::stamp_pair(int pair_id, int64_t receive_ts_ns) {
+  Edge& forward = edges[2 * pair_id];
+  Edge& reverse = edges[2 * pair_id + 1];
+
+  /* Quotes of a pair with a TTL are ignored by detection once it passes */
+  int64_t expires_ns = std::numeric_limits<int64_t>::max();
+  if (pair_ttl_ns[pair_id] > 0) {
+    expires_ns = receive_ts_ns + pair_ttl_ns[pair_id];
+    expiry_wheel.schedule(pair_id, expires_ns);
   }
+  forward.expires_ns = expires_ns;
+  reverse.expires_ns = expires_ns;
+}
 
-  /* Key SPFA Optimization */
-  dirty_vertices.push_back(base_id);
-  dirty_vertices.push_back(quote_id);
+void ArbitrageGraph::update_quotes(const int32_t* pair_ids, const double* bids, const double* asks, size_t count,
+                                   int64_t receive_ts_ns) {
+  if (mode == WeightMode::FixedPoint || detection == DetectionMode::Indexed) {
+    for (size_t i = 0; i < count; i++) {
+      update_quote(pair_ids[i], bids[i], asks[i], 0, receive_ts_ns);
+    }
+    return;
+  }
+
+  /*
+   * Gather the valid quotes of each chunk, take all their logs in one vectorised pass
+   * (bids in the first half of `rates`, asks in the second), then scatter the weights
+   * back in input order so a pair quoted twice keeps its last quote.
+   */
+  int accepted[UPDATE_BATCH];
+  double rates[2 * UPDATE_BATCH];
+  double logs[2 * UPDATE_BATCH];
 
+  size_t next = 0;
+  while (next < count) {
+    size_t n = 0;
+    for (; next < count && n < UPDATE_BATCH; next++) {
+      int pair_id = pair_ids[next];
+      if (!is_listed(pair_id) || !(bids[next] > 0.0) || !(asks[next] > 0.0)) {
+        continue;
+      }
+      accepted[n] = pair_id;
+      rates[n] = bids[next];
+      rates[UPDATE_BATCH + n] = asks[next];
+      n++;
+    }
+    if (n == 0) {
+      continue;
+    }
+    log_batch(rates, logs, n);
+    log_batch(rates + UPDATE_BATCH, logs + UPDATE_BATCH, n);
+    for (size_t j = 0; j < n; j++) {
+      rates[UPDATE_BATCH + j] = 1.0 / rates[UPDATE_BATCH + j];
+    }
+
+    for (size_t j = 0; j < n; j++) {
+      int pair_id = accepted[j];
+      Edge& forward = edges[2 * pair_id];
+      Edge& reverse = edges[2 * pair_id + 1];
+      forward.rate = rates[j];
+      reverse.rate = rates[UPDATE_BATCH + j];
+      forward.weight = -logs[j];
+      reverse.weight = logs[UPDATE_BATCH + j];
+      stamp_pair(pair_id, receive_ts_ns);
+    }
+    this->last_exchange_ts_ns = 0;
+    this->last_receive_ts_ns = receive_ts_ns;
+    /* Detection restarts from every vertex, so one entry marks the whole chunk */
+    dirty_vertices.push_back(edges[2 * accepted[0]].source_id);
+  }
 }
 
 /**
@@ -157,69 +452,366 @@ void ArbitrageGraph::update_price(const std::string& symbol, double price) {
  * 
  * This function implements the Shortest Path Faster Algorithm (SPFA). It iteratively
  * "relaxes" the edges of the graph, updating the shortest known distance from the source
- * to each vertex. If it detects that a vertex has been updated more times than there are
- * vertices in the graph, it signifies the presence of a negative weight cycle.
+ * to each vertex. If the shortest path to a vertex ever contains as many edges as there
+ * are vertices in the graph, that path must repeat a vertex, which signifies the
+ * presence of a negative weight cycle.
+ *
+ * A weight increase can invalidate every distance computed before it, so each pass
+ * starts from a virtual source joined to every vertex by a zero-weight edge rather
+ * than reusing the previous pass's distances. Passes only run when a price update has
+ * marked vertices dirty since the last one. Relaxations must improve a distance by
+ * more than `RELAXATION_EPSILON`, so that rounding noise in -log(p) + -log(1/p) does
+ * not register as a profitable two-leg cycle. Fixed-point weights add exactly, but
+ * each is rounded once, so they keep a margin of one unit per leg,
+ * `FIXED_RELAXATION_EPSILON`. Edges whose quotes expired before the latest update's
+ * receive time are skipped as if absent.
  * 
- * @return An `std::optional` containing a vector of currency names in the cycle if one is found,
- * or `std::nullopt` if no opportunity exists.
+ * @param out Receives the cycle if one is found.
+ * @return True if an opportunity was written to `out`, false if none exists.
  */
-std::optional<std::vector<std::string>> ArbitrageGraph::find_arbitrage_cycle() {
+bool ArbitrageGraph::find_arbitrage_cycle(Opportunity& out) {
+
+  if (detection == DetectionMode::Indexed) {
+    return find_indexed_cycle(out);
+  }
+
+  if (dirty_vertices.empty()) {
+    return false;
+  }
+  dirty_vertices.clear();
+
+  if (mode == WeightMode::FixedPoint) {
+    return find_negative_cycle(fixed_distance, [this](uint32_t slot) { return edges[slot].fixed_weight; },
+                               FIXED_RELAXATION_EPSILON, out);
+  }
+  return find_negative_cycle(distance, [this](uint32_t slot) { return edges[slot].weight; }, RELAXATION_EPSILON,
+                             out);
+}
+
+template <typename Weight, typename WeightOf>
+bool ArbitrageGraph::find_negative_cycle(std::pmr::vector<Weight>& dist, WeightOf weight_of, Weight epsilon,
+                                         Opportunity& out) {
+  std::fill(dist.begin(), dist.end(), Weight{0});
+  std::fill(predecessor.begin(), predecessor.end(), -1);
+  std::fill(update_counts.begin(), update_counts.end(), 0);
+  int64_t now_ns = last_receive_ts_ns;
+  for (int v = 0; v < num_vertices; v++) {
+    dirty_vertices.push_back(v);
+  }
   
   while (!dirty_vertices.empty()) {
   
     int u = dirty_vertices.front();
     dirty_vertices.pop_front();
 
-    for (const auto& edge : adjacency_list[u]) {
+    for (uint32_t slot : adjacency_list[u]) {
 
-      int v = edge.destination_id;
-      double weight = edge.weight;
+      if (edges[slot].expires_ns < now_ns) {
+        continue;
+      }
+      int v = edges[slot].destination_id;
+      Weight weight = weight_of(slot);
 
-      if (distance[u] != std::numeric_limits<double>::infinity() && distance[u] + weight < distance[v]) {
-        distance[v] = distance[u] + weight;
-        predecessor[v] = u;
+      if (dist[u] + weight < dist[v] - epsilon) {
+        dist[v] = dist[u] + weight;
+        predecessor[v] = static_cast<int>(slot);
         dirty_vertices.push_back(v);
 
-        update_counts[v]++;
+        /* Number of edges on the current shortest path to v */
+        update_counts[v] = update_counts[u] + 1;
         if (update_counts[v] >= num_vertices) {
-          return reconstruct_cycle(v);
+          dirty_vertices.clear();
+          return reconstruct_cycle(v, out);
         }
       }
     }
   }
 
-  return std::nullopt;
+  return false;
 
 }
 
 /**
- * @brief Reconstructs the arbitrage cycle from the predecessor list.
+ * @brief Reconstructs the arbitrage cycle from the predecessor edges.
  * 
  * Once a negative cycle is detected by `find_arbitrage_cycle`, this function is called
- * to trace back through the `predecessor` array to identify the exact path of the cycle.
+ * to trace back through the `predecessor` edges to identify the exact path of the cycle.
+ * The walk yields the legs last-to-first, so they are collected in a fixed-size
+ * buffer and written to `out` in trading order; nothing is allocated.
  * 
+ * The predecessor walk lands on an arbitrary vertex of the cycle. If an inventory is
+ * attached, the cycle is rotated so that it starts (and ends) at the held currency
+ * with the most capacity; if none of its currencies is held it cannot be traded
+ * without an extra conversion leg, so it is dropped here, before any scoring.
+ *
  * @param start_node A node that is part of the detected negative cycle.
- * @return A vector of strings representing the currencies in the arbitrage cycle.
+ * @param out Receives the cycle.
+ * @return False if the cycle was pruned.
  */
-std::vector<std::string> ArbitrageGraph::reconstruct_cycle(int start_node) const {
-  std::vector<std::string> cycle;
-  std::vector<int> path;
-
+bool ArbitrageGraph::reconstruct_cycle(int start_node, Opportunity& out) {
   int current = start_node;
   for (int i = 0; i < num_vertices; i++) {
-    current = predecessor.at(current);
+    if (predecessor[current] < 0) {
+      return false;
+    }
+    current = edges[predecessor[current]].source_id;
   }
 
+  /* Collect the legs backwards; cycles too long for an Opportunity are dropped */
+  uint32_t backwards[Opportunity::MAX_LEGS];
+  int num_legs = 0;
   int cycle_start = current;
   do {
-    path.insert(path.begin(), current);
-    current = predecessor.at(current);
+    if (num_legs == Opportunity::MAX_LEGS || predecessor[current] < 0) {
+      pruned_cycles++;
+      return false;
+    }
+    backwards[num_legs++] = static_cast<uint32_t>(predecessor[current]);
+    current = edges[backwards[num_legs - 1]].source_id;
   } while (current != cycle_start);
-  path.insert(path.begin(), cycle_start);
 
-  for (int node_id : path) {
-    cycle.push_back(id_to_currency.at(node_id));
+  int first_leg = 0;
+  if (inventory != nullptr) {
+    int sources[Opportunity::MAX_LEGS];
+    for (int i = 0; i < num_legs; i++) {
+      sources[i] = edges[backwards[num_legs - 1 - i]].source_id;
+    }
+    first_leg = inventory->best_start(sources, num_legs);
+    if (first_leg < 0) {
+      pruned_cycles++;
+      return false;
+    }
+  }
+
+  out.num_legs = num_legs;
+  out.log_profit = 0.0;
+  int64_t fixed_weight_sum = 0;
+  for (int i = 0; i < num_legs; i++) {
+    uint32_t slot = backwards[num_legs - 1 - (first_leg + i) % num_legs];
+    const Edge& edge = edges[slot];
+    out.edge_slots[i] = slot;
+    out.currency_ids[i] = edge.source_id;
+    out.rates[i] = edge.rate;
+    out.log_profit -= edge.weight;
+    fixed_weight_sum += edge.fixed_weight;
+  }
+  if (mode == WeightMode::FixedPoint) {
+    out.log_profit = -fixed_log_to_double(fixed_weight_sum);
+  }
+  out.currency_ids[num_legs] = out.currency_ids[0];
+  out.exchange_ts_ns = last_exchange_ts_ns;
+  out.receive_ts_ns = last_receive_ts_ns;
+  return true;
+}
+
+/**
+ * @brief Finds the most profitable indexed cycle through the pairs updated since the last call.
+ *
+ * Only cycles containing an updated edge can have changed, so the cost is the
+ * number of those cycles, not the size of the market. An n-leg cycle is profitable
+ * when r1 * ... * rn > 1 + RELAXATION_EPSILON, the hurdle SPFA applies to log
+ * weights, and is checked as fma(fl(r1 * ... * r(n-1)), rn, -hurdle) > 0.
+ *
+ * Error analysis, with u = 2^-53 the unit roundoff:
+ * - A forward rate is the bid itself; a reverse rate is fl(1 / ask), off by at most u relatively.
+ * - The n - 2 products before the last leg add at most u each. The fma rounds once,
+ *   after the subtraction, so it keeps the sign of (product * rn - hurdle) exactly.
+ * - The hurdle is fl(1 + 1e-12), off by at most u absolutely.
+ * The verdict is therefore exact for rates perturbed by at most (2n - 1)u in total:
+ * 5u ~ 5.6e-16 for a triangle and 9u ~ 1e-15 for five legs (one u more each
+ * without the fma), whatever the price levels. The log path instead loses about
+ * one ulp of |log(rate)| per leg, which for prices far from 1 (log(60000) ~ 11)
+ * is several times 1e-15. Either way the 1e-12 hurdle is three orders of
+ * magnitude above the rounding error, so both detectors agree except on cycles
+ * within a rounding error of it.
+ *
+ * Every evaluated cycle is re-ranked with its new margin, which keeps
+ * `best_indexed_cycle` current. Unprofitable cycles share one key, so while
+ * nothing is profitable re-ranking is skipped outright, and a cycle that stays
+ * below the hurdle never moves; only profitable ones pay O(log cycles).
+ *
+ * The log-profit is only taken for the reported cycle, off the per-tick path.
+ */
+bool ArbitrageGraph::find_indexed_cycle(Opportunity& out) {
+  if (updated_pairs.empty()) {
+    return false;
+  }
+  indexed_cycles();
+
+  const double hurdle = 1.0 + RELAXATION_EPSILON;
+  int64_t now_ns = last_receive_ts_ns;
+  int best_cycle = -1;
+  int best_first_leg = 0;
+  double best_margin = 0.0;
+  bool ranking_profitable = cycle_index.num_cycles() > 0 && cycle_index.ranked_margin(cycle_index.best_cycle()) > 0.0;
+  for (int pair_id : updated_pairs) {
+    pair_updated[pair_id] = 0;
+    for (uint32_t slot : {static_cast<uint32_t>(2 * pair_id), static_cast<uint32_t>(2 * pair_id + 1)}) {
+      for (const uint32_t* cycle = cycle_index.cycles_begin(slot); cycle != cycle_index.cycles_end(slot); cycle++) {
+        if (!cycle_index.is_live(static_cast<int>(*cycle))) {
+          continue;
+        }
+        double margin = cycle_margin(static_cast<int>(*cycle), hurdle, now_ns);
+        /* While nothing ranks above 0, an unprofitable cycle is already in place without touching its key */
+        if (margin > 0.0 || ranking_profitable) {
+          cycle_index.rerank(static_cast<int>(*cycle), rank_key(margin));
+          ranking_profitable = cycle_index.ranked_margin(cycle_index.best_cycle()) > 0.0;
+        }
+        if (!(margin > best_margin)) {
+          continue;
+        }
+
+        int first_leg = 0;
+        if (inventory != nullptr) {
+          const uint32_t* legs = cycle_index.cycle_edges(static_cast<int>(*cycle));
+          int sources[Opportunity::MAX_LEGS];
+          int num_legs = cycle_index.cycle_length(static_cast<int>(*cycle));
+          for (int i = 0; i < num_legs; i++) {
+            sources[i] = edges[legs[i]].source_id;
+          }
+          first_leg = inventory->best_start(sources, num_legs);
+          if (first_leg < 0) {
+            pruned_cycles++;
+            continue;
+          }
+        }
+        best_cycle = static_cast<int>(*cycle);
+        best_first_leg = first_leg;
+        best_margin = margin;
+      }
+    }
+  }
+  updated_pairs.clear();
+  if (best_cycle < 0) {
+    return false;
+  }
+  write_indexed_cycle(best_cycle, best_first_leg, out);
+  return true;
+}
+
+/**
+ * @brief Reads the top of the cycle ranking.
+ *
+ * Ranked margins can only be stale in two ways: a quote updated since the last
+ * detection, or a leg that has since expired. The top is re-evaluated and
+ * re-ranked until its margin holds, which usually takes one evaluation, and no
+ * cycle needs correcting twice in one call.
+ */
+bool ArbitrageGraph::best_indexed_cycle(Opportunity& out) {
+  if (detection != DetectionMode::Indexed) {
+    return false;
+  }
+  indexed_cycles();
+
+  const double hurdle = 1.0 + RELAXATION_EPSILON;
+  int best_cycle = cycle_index.best_cycle();
+  while (best_cycle >= 0) {
+    /* Retired cycles rank at -infinity, so one on top means nothing is ranked above them */
+    if (!cycle_index.is_live(best_cycle)) {
+      return false;
+    }
+    double key = rank_key(cycle_margin(best_cycle, hurdle, last_receive_ts_ns));
+    if (key == cycle_index.ranked_margin(best_cycle)) {
+      break;
+    }
+    cycle_index.rerank(best_cycle, key);
+    best_cycle = cycle_index.best_cycle();
+  }
+  if (best_cycle < 0 || !(cycle_index.ranked_margin(best_cycle) > 0.0)) {
+    return false;
+  }
+
+  int first_leg = 0;
+  if (inventory != nullptr) {
+    const uint32_t* legs = cycle_index.cycle_edges(best_cycle);
+    int sources[Opportunity::MAX_LEGS];
+    int num_legs = cycle_index.cycle_length(best_cycle);
+    for (int i = 0; i < num_legs; i++) {
+      sources[i] = edges[legs[i]].source_id;
+    }
+    first_leg = inventory->best_start(sources, num_legs);
+    if (first_leg < 0) {
+      pruned_cycles++;
+      return false;
+    }
+  }
+  write_indexed_cycle(best_cycle, first_leg, out);
+  return true;
+}
+
+void ArbitrageGraph::write_indexed_cycle(int cycle, int first_leg, Opportunity& out) const {
+  const uint32_t* legs = cycle_index.cycle_edges(cycle);
+  int num_legs = cycle_index.cycle_length(cycle);
+  double product = 1.0;
+  out.num_legs = num_legs;
+  for (int i = 0; i < num_legs; i++) {
+    uint32_t slot = legs[(first_leg + i) % num_legs];
+    out.edge_slots[i] = slot;
+    out.currency_ids[i] = edges[slot].source_id;
+    out.rates[i] = edges[slot].rate;
+    product *= edges[slot].rate;
+  }
+  out.currency_ids[num_legs] = out.currency_ids[0];
+  out.log_profit = std::log(product);
+  out.exchange_ts_ns = last_exchange_ts_ns;
+  out.receive_ts_ns = last_receive_ts_ns;
+}
+
+double ArbitrageGraph::cycle_margin(int cycle, double hurdle, int64_t now_ns) const {
+  const uint32_t* legs = cycle_index.cycle_edges(cycle);
+  int last = cycle_index.cycle_length(cycle) - 1;
+  double product = 1.0;
+  for (int i = 0; i < last; i++) {
+    const Edge& edge = edges[legs[i]];
+    product *= edge.expires_ns >= now_ns ? edge.rate : 0.0;
   }
+  const Edge& edge = edges[legs[last]];
+  return std::fma(product, edge.expires_ns >= now_ns ? edge.rate : 0.0, -hurdle);
+}
 
-  return cycle;
-}
\ No newline at end of file
+/**
+ * @brief Evaluates a cycle's log-profit from the current edge weights.
+ *
+ * Edge weights are -log(rate), so the log of the rate product is minus their sum.
+ * In fixed-point mode the sum is taken exactly and converted once. Indexed mode
+ * keeps no weights, so the rates are multiplied instead.
+ */
+double ArbitrageGraph::cycle_log_profit(const int* cycle, int length) const {
+  double weight_sum = 0.0;
+  int64_t fixed_weight_sum = 0;
+  double product = 1.0;
+  for (int i = 0; i < length; i++) {
+    int slot = find_edge(cycle[i], cycle[(i + 1) % length]);
+    if (slot < 0) {
+      return -std::numeric_limits<double>::infinity();
+    }
+    weight_sum += edges[slot].weight;
+    fixed_weight_sum += edges[slot].fixed_weight;
+    product *= edges[slot].rate;
+  }
+  if (detection == DetectionMode::Indexed) {
+    return std::log(product);
+  }
+  if (mode == WeightMode::FixedPoint) {
+    return -fixed_log_to_double(fixed_weight_sum);
+  }
+  return -weight_sum;
+}
+
+/**
+ * @brief Drains expiry events from the timer wheel.
+ *
+ * The wheel only holds one timer per pair, moved forward on every update, so a
+ * pair that keeps ticking never fires. Events beyond `max_out` are counted but
+ * not reported.
+ */
+int ArbitrageGraph::expire_stale(int64_t now_ns, int* expired_pairs, int max_out) {
+  int reported = 0;
+  expiry_wheel.advance(now_ns, [&](int pair_id) {
+    stale_pairs++;
+    if (reported < max_out) {
+      expired_pairs[reported++] = pair_id;
+    }
+  });
+  return reported;
+}
@@ -2,9 +2,33 @@
 
 #include <string>
 #include <vector>
-#include <unordered_map>
-#include <optional>
+#include <deque>
 #include <cstdint>
+#include <memory_resource>
+
+#include "cycleindex.h"
+#include "enginearena.h"
+#include "fixedlog.h"
+#include "paircatalog.h"
+#include "inventory.h"
+#include "opportunity.h"
+#include "timerwheel.h"
+
+/**
+ * @brief How edge weights are represented during detection.
+ */
+enum class WeightMode {
+  Double,     ///< -log(rate) as a double; relaxations must beat `RELAXATION_EPSILON`.
+  FixedPoint  ///< -log(rate) in int64 fixed point (see fixedlog.h); sums and comparisons are exact.
+};
+
+/**
+ * @brief Which cycles the detector looks for.
+ */
+enum class DetectionMode {
+  Spfa,      ///< Negative cycles of any length over log weights.
+  Indexed    ///< Cycles from a precomputed index (see `set_cycle_index`), priced by multiplying raw rates; no logarithms per tick.
+};
 
 /**
  * @class ArbitrageGraph
@@ -14,14 +38,130 @@
  * It uses the Shortest Path Faster Algorithm (SPFA), an optimization of Bellman-Ford,
  * to detect negative weight cycles, which correspond to risk-free arbitrage
  * opportunities in the market.
+ *
+ * Pairs can be listed and delisted at runtime. Storage for up to `max_pairs` pairs
+ * and `max_currencies` currencies is allocated up front, so neither listing nor
+ * price updates ever reallocate; listing or delisting a pair only touches the
+ * adjacency lists of its two currencies. Pair and currency IDs are never reused
+ * for a different symbol: a delisted pair keeps its ID and gets it back if it is
+ * listed again, and a currency whose last pair is delisted stays as an isolated
+ * vertex.
+ *
+ * A pair can be given a quote time-to-live. Each edge carries the time its
+ * quote expires, and detection treats expired edges as absent with a single
+ * comparison against the latest update's receive time, so a pair that stops
+ * ticking cannot keep producing phantom cycles and nothing has to be swept.
+ * Expiry events are also queued on a timer wheel so callers can learn which
+ * pairs went stale through `expire_stale`.
+ *
+ * In `WeightMode::FixedPoint` every weight is an int64 count of 2^-40 log units
+ * and detection adds and compares integers only, so a cycle's verdict depends on
+ * the prices alone, not on the order its legs were summed in or on the platform. The reverse edge
+ * weighs +log(ask) rather than -log(1/ask), so a pair's two edges cancel exactly
+ * when bid equals ask.
+ *
+ * Given an EngineArena, every container the graph owns is carved from it, under
+ * the accounts "book" (edges), "graph" (adjacency and listing), "catalog",
+ * "cycle_index", "queues" (update queues and the expiry wheel) and "search"
+ * (SPFA distances and predecessors). Without one they use the heap.
  */
 class ArbitrageGraph {
 public:
   /**
    * @brief Constructs the graph with an initial set of trading symbols.
    * @param symbols A vector of strings representing trading pairs (e.g., "BTC-USD").
+   * @param max_pairs Pairs the graph can ever hold; 0 means no room beyond `symbols`.
+   * @param max_currencies Currencies the graph can ever hold; 0 means no room beyond `symbols`.
+   * @param arena Where the graph's containers are allocated, or nullptr for the heap; must outlive the graph.
+   */
+  ArbitrageGraph(const std::vector<std::string>& symbols, int max_pairs = 0, int max_currencies = 0,
+                 EngineArena* arena = nullptr);
+
+  /**
+   * @brief Lists a pair, creating IDs for any new currencies.
+   *
+   * Runtime listing is supported by the graph alone. `RiskManager` and `Inventory`
+   * accept the new IDs if they were sized for `currency_capacity()`. The simulator,
+   * the executor and the order gateway's encoders are sized from the catalog when
+   * they are built. They reject pairs registered after that: the simulator and
+   * the executor throw, and the gateway refuses the cycle.
+   *
+   * @param symbol A trading pair in "BASE-QUOTE" form.
+   * @return The pair ID (the previous one if the symbol was listed before).
+   * @throws std::runtime_error if the symbol is malformed or capacity would be exceeded.
+   */
+  int add_pair(const std::string& symbol);
+
+  /**
+   * @brief Delists a pair: its edges leave the graph and its last price is forgotten.
+   * @return False if the pair was not listed.
+   */
+  bool remove_pair(int pair_id);
+
+  /**
+   * @brief Sets how long a pair's quotes stay usable after they are received; 0 disables expiry.
+   * Takes effect from the pair's next price update.
+   * @return False if `pair_id` is not a registered pair or `ttl_ns` is negative.
+   */
+  bool set_pair_ttl(int pair_id, int64_t ttl_ns) {
+    if (pair_id < 0 || pair_id >= pair_catalog.num_pairs() || ttl_ns < 0) {
+      return false;
+    }
+    this->pair_ttl_ns[pair_id] = ttl_ns;
+    return true;
+  }
+
+  /**
+   * @brief Reports pairs whose quotes have expired by `now_ns` without being refreshed.
+   *
+   * Detection already ignores expired quotes; this only surfaces the events.
+   * Each expiry is reported once, within `EXPIRY_TICK_NS` of its deadline.
+   *
+   * @param expired_pairs Receives up to `max_out` pair IDs.
+   * @return Number of pair IDs written.
+   */
+  int expire_stale(int64_t now_ns, int* expired_pairs, int max_out);
+
+  /// @brief Number of expiry events seen by `expire_stale`.
+  uint64_t stale_pair_count() const { return stale_pairs; }
+
+  /// @brief True if the pair is currently listed.
+  bool is_listed(int pair_id) const { return listed[pair_id] != 0; }
+
+  int pair_capacity() const { return static_cast<int>(listed.size()); }
+  int currency_capacity() const { return static_cast<int>(adjacency_list.size()); }
+
+  /**
+   * @brief Switches the weight representation; existing prices are re-weighted.
+   */
+  void set_weight_mode(WeightMode mode);
+
+  WeightMode weight_mode() const { return mode; }
+
+  /**
+   * @brief Switches the detector; every priced pair is treated as updated.
+   *
+   * In `DetectionMode::Indexed` updates only store rates, and leaving the mode
+   * re-weighs every priced pair. The weight mode is ignored while it is active.
+   */
+  void set_detection_mode(DetectionMode detection);
+
+  DetectionMode detection_mode() const { return detection; }
+
+  /**
+   * @brief Chooses the cycles checked in `DetectionMode::Indexed`: every triangle, plus every
+   * simple cycle of 4 to `max_legs` legs through at least one of `anchor_currency_ids`.
+   *
+   * The index is rebuilt on the next detection. Each update then evaluates only the
+   * cycles through the updated pair's two edges, and listing or delisting a pair
+   * only adds or retires the cycles through it.
+   *
+   * @throws std::runtime_error if `max_legs` is not between 3 and `CycleIndex::MAX_CYCLE_LENGTH`.
    */
-  ArbitrageGraph(const std::vector<std::string>& symbols);
+  void set_cycle_index(int max_legs, const std::vector<int>& anchor_currency_ids);
+
+  /// @brief The indexed cycles for the current listing, built now if they are out of date.
+  const CycleIndex& indexed_cycles();
 
   /**
    * @brief Updates an edge's weight based on a new price tick.
@@ -31,11 +171,87 @@ public:
   void update_price(const std::string& symbol, double price);
 
   /**
-   * @brief Detects and returns an arbitrage cycle if one exists.
-   * @return An optional containing the cycle as a vector of currency strings,
-   * or nullopt if no opportunity is found.
+   * @brief Updates both edges of a pair from a new price tick, by pair ID.
+   * Updates for delisted pairs are ignored.
+   * @param pair_id The pair's ID in `catalog()`.
+   * @param price The new market price.
+   * @param exchange_ts_ns Exchange timestamp of the tick, copied into the next opportunity.
+   * @param receive_ts_ns Local receive timestamp of the tick, copied into the next opportunity.
+   */
+  void update_price(int pair_id, double price, int64_t exchange_ts_ns = 0, int64_t receive_ts_ns = 0);
+
+  /**
+   * @brief Updates a pair from its top of book: selling the base earns the bid,
+   * buying it costs the ask. Quotes with a non-positive side are ignored.
+   */
+  void update_quote(int pair_id, double bid, double ask, int64_t exchange_ts_ns = 0, int64_t receive_ts_ns = 0);
+
+  /**
+   * @brief Applies `count` top-of-book updates in order, all received at `receive_ts_ns`.
+   *
+   * Intended for callers that hold columns of quotes (the Python bindings, feature
+   * tools, snapshot loads after a reconnect); detection afterwards sees the final
+   * state of every pair. In `WeightMode::Double` the logs of each chunk of
+   * `UPDATE_BATCH` quotes are taken together by `log_batch`, so weights can differ
+   * from `update_quote`'s libm ones by an ULP or so; that is far inside
+   * `RELAXATION_EPSILON`. The reverse edge weighs log(ask), as in fixed point.
+   */
+  void update_quotes(const int32_t* pair_ids, const double* bids, const double* asks, size_t count,
+                     int64_t receive_ts_ns = 0);
+
+  /**
+   * @brief Detects an arbitrage cycle, if one exists, and writes it into `out`.
+   *
+   * With an inventory attached, the cycle is rotated to start from the held currency
+   * with the most capacity, and cycles through no held currency are dropped.
+   *
+   * @param out Receives the cycle; left unspecified if none is found.
+   * @return True if an opportunity was written to `out`.
+   */
+  bool find_arbitrage_cycle(Opportunity& out);
+
+  /**
+   * @brief Writes the most profitable indexed cycle in the whole market into `out`, if it clears the hurdle.
+   *
+   * In `DetectionMode::Indexed` every cycle is kept ranked by its margin; each
+   * detection re-ranks the cycles it evaluates, so the ranking reflects updates up
+   * to the last `find_arbitrage_cycle`. The best cycle is then read off the top,
+   * after re-checking it against the current quotes (an expired leg can only have
+   * lowered it). With an inventory attached, the cycle starts from its best held
+   * currency. If none of its currencies is held, it counts towards
+   * `pruned_cycle_count()` like any untradeable cycle and nothing is returned,
+   * even if a lower-ranked cycle could be traded.
+   *
+   * @return False outside `DetectionMode::Indexed`, if no cycle is profitable, or
+   * if the most profitable one cannot be started from inventory.
+   */
+  bool best_indexed_cycle(Opportunity& out);
+
+  /**
+   * @brief The pair and currency IDs used by the graph's vertices.
+   *
+   * Components that index state by currency (risk, inventory, execution) should
+   * use these IDs. They match any other PairCatalog built from the same symbol list.
+   */
+  const PairCatalog& catalog() const { return pair_catalog; }
+
+  /**
+   * @brief Attaches the balances used to choose where cycles start (nullptr detaches).
+   * The inventory must be indexed by this graph's currency IDs.
    */
-  std::optional<std::vector<std::string>> find_arbitrage_cycle();
+  void set_inventory(const Inventory* inventory) { this->inventory = inventory; }
+
+  /// @brief Number of detected cycles dropped because no currency in them is held,
+  /// or because they have more than `Opportunity::MAX_LEGS` legs.
+  uint64_t pruned_cycle_count() const { return pruned_cycles; }
+
+  /**
+   * @brief Log of the rate product around a cycle at current prices.
+   * @param cycle Currency IDs in trading order, without the start repeated at the end.
+   * @param length Number of currencies in the cycle.
+   * @return The log-profit, or -infinity if any leg has not been priced yet.
+   */
+  double cycle_log_profit(const int* cycle, int length) const;
 
 private:
   /**
@@ -43,55 +259,168 @@ private:
    * @brief Represents a directed edge in the graph.
    */
   struct Edge {
+      int source_id;
       int destination_id;
       double weight;
+      /// @brief The weight in fixed-point log units; maintained in `WeightMode::FixedPoint` only.
+      int64_t fixed_weight;
+      double rate;
+      /// @brief Receive time after which the quote is ignored.
+      int64_t expires_ns;
   };
 
   // --- Graph Structure ---
   
-  /// @brief Adjacency list representation of the graph.
-  std::vector<std::vector<Edge>> adjacency_list;
-  
-  /// @brief Maps currency string names to their unique integer IDs.
-  std::unordered_map<std::string, int> currency_to_id;
-  
-  /// @brief Maps unique integer IDs back to their currency string names.
-  std::vector<std::string> id_to_currency;
+  /// @brief Every edge, indexed by edge slot (see `Opportunity`); two per pair, sized for capacity.
+  std::pmr::vector<Edge> edges;
+
+  /// @brief Slots of each vertex's outgoing edges on listed pairs; unpriced edges weigh +infinity.
+  std::pmr::vector<std::pmr::vector<uint32_t>> adjacency_list;
+
+  /// @brief Listing state of every pair ID up to capacity.
+  std::pmr::vector<uint8_t> listed;
+
+  WeightMode mode = WeightMode::Double;
+
+  // --- Indexed Cycles ---
+
+  DetectionMode detection = DetectionMode::Spfa;
+
+  /// @brief The cycles checked in `DetectionMode::Indexed`; built on first use, then kept up to date as pairs
+  /// are listed and delisted.
+  CycleIndex cycle_index;
+  bool cycle_index_stale = true;
+  int cycle_max_legs = 3;
+  std::vector<int> cycle_anchors;
+
+  /// @brief Pairs updated since the last detection, each once, with their membership flags by pair ID.
+  std::pmr::vector<int> updated_pairs;
+  std::pmr::vector<uint8_t> pair_updated;
+
+  /// @brief Fixed-point weight of an unpriced edge: never relaxes, and cannot overflow when added to a distance.
+  static constexpr int64_t UNPRICED_FIXED_WEIGHT = INT64_MAX / 4;
+
+  // --- Quote Expiry ---
+
+  /// @brief Width and number of timer wheel buckets; deadlines beyond one revolution wait extra laps.
+  static constexpr int64_t EXPIRY_TICK_NS = 1000000;
+  static constexpr int EXPIRY_WHEEL_SLOTS = 1024;
+
+  /// @brief Quote time-to-live of every pair ID, 0 for none.
+  std::pmr::vector<int64_t> pair_ttl_ns;
+
+  /// @brief One pending expiry per pair, keyed by pair ID.
+  TimerWheel expiry_wheel;
+
+  uint64_t stale_pairs = 0;
   
-  /// @brief Provides O(1) lookup for edge weights to avoid linear scans.
-  std::unordered_map<uint64_t, size_t> edge_index_map;
+  /// @brief Maps symbols and currency names to their unique integer IDs and back.
+  PairCatalog pair_catalog;
+
+  /// @brief Timestamps of the most recent price update.
+  int64_t last_exchange_ts_ns = 0;
+  int64_t last_receive_ts_ns = 0;
 
   // --- SPFA Algorithm Data ---
   
-  /// @brief The total number of unique currencies (vertices) in the graph.
+  /// @brief The number of currencies (vertices) currently in the graph.
   int num_vertices = 0;
   
   /// @brief Stores the shortest distance from the source to each vertex.
-  std::vector<double> distance;
+  std::pmr::vector<double> distance;
+
+  /// @brief `distance` in fixed-point units, used in `WeightMode::FixedPoint`.
+  std::pmr::vector<int64_t> fixed_distance;
   
-  /// @brief Stores the predecessor of each vertex in the shortest path tree.
-  std::vector<int> predecessor;
+  /// @brief Slot of the edge into each vertex in the shortest path tree, or -1.
+  std::pmr::vector<int> predecessor;
   
-  /// @brief Counts updates to each vertex's distance to detect negative cycles.
-  std::vector<int> update_counts;
+  /// @brief Quotes gathered per `log_batch` call in `update_quotes`.
+  static constexpr size_t UPDATE_BATCH = 256;
+
+  /// @brief Minimum distance improvement that counts as a relaxation.
+  static constexpr double RELAXATION_EPSILON = 1e-12;
+
+  /// @brief The same margin in fixed-point units: one unit of rounding per leg of the longest reportable cycle.
+  static constexpr int64_t FIXED_RELAXATION_EPSILON = Opportunity::MAX_LEGS;
+
+  /// @brief Number of edges on each vertex's current shortest path, to detect negative cycles.
+  std::pmr::vector<int> update_counts;
   
   /// @brief Queue of vertices whose distances have been updated, for SPFA optimization.
-  std::deque<int> dirty_vertices;
+  std::pmr::deque<int> dirty_vertices;
+
+  // --- Execution Context ---
+
+  /// @brief Balances that decide the start of each cycle, if attached.
+  const Inventory* inventory = nullptr;
+
+  uint64_t pruned_cycles = 0;
 
   // --- Private Helper Functions ---
 
   /**
-   * @brief Creates a unique 64-bit key for a directed edge.
-   * @param source_id The integer ID of the source vertex.
-   * @param destination_id The integer ID of the destination vertex.
-   * @return A unique 64-bit integer key.
+   * @brief Adds a pair's two edges to the adjacency lists, unpriced, and its cycles to a built index.
+   */
+  void attach_pair(int pair_id);
+
+  void rerank_pair_cycles(int pair_id);
+
+  /**
+   * @brief Sets a pair's edge rates and weights from its bid and ask.
+   */
+  void weigh_pair(int pair_id, double bid, double ask);
+
+  /**
+   * @brief Stamps a freshly weighed pair's quote expiry.
+   */
+  void stamp_pair(int pair_id, int64_t receive_ts_ns);
+
+  /**
+   * @brief Queues a pair for the next detection: its source vertices for SPFA, the pair itself for indexed cycles.
+   */
+  void mark_updated(int pair_id);
+
+  /**
+   * @brief Checks the indexed cycles through every updated pair and writes the most profitable one into `out`.
+   * @return True if a cycle cleared the hurdle and was written.
+   */
+  bool find_indexed_cycle(Opportunity& out);
+
+  /**
+   * @brief A margin as ranked in the cycle index: unprofitable cycles all tie at 0,
+   * so re-ranking only moves cycles that clear, or have just stopped clearing, the hurdle.
+   */
+  static double rank_key(double margin) { return margin > 0.0 ? margin : 0.0; }
+
+  /**
+   * @brief Writes an indexed cycle into `out` at current rates, starting from leg `first_leg`.
+   */
+  void write_indexed_cycle(int cycle, int first_leg, Opportunity& out) const;
+
+  /**
+   * @brief How far a cycle's rate product exceeds `hurdle`; expired legs count as rate 0.
+   */
+  double cycle_margin(int cycle, double hurdle, int64_t now_ns) const;
+
+  /**
+   * @brief Finds the slot of the priced edge from `source_id` to `destination_id`.
+   * @return The edge slot, or -1 if no pair links them or the edge is unpriced.
+   */
+  int find_edge(int source_id, int destination_id) const;
+
+  /**
+   * @brief Runs SPFA from a virtual source over `dist`, reading each edge's weight through `weight_of`.
+   * @return True if a cycle was found and written to `out`.
    */
-  uint64_t create_edge_key(int source_id, int destination_id) const;
+  template <typename Weight, typename WeightOf>
+  bool find_negative_cycle(std::pmr::vector<Weight>& dist, WeightOf weight_of, Weight epsilon, Opportunity& out);
 
   /**
-   * @brief Reconstructs the arbitrage cycle path from the predecessor list.
+   * @brief Reconstructs the arbitrage cycle from the predecessor edges.
    * @param start_node A node within the detected negative cycle.
-   * @return A vector of currency strings representing the arbitrage path.
+   * @param out Receives the cycle.
+   * @return False if the cycle was pruned.
    */
-  std::vector<std::string> reconstruct_cycle(int start_node) const;
+  bool reconstruct_cycle(int start_node, Opportunity& out);
 };
\ No newline at end of file
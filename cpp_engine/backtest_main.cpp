@@ -0,0 +1,231 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "backtester.h"
+#include "feedlatency.h"
+#include "lifetimeanalytics.h"
+#include "tickarchive.h"
+
+/**
+ * @brief Builds the default sweep: expected-return threshold x order latency x latency penalty.
+ */
+std::vector<BacktestConfig> default_sweep() {
+  const double min_return_bps[] = {0.0, 2.0, 5.0, 10.0, 20.0};
+  const double median_latency_us[] = {50.0, 100.0, 250.0, 500.0, 1000.0};
+  const double penalty_bps_per_ms[] = {0.0, 1.0, 5.0, 10.0};
+
+  std::vector<BacktestConfig> configs;
+  for (double min_return : min_return_bps) {
+    for (double latency : median_latency_us) {
+      for (double penalty : penalty_bps_per_ms) {
+        BacktestConfig config;
+        config.name = "ret>=" + std::to_string(static_cast<int>(min_return)) + "bps lat=" +
+                      std::to_string(static_cast<int>(latency)) + "us pen=" +
+                      std::to_string(static_cast<int>(penalty)) + "bps/ms";
+        config.simulator.order_latency = {LatencyDistribution::LogNormal, latency * 1000.0, 0.5};
+        config.simulator.report_latency = {LatencyDistribution::LogNormal, latency * 1000.0, 0.5};
+        config.simulator.synthetic_half_spread_bps = 1.0;
+        config.simulator.taker_fee_bps = 5.0;
+        config.fee_bps_per_leg = 5.0;
+        config.min_expected_return_bps = min_return;
+        config.latency_penalty_bps_per_ms = penalty;
+        configs.push_back(config);
+      }
+    }
+  }
+  return configs;
+}
+
+int convert_capture(const std::string& csv_path, const std::string& archive_path) {
+  TickArchive capture;
+  capture.open(csv_path);
+
+  TickArchiveWriter writer(archive_path, capture.symbols());
+  for (const TickRecord& record : capture) {
+    writer.append(record);
+  }
+  std::cout << "Wrote " << capture.size() << " ticks to " << archive_path << std::endl;
+  if (capture.skipped_rows() > 0) {
+    std::cout << "Skipped " << capture.skipped_rows() << " malformed rows" << std::endl;
+  }
+  return 0;
+}
+
+/**
+ * @brief Prints opportunity lifetimes per hour, the survival curve and the most frequent cycles.
+ */
+int report_lifetimes(const TickArchive& archive, unsigned num_threads) {
+  auto start = std::chrono::steady_clock::now();
+  LifetimeReport report = LifetimeAnalyzer(archive).run(LifetimeConfig(), num_threads);
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  std::printf("%-6s %12s %10s %10s %10s %14s\n", "hour", "opportunities", "p50(us)", "p90(us)", "p99(us)",
+              "mean peak(bps)");
+  for (int h = 0; h < 24; h++) {
+    const HourLifetimeStats& hour = report.hours[h];
+    if (hour.occurrences == 0) {
+      continue;
+    }
+    std::printf("%02d:00  %12zu %10.0f %10.0f %10.0f %14.2f\n", h, hour.occurrences,
+                hour.durations.quantile_ns(0.5) / 1000.0, hour.durations.quantile_ns(0.9) / 1000.0,
+                hour.durations.quantile_ns(0.99) / 1000.0, hour.peak_log_profit_sum / hour.occurrences * 1e4);
+  }
+
+  std::printf("\nStill open after:");
+  for (int64_t micros : {10, 50, 100, 250, 500, 1000, 5000, 10000, 100000}) {
+    std::printf("  %ldus %.1f%%", static_cast<long>(micros), report.all.survival(micros * 1000) * 100.0);
+  }
+  std::printf("\n\n");
+
+  std::vector<const CycleLifetimeStats*> cycles;
+  for (const auto& entry : report.cycles) {
+    cycles.push_back(&entry.second);
+  }
+  std::sort(cycles.begin(), cycles.end(), [](const CycleLifetimeStats* a, const CycleLifetimeStats* b) {
+    return a->occurrences > b->occurrences;
+  });
+
+  const PairCatalog& catalog = archive.catalog();
+  std::printf("%-28s %10s %9s %10s %10s %14s  %s\n", "cycle", "count", "censored", "p50(us)", "p99(us)",
+              "max peak(bps)", "most often closed by");
+  for (size_t c = 0; c < std::min<size_t>(cycles.size(), 20); c++) {
+    const CycleLifetimeStats& stats = *cycles[c];
+    std::string path;
+    for (int id : stats.currency_ids) {
+      path += catalog.currency_name(id) + " ";
+    }
+    path += catalog.currency_name(stats.currency_ids.front());
+    size_t closer = std::max_element(stats.closed_by_pair.begin(), stats.closed_by_pair.end()) -
+                    stats.closed_by_pair.begin();
+    std::printf("%-28s %10zu %9zu %10.0f %10.0f %14.2f  %s\n", path.c_str(), stats.occurrences, stats.censored,
+                stats.durations.quantile_ns(0.5) / 1000.0, stats.durations.quantile_ns(0.99) / 1000.0,
+                stats.peak_log_profit_max * 1e4, stats.occurrences == 0 ? "-" : catalog.symbol(closer).c_str());
+  }
+  std::printf("%zu ticks, %zu distinct cycles in %.2fs\n", report.ticks, report.cycles.size(), elapsed);
+  return 0;
+}
+
+/**
+ * @brief Measures per-pair feed delay (receive minus exchange time) over the archive, prints it and exports it.
+ */
+int report_feed_delays(const TickArchive& archive, const std::string& export_path) {
+  FeedDelayMonitor monitor(static_cast<int>(archive.symbols().size()));
+  for (const TickRecord& tick : archive) {
+    monitor.record(static_cast<int>(tick.pair_id), tick.exchange_ts_ns, tick.receive_ts_ns);
+  }
+
+  std::printf("%-12s %10s %9s %10s %10s %10s %10s %10s\n", "pair", "samples", "negative", "mean(us)", "ewma(us)",
+              "p50(us)", "p99(us)", "max(us)");
+  for (int pair_id = 0; pair_id < monitor.num_pairs(); pair_id++) {
+    const FeedDelayStats& stats = monitor.stats(pair_id);
+    std::printf("%-12s %10llu %9llu %10.1f %10.1f %10.1f %10.1f %10.1f\n", archive.symbols()[pair_id].c_str(),
+                static_cast<unsigned long long>(stats.feed.total),
+                static_cast<unsigned long long>(stats.negative_feed), stats.feed_mean_ns() / 1000.0,
+                stats.feed_ewma_ns / 1000.0, stats.feed.quantile_ns(0.5) / 1000.0,
+                stats.feed.quantile_ns(0.99) / 1000.0, stats.feed_max_ns / 1000.0);
+  }
+  monitor.write_csv(export_path, archive.symbols());
+  std::cout << "Wrote feed delays to " << export_path << std::endl;
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  if (argc == 4 && std::strcmp(argv[1], "--convert") == 0) {
+    return convert_capture(argv[2], argv[3]);
+  }
+
+  if (argc < 2) {
+    std::cerr << "Usage: " << argv[0] << " <archive> [--threads N] [--per-day] [--dedup-ms GAP] [--ttl-ms TTL]"
+              << " [--fixed-point] [--triangles] [--cycle-legs N --anchors A,B] [--arena]"
+              << " [--lifetimes]\n"
+              << "       " << argv[0] << " <archive> --feed-delays <delays.csv>\n"
+              << "       " << argv[0] << " --convert <capture.csv> <archive.bin>" << std::endl;
+    return 1;
+  }
+
+  unsigned num_threads = 0;
+  bool per_day = false;
+  double dedup_gap_ms = 0.0;
+  bool lifetimes = false;
+  double ttl_ms = 0.0;
+  std::string feed_delay_path;
+  bool fixed_point = false;
+  bool triangles = false;
+  int cycle_legs = 3;
+  std::vector<std::string> anchors;
+  bool arena = false;
+  for (int i = 2; i < argc; i++) {
+    if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      num_threads = static_cast<unsigned>(std::stoul(argv[++i]));
+    } else if (std::strcmp(argv[i], "--per-day") == 0) {
+      per_day = true;
+    } else if (std::strcmp(argv[i], "--dedup-ms") == 0 && i + 1 < argc) {
+      dedup_gap_ms = std::stod(argv[++i]);
+    } else if (std::strcmp(argv[i], "--ttl-ms") == 0 && i + 1 < argc) {
+      ttl_ms = std::stod(argv[++i]);
+    } else if (std::strcmp(argv[i], "--fixed-point") == 0) {
+      fixed_point = true;
+    } else if (std::strcmp(argv[i], "--triangles") == 0) {
+      triangles = true;
+    } else if (std::strcmp(argv[i], "--cycle-legs") == 0 && i + 1 < argc) {
+      cycle_legs = std::stoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--anchors") == 0 && i + 1 < argc) {
+      std::stringstream list(argv[++i]);
+      std::string anchor;
+      while (std::getline(list, anchor, ',')) {
+        anchors.push_back(anchor);
+      }
+    } else if (std::strcmp(argv[i], "--arena") == 0) {
+      arena = true;
+    } else if (std::strcmp(argv[i], "--lifetimes") == 0) {
+      lifetimes = true;
+    } else if (std::strcmp(argv[i], "--feed-delays") == 0 && i + 1 < argc) {
+      feed_delay_path = argv[++i];
+    }
+  }
+
+  TickArchive archive;
+  archive.open(argv[1], num_threads);
+  std::cout << "Loaded " << archive.size() << " ticks over " << archive.symbols().size() << " pairs" << std::endl;
+  if (archive.skipped_rows() > 0) {
+    std::cout << "Skipped " << archive.skipped_rows() << " malformed rows" << std::endl;
+  }
+
+  if (!feed_delay_path.empty()) {
+    return report_feed_delays(archive, feed_delay_path);
+  }
+  if (lifetimes) {
+    return report_lifetimes(archive, num_threads);
+  }
+
+  std::vector<BacktestConfig> configs = default_sweep();
+  for (BacktestConfig& config : configs) {
+    config.dedup_live_gap_ns = static_cast<int64_t>(dedup_gap_ms * 1e6);
+    config.dedup_min_improvement_bps = 1.0;
+    config.quote_ttl_ns = static_cast<int64_t>(ttl_ms * 1e6);
+    config.weight_mode = fixed_point ? WeightMode::FixedPoint : WeightMode::Double;
+    config.detection_mode = triangles || cycle_legs > 3 ? DetectionMode::Indexed : DetectionMode::Spfa;
+    config.cycle_max_legs = cycle_legs;
+    config.cycle_anchors = anchors;
+    config.engine_arena = arena;
+  }
+  auto start = std::chrono::steady_clock::now();
+  std::vector<BacktestResult> results = Backtester(archive).run(configs, num_threads, per_day);
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  std::printf("%-36s %10s %10s %8s %8s %8s %12s %10s %10s\n",
+              "config", "detections", "suppressed", "stale", "sent", "hit", "pnl", "p50(us)", "p99(us)");
+  for (const BacktestResult& result : results) {
+    std::printf("%-36s %10zu %10zu %8zu %8zu %7.1f%% %12.4f %10.1f %10.1f\n",
+                result.name.c_str(), result.detections, result.suppressed, result.stale_quotes, result.cycles_sent, result.hit_rate() * 100.0,
+                result.pnl, result.latency_quantile(0.5) / 1000.0, result.latency_quantile(0.99) / 1000.0);
+  }
+  std::printf("%zu configurations in %.2fs\n", configs.size(), elapsed);
+  return 0;
+}
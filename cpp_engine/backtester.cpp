@@ -0,0 +1,253 @@
+/**
+ * @file backtester.cpp
+ * @brief Implements the parallel, event-driven backtest driver.
+ *
+ * @details
+ * Each job replays its slice of the archive through the same sequence the live
+ * logic thread uses: advance the simulator to the tick's time (so orders that
+ * arrived earlier match against the book they would have seen), apply the tick
+ * to the book and graph, then detect, deduplicate, score and execute. Repeat
+ * detections of a still-live cycle are dropped before scoring unless their
+ * profit has improved by the configured margin. The scorer is a
+ * threshold on expected return net of fees, raised by a latency penalty
+ * proportional to the median of the configured order latency.
+ */
+
+#include "backtester.h"
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+
+#include "arbitragegraph.h"
+#include "cycleexecution.h"
+#include "enginearena.h"
+#include "inventory.h"
+#include "opportunitytracker.h"
+#include "parallel.h"
+
+namespace {
+
+const int64_t NANOS_PER_DAY = 86400LL * 1000000000LL;
+
+/// @brief How long after the last tick the simulator keeps running so in-flight cycles resolve.
+const int64_t DRAIN_HORIZON_NS = 10LL * 1000000000LL;
+
+/// @brief Distinct cycles the deduplication table can hold at once.
+const size_t TRACKER_CAPACITY = 4096;
+
+/**
+ * @brief Median of a latency distribution, used by the latency gate.
+ */
+double median_latency_ms(const LatencyModel& model) {
+  switch (model.distribution) {
+    case LatencyDistribution::Uniform:
+      return 0.5 * (model.param_a + model.param_b) * 1e-6;
+    case LatencyDistribution::Constant:
+    case LatencyDistribution::LogNormal:
+      break;
+  }
+  return model.param_a * 1e-6;
+}
+
+}
+
+int64_t BacktestResult::latency_quantile(double q) const {
+  if (tick_to_fill_ns.empty()) {
+    return 0;
+  }
+  size_t index = static_cast<size_t>(q * (tick_to_fill_ns.size() - 1) + 0.5);
+  return tick_to_fill_ns[std::min(index, tick_to_fill_ns.size() - 1)];
+}
+
+void BacktestResult::merge(const BacktestResult& other) {
+  ticks += other.ticks;
+  detections += other.detections;
+  suppressed += other.suppressed;
+  stale_quotes += other.stale_quotes;
+  cycles_sent += other.cycles_sent;
+  cycles_completed += other.cycles_completed;
+  pnl += other.pnl;
+  tick_to_fill_ns.insert(tick_to_fill_ns.end(), other.tick_to_fill_ns.begin(), other.tick_to_fill_ns.end());
+}
+
+/**
+ * @brief Replays records [first, last) through a fresh engine instance.
+ */
+BacktestResult Backtester::run_range(const BacktestConfig& config, size_t first, size_t last) const {
+  const PairCatalog& catalog = archive.catalog();
+  const std::vector<std::string>& symbols = archive.symbols();
+
+  int valuation_id = catalog.find_currency(config.valuation_currency);
+  if (valuation_id < 0) {
+    throw std::runtime_error("Valuation currency '" + config.valuation_currency + "' is not traded in the archive");
+  }
+
+  std::unique_ptr<EngineArena> arena;
+  if (config.engine_arena) {
+    arena = std::make_unique<EngineArena>();
+  }
+  ArbitrageGraph graph(symbols, 0, 0, arena.get());
+  graph.set_weight_mode(config.weight_mode);
+  graph.set_detection_mode(config.detection_mode);
+  std::vector<int> anchor_ids;
+  for (const std::string& anchor : config.cycle_anchors) {
+    int currency_id = catalog.find_currency(anchor);
+    if (currency_id < 0) {
+      throw std::runtime_error("Cycle anchor '" + anchor + "' is not traded in the archive");
+    }
+    anchor_ids.push_back(currency_id);
+  }
+  graph.set_cycle_index(config.cycle_max_legs, anchor_ids);
+  if (config.quote_ttl_ns > 0) {
+    for (int pair_id = 0; pair_id < catalog.num_pairs(); pair_id++) {
+      graph.set_pair_ttl(pair_id, config.quote_ttl_ns);
+    }
+  }
+  ExchangeSimulator simulator(catalog, config.simulator);
+  CycleExecutor executor(catalog, simulator, valuation_id, config.notional, config.limit_tolerance_bps);
+
+  Inventory inventory(catalog.num_currencies());
+  bool track_inventory = !config.starting_balances.empty();
+  if (track_inventory) {
+    for (const auto& [currency, amount] : config.starting_balances) {
+      int currency_id = catalog.find_currency(currency);
+      if (currency_id < 0) {
+        throw std::runtime_error("Starting balance in '" + currency + "', which is not traded in the archive");
+      }
+      inventory.set_balance(currency_id, amount);
+    }
+    graph.set_inventory(&inventory);
+    executor.set_inventory(&inventory);
+  }
+
+  bool dedup = config.dedup_live_gap_ns > 0;
+  OpportunityTracker tracker(dedup ? TRACKER_CAPACITY : 0, config.dedup_live_gap_ns,
+                             config.dedup_min_improvement_bps * 1e-4);
+
+  double required_bps = config.min_expected_return_bps +
+                        config.latency_penalty_bps_per_ms * median_latency_ms(config.simulator.order_latency);
+
+  BacktestResult result;
+  result.name = config.name;
+
+  auto drain_fills = [&]() {
+    Fill fill;
+    CycleResult cycle_result;
+    while (simulator.poll_fill(fill)) {
+      if (executor.on_fill(fill, cycle_result)) {
+        result.cycles_completed += cycle_result.complete ? 1 : 0;
+        result.pnl += cycle_result.realised_pnl;
+        result.tick_to_fill_ns.push_back(cycle_result.tick_to_fill_ns());
+      }
+    }
+  };
+
+  Opportunity opportunity;
+  int64_t last_ts = 0;
+  for (size_t i = first; i < last; i++) {
+    const TickRecord& tick = archive[i];
+    int64_t ts = tick.receive_ts_ns;
+    last_ts = ts;
+    result.ticks++;
+
+    simulator.advance_to(ts);
+    drain_fills();
+
+    int pair_id = static_cast<int>(tick.pair_id);
+    switch (tick.kind) {
+      case TickKind::Trade:
+        simulator.on_trade(pair_id, tick.price, tick.quantity, ts);
+        break;
+      case TickKind::BestBid:
+        simulator.on_top_of_book(pair_id, OrderSide::Buy, tick.price, tick.quantity, ts);
+        continue;
+      case TickKind::BestAsk:
+        simulator.on_top_of_book(pair_id, OrderSide::Sell, tick.price, tick.quantity, ts);
+        continue;
+    }
+
+    if (track_inventory) {
+      for (int currency_id : {catalog.base_id(pair_id), catalog.quote_id(pair_id)}) {
+        inventory.set_mark(currency_id, simulator.convert(1.0, currency_id, valuation_id));
+      }
+    }
+
+    /* The graph is driven by trade prints only */
+    graph.update_price(pair_id, tick.price, tick.exchange_ts_ns, ts);
+    if (config.quote_ttl_ns > 0) {
+      graph.expire_stale(ts, nullptr, 0);
+    }
+
+    if (!graph.find_arbitrage_cycle(opportunity)) {
+      continue;
+    }
+    result.detections++;
+
+    if (dedup) {
+      /* Entries of cycles that stopped appearing are only freed by a sweep, run at most once per live gap */
+      tracker.expire_if_due(ts, nullptr, 0);
+      TrackVerdict verdict = tracker.observe(opportunity.currency_ids, opportunity.num_legs,
+                                             opportunity.log_profit, ts);
+      if (verdict == TrackVerdict::Suppressed) {
+        result.suppressed++;
+        continue;
+      }
+    }
+
+    if (!executor.plan(opportunity, ts + config.decision_latency_ns)) {
+      continue;
+    }
+
+    double expected_bps = executor.planned_return() * 1e4 - config.fee_bps_per_leg * opportunity.num_legs;
+    if (expected_bps < required_bps) {
+      continue;
+    }
+
+    if (executor.submit_planned(ts)) {
+      result.cycles_sent++;
+    }
+  }
+
+  simulator.advance_to(last_ts + DRAIN_HORIZON_NS);
+  drain_fills();
+  graph.expire_stale(last_ts, nullptr, 0);
+  result.stale_quotes = graph.stale_pair_count();
+  return result;
+}
+
+std::vector<BacktestResult> Backtester::run(const std::vector<BacktestConfig>& configs, unsigned num_threads,
+                                            bool split_by_day) const {
+  /* Slice the archive into [first, last) ranges; records are in time order */
+  std::vector<std::pair<size_t, size_t>> ranges;
+  if (!split_by_day) {
+    ranges.push_back({0, archive.size()});
+  } else {
+    size_t first = 0;
+    for (size_t i = 1; i <= archive.size(); i++) {
+      if (i == archive.size() ||
+          archive[i].receive_ts_ns / NANOS_PER_DAY != archive[first].receive_ts_ns / NANOS_PER_DAY) {
+        ranges.push_back({first, i});
+        first = i;
+      }
+    }
+  }
+
+  size_t num_jobs = configs.size() * ranges.size();
+  std::vector<BacktestResult> job_results(num_jobs);
+
+  parallel_for(num_jobs, num_threads, [&](size_t job) {
+    const auto& range = ranges[job % ranges.size()];
+    job_results[job] = run_range(configs[job / ranges.size()], range.first, range.second);
+  });
+
+  std::vector<BacktestResult> results(configs.size());
+  for (size_t c = 0; c < configs.size(); c++) {
+    results[c].name = configs[c].name;
+    for (size_t r = 0; r < ranges.size(); r++) {
+      results[c].merge(job_results[c * ranges.size() + r]);
+    }
+    std::sort(results[c].tick_to_fill_ns.begin(), results[c].tick_to_fill_ns.end());
+  }
+  return results;
+}
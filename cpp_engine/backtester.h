@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "arbitragegraph.h"
+#include "exchangesimulator.h"
+#include "tickarchive.h"
+
+/**
+ * @struct BacktestConfig
+ * @brief One parameter set for an independent engine instance.
+ */
+struct BacktestConfig {
+  std::string name;
+  SimulatorConfig simulator;
+  std::string valuation_currency = "USD";
+  double notional = 1000.0;
+  double limit_tolerance_bps = 2.0;
+  /// @brief Time from the triggering tick to the orders leaving the engine.
+  int64_t decision_latency_ns = 0;
+  /// @brief Balances held at the start; if empty, cycles start anywhere and are sized by notional only.
+  std::vector<std::pair<std::string, double>> starting_balances;
+
+  /// @brief How long a pair's last trade stays usable for detection; 0 keeps it forever.
+  int64_t quote_ttl_ns = 0;
+  /// @brief Edge weight representation used by the detector.
+  WeightMode weight_mode = WeightMode::Double;
+  /// @brief Cycles the detector looks for.
+  DetectionMode detection_mode = DetectionMode::Spfa;
+  /// @brief Longest indexed cycle in `DetectionMode::Indexed`; cycles over 3 legs must pass through an anchor.
+  int cycle_max_legs = 3;
+  std::vector<std::string> cycle_anchors;
+  /// @brief Carve the detector from its own EngineArena, mapped on the worker thread that runs it.
+  bool engine_arena = false;
+
+  // --- Scorer ---
+
+  /// @brief Fee assumed per leg when scoring an opportunity.
+  double fee_bps_per_leg = 0.0;
+  /// @brief Minimum expected return, net of fees, for a cycle to be sent.
+  double min_expected_return_bps = 0.0;
+  /// @brief Extra return demanded per millisecond of expected order latency (the latency gate).
+  double latency_penalty_bps_per_ms = 0.0;
+
+  // --- Deduplication ---
+
+  /// @brief Longest gap between detections of a cycle for it to count as the same opportunity; 0 disables.
+  int64_t dedup_live_gap_ns = 0;
+  /// @brief Improvement in expected return needed to re-score a cycle that is still live.
+  double dedup_min_improvement_bps = 0.0;
+};
+
+/**
+ * @struct BacktestResult
+ * @brief Aggregate outcome of one configuration.
+ */
+struct BacktestResult {
+  std::string name;
+  size_t ticks = 0;
+  size_t detections = 0;
+  /// @brief Detections dropped as repeats of a still-live opportunity.
+  size_t suppressed = 0;
+  /// @brief Times a pair went longer than the quote TTL without a trade.
+  size_t stale_quotes = 0;
+  size_t cycles_sent = 0;
+  size_t cycles_completed = 0;
+  double pnl = 0.0;
+  /// @brief Tick-to-fill latency of every sent cycle, sorted once the run is finished.
+  std::vector<int64_t> tick_to_fill_ns;
+
+  /// @brief Fraction of sent cycles whose legs all filled.
+  double hit_rate() const { return cycles_sent == 0 ? 0.0 : static_cast<double>(cycles_completed) / cycles_sent; }
+
+  /// @brief Tick-to-fill quantile in [0, 1], or 0 if nothing was sent.
+  int64_t latency_quantile(double q) const;
+
+  void merge(const BacktestResult& other);
+};
+
+/**
+ * @class Backtester
+ * @brief Replays one tick archive through many independent engine instances in parallel.
+ *
+ * Each job owns its own graph, scorer, executor and simulator and only reads the
+ * shared archive, so jobs need no synchronisation. A job is one configuration
+ * over the whole archive, or over a single UTC day when `split_by_day` is set;
+ * per-day results are merged back into one result per configuration.
+ */
+class Backtester {
+public:
+  explicit Backtester(const TickArchive& archive) : archive(archive) {}
+
+  /**
+   * @brief Runs every configuration and returns their results in the same order.
+   * @param num_threads Worker threads; 0 means one per hardware thread.
+   * @param split_by_day Run each UTC day as a separate job with a cold engine.
+   */
+  std::vector<BacktestResult> run(const std::vector<BacktestConfig>& configs, unsigned num_threads,
+                                  bool split_by_day = false) const;
+
+private:
+  const TickArchive& archive;
+
+  BacktestResult run_range(const BacktestConfig& config, size_t first, size_t last) const;
+};
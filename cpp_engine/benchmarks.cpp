@@ -0,0 +1,708 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "arbitragegraph.h"
+#include "concurrentqueue.h"
+#include "clock.h"
+#include "enginearena.h"
+#include "fastlog.h"
+#include "fixedlog.h"
+#include "multicastring.h"
+#include "parallel.h"
+#include "riskmanager.h"
+#include "tickarchive.h"
+#include "waitstrategy.h"
+
+/**
+ * @brief Runs `body` `iterations` times and prints the mean cost per call.
+ */
+template <typename Body>
+void report(const char* name, size_t iterations, Body&& body) {
+  int64_t start = steady_now_ns();
+  for (size_t i = 0; i < iterations; i++) {
+    body(i);
+  }
+  int64_t elapsed = steady_now_ns() - start;
+  std::printf("%-44s %10.1f ns/op\n", name, static_cast<double>(elapsed) / iterations);
+}
+
+/**
+ * @brief A three-leg USD -> BTC -> ETH -> USD cycle over currency IDs 0, 1, 2.
+ */
+CycleRiskRequest triangle_request(double usd_amount, int64_t now_ns) {
+  CycleRiskRequest request;
+  request.num_legs = 3;
+  request.notional = usd_amount;
+  request.now_ns = now_ns;
+  request.legs[0] = {0, usd_amount, 1, usd_amount / 60000.0};
+  request.legs[1] = {1, usd_amount / 60000.0, 2, usd_amount / 3000.0};
+  request.legs[2] = {2, usd_amount / 3000.0, 0, usd_amount * 1.0001};
+  return request;
+}
+
+void bench_risk() {
+  std::printf("--- risk ---\n");
+
+  RiskConfig config;
+  config.max_cycle_notional = 1e6;
+  RiskManager risk(3, config);
+  for (int id = 0; id < 3; id++) {
+    risk.set_notional_limit(id, 1e9);
+    risk.set_mark(id, 1.0);
+  }
+  CycleRiskRequest request = triangle_request(1000.0, 0);
+
+  report("check_cycle + release_cycle (no rate limit)", 5000000, [&](size_t) {
+    if (risk.check_cycle(request) == RiskVerdict::Accepted) {
+      risk.release_cycle(request);
+    }
+  });
+
+  RiskConfig limited = config;
+  limited.orders_per_second = 1e9;
+  limited.order_burst = 1e6;
+  RiskManager rate_risk(3, limited);
+  report("check_cycle + release_cycle (rate limit)", 5000000, [&](size_t i) {
+    request.now_ns = static_cast<int64_t>(i) * 100;
+    if (rate_risk.check_cycle(request) == RiskVerdict::Accepted) {
+      rate_risk.release_cycle(request);
+    }
+  });
+
+  /*
+   * Concurrent updates: every thread reserves the same cycle, keeping one
+   * reservation in three. Each kept cycle leaves +0.1 USD, so the USD position
+   * climbs into its band within a few thousand cycles and the final positions
+   * show whether any accepted cycle overshot it.
+   */
+  const double band = 250.0;
+  RiskManager shared(3, config);
+  shared.set_position_limits(0, -band, band);
+  shared.set_position_limits(1, -band / 60000.0, band / 60000.0);
+  shared.set_position_limits(2, -band / 3000.0, band / 3000.0);
+
+  const unsigned num_threads = 4;
+  const size_t per_thread = 500000;
+  std::atomic<size_t> accepted{0};
+
+  int64_t start = steady_now_ns();
+  std::vector<std::thread> workers;
+  for (unsigned t = 0; t < num_threads; t++) {
+    workers.emplace_back([&]() {
+      CycleRiskRequest mine = triangle_request(1000.0, 0);
+      size_t local_accepted = 0;
+      for (size_t i = 0; i < per_thread; i++) {
+        if (shared.check_cycle(mine) == RiskVerdict::Accepted) {
+          local_accepted++;
+          if (i % 3 != 0) {
+            shared.release_cycle(mine);
+          }
+        }
+      }
+      accepted += local_accepted;
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  int64_t elapsed = steady_now_ns() - start;
+
+  bool within_band = std::fabs(shared.position(0)) <= band + 1e-6 &&
+                     std::fabs(shared.position(1)) <= band / 60000.0 + 1e-8 &&
+                     std::fabs(shared.position(2)) <= band / 3000.0 + 1e-8;
+  std::printf("%-44s %10.1f ns/op  (%u threads, %zu accepted, final positions %s band)\n",
+              "concurrent check_cycle", static_cast<double>(elapsed) / (num_threads * per_thread),
+              num_threads, accepted.load(), within_band ? "within" : "OUTSIDE");
+}
+
+/**
+ * @brief Symbols of a fully connected market over `num_currencies` made-up currencies.
+ */
+std::vector<std::string> dense_market(int num_currencies) {
+  std::vector<std::string> symbols;
+  for (int base = 0; base < num_currencies; base++) {
+    for (int quote = base + 1; quote < num_currencies; quote++) {
+      symbols.push_back("C" + std::to_string(base) + "-C" + std::to_string(quote));
+    }
+  }
+  return symbols;
+}
+
+void bench_weights() {
+  std::printf("--- edge weights ---\n");
+
+  const size_t num_prices = 4096;
+  std::mt19937_64 rng(7);
+  std::lognormal_distribution<double> price_distribution(0.0, 6.0);
+  std::vector<double> prices(num_prices);
+  for (double& price : prices) {
+    price = price_distribution(rng);
+  }
+
+  /* Independent conversions, as in a burst of updates; the sums keep them from being optimised away */
+  double double_sum = 0.0;
+  int64_t fixed_sum = 0;
+  report("-log(price), double", 20000000, [&](size_t i) {
+    double_sum -= std::log(prices[i & (num_prices - 1)]);
+  });
+  report("-fixed_log(price), int64", 20000000, [&](size_t i) {
+    fixed_sum -= fixed_log(prices[i & (num_prices - 1)]);
+  });
+  std::printf("%-44s %10.3g vs %.3g\n", "  sums (should agree)", double_sum, fixed_log_to_double(fixed_sum));
+
+  /*
+   * Detection over a dense 12-currency market whose prices are consistent up to
+   * noise of a few ulps, so cycle profits hover around zero: the case where the
+   * double path's decisions depend on rounding and the epsilon.
+   */
+  const int num_currencies = 12;
+  std::vector<std::string> symbols = dense_market(num_currencies);
+  std::vector<double> values(num_currencies);
+  for (double& value : values) {
+    value = price_distribution(rng);
+  }
+  std::uniform_real_distribution<double> noise(-4e-16, 4e-16);
+  std::vector<double> quotes(symbols.size() * 64);
+  for (size_t i = 0; i < quotes.size(); i++) {
+    size_t pair = i % symbols.size();
+    int base = 0;
+    int quote = 0;
+    std::sscanf(symbols[pair].c_str(), "C%d-C%d", &base, &quote);
+    quotes[i] = values[base] / values[quote] * (1.0 + noise(rng));
+  }
+
+  struct Detector {
+    const char* name;
+    WeightMode weights;
+    DetectionMode detection;
+  };
+  for (const Detector& detector : {Detector{"update + detect, double weights", WeightMode::Double, DetectionMode::Spfa},
+                                   Detector{"update + detect, fixed-point weights", WeightMode::FixedPoint,
+                                            DetectionMode::Spfa},
+                                   Detector{"update + detect, triangle ratios", WeightMode::Double,
+                                            DetectionMode::Indexed}}) {
+    ArbitrageGraph graph(symbols);
+    graph.set_weight_mode(detector.weights);
+    graph.set_detection_mode(detector.detection);
+    Opportunity opportunity;
+    size_t found = 0;
+    report(detector.name, 200000, [&](size_t i) {
+      int pair_id = static_cast<int>(i % symbols.size());
+      graph.update_price(pair_id, quotes[i % quotes.size()], 0, static_cast<int64_t>(i));
+      found += graph.find_arbitrage_cycle(opportunity) ? 1 : 0;
+    });
+    std::printf("%-44s %10zu\n", "  cycles reported", found);
+    report("  best_indexed_cycle", 200000, [&](size_t) {
+      found += graph.best_indexed_cycle(opportunity) ? 1 : 0;
+    });
+    /* Retires the pair's cycles and walks out of its edges to bring them back; no rebuild */
+    report("  delist + relist a pair", 1000, [&](size_t i) {
+      int pair_id = static_cast<int>(i * 7919 % symbols.size());
+      graph.remove_pair(pair_id);
+      graph.add_pair(symbols[pair_id]);
+    });
+  }
+}
+
+/**
+ * @brief An exchange-like universe: `num_assets` assets quoted in USD and, with falling
+ * likelihood, in stablecoins, fiat and the majors, plus the crosses between those quotes.
+ */
+std::vector<std::string> exchange_market(int num_assets, std::mt19937_64& rng) {
+  std::vector<std::string> symbols = {"BTC-USD", "ETH-USD", "ETH-BTC", "USDT-USD", "USDC-USD", "EUR-USD",
+                                      "GBP-USD", "BTC-USDT", "ETH-USDT", "BTC-EUR", "ETH-EUR", "BTC-GBP",
+                                      "USDT-EUR", "USDC-EUR"};
+  const std::pair<const char*, double> quotes[] = {{"USDT", 0.6}, {"USDC", 0.3}, {"BTC", 0.4},
+                                                   {"ETH", 0.2},  {"EUR", 0.2},  {"GBP", 0.1}};
+  std::uniform_real_distribution<double> coin(0.0, 1.0);
+  for (int asset = 0; asset < num_assets; asset++) {
+    std::string base = "A" + std::to_string(asset);
+    symbols.push_back(base + "-USD");
+    for (const auto& quote : quotes) {
+      if (coin(rng) < quote.second) {
+        symbols.push_back(base + "-" + quote.first);
+      }
+    }
+  }
+  return symbols;
+}
+
+void bench_cycles() {
+  std::printf("--- indexed cycles ---\n");
+
+  std::mt19937_64 rng(5);
+  std::vector<std::string> symbols = exchange_market(250, rng);
+
+  /* Rates consistent up to a few ulps, so no cycle is profitable and every update evaluates all its cycles */
+  std::lognormal_distribution<double> value_distribution(0.0, 4.0);
+  std::uniform_real_distribution<double> noise(-4e-16, 4e-16);
+  PairCatalog catalog;
+  for (const std::string& symbol : symbols) {
+    catalog.add_pair(symbol);
+  }
+  std::vector<double> values(catalog.num_currencies());
+  for (double& value : values) {
+    value = value_distribution(rng);
+  }
+  std::vector<double> quotes(symbols.size() * 64);
+  for (size_t i = 0; i < quotes.size(); i++) {
+    int pair_id = static_cast<int>(i % symbols.size());
+    quotes[i] = values[catalog.base_id(pair_id)] / values[catalog.quote_id(pair_id)] * (1.0 + noise(rng));
+  }
+  std::printf("%-44s %10zu pairs, %d currencies\n", "  universe", symbols.size(), catalog.num_currencies());
+
+  std::vector<int> anchors;
+  for (const char* anchor : {"USD", "USDT", "USDC", "EUR"}) {
+    anchors.push_back(catalog.find_currency(anchor));
+  }
+  for (int max_legs = 3; max_legs <= CycleIndex::MAX_CYCLE_LENGTH; max_legs++) {
+    ArbitrageGraph graph(symbols);
+    graph.set_detection_mode(DetectionMode::Indexed);
+    graph.set_cycle_index(max_legs, anchors);
+    int64_t start = steady_now_ns();
+    const CycleIndex& index = graph.indexed_cycles();
+    int64_t build_ns = steady_now_ns() - start;
+
+    int by_length[CycleIndex::MAX_CYCLE_LENGTH + 1] = {};
+    for (int cycle = 0; cycle < index.num_cycles(); cycle++) {
+      by_length[index.cycle_length(cycle)]++;
+    }
+    size_t memberships = 0;
+    for (uint32_t slot = 0; slot < 2 * symbols.size(); slot++) {
+      memberships += static_cast<size_t>(index.cycles_end(slot) - index.cycles_begin(slot));
+    }
+    std::printf("up to %d legs: %d cycles (3: %d, 4: %d, 5: %d), %.2f MiB, built in %.1f ms, %.1f cycles/update\n",
+                max_legs, index.num_cycles(), by_length[3], by_length[4], by_length[5],
+                index.memory_bytes() / 1048576.0, build_ns / 1e6, 2.0 * memberships / (2 * symbols.size()));
+
+    Opportunity opportunity;
+    size_t found = 0;
+    report("  update + detect", 200000, [&](size_t i) {
+      int pair_id = static_cast<int>(i % symbols.size());
+      graph.update_price(pair_id, quotes[i % quotes.size()], 0, static_cast<int64_t>(i));
+      found += graph.find_arbitrage_cycle(opportunity) ? 1 : 0;
+    });
+    std::printf("%-44s %10zu\n", "  cycles reported", found);
+    report("  best_indexed_cycle", 200000, [&](size_t) {
+      found += graph.best_indexed_cycle(opportunity) ? 1 : 0;
+    });
+    /* Retires the pair's cycles and walks out of its edges to bring them back; no rebuild */
+    report("  delist + relist a pair", 1000, [&](size_t i) {
+      int pair_id = static_cast<int>(i * 7919 % symbols.size());
+      graph.remove_pair(pair_id);
+      graph.add_pair(symbols[pair_id]);
+    });
+  }
+}
+
+/**
+ * @brief Largest distance of `log_batch` from the extended-precision log over `prices`, in ULPs of the result.
+ */
+double max_log_batch_ulps(const std::vector<double>& prices) {
+  std::vector<double> logs(prices.size());
+  log_batch(prices.data(), logs.data(), prices.size());
+  double worst = 0.0;
+  for (size_t i = 0; i < prices.size(); i++) {
+    long double exact = std::log(static_cast<long double>(prices[i]));
+    double ulp = std::nextafter(std::fabs(logs[i]), INFINITY) - std::fabs(logs[i]);
+    if (logs[i] == 0.0) {
+      continue;
+    }
+    worst = std::max(worst, static_cast<double>(std::fabs(logs[i] - exact) / ulp));
+  }
+  return worst;
+}
+
+void bench_snapshot() {
+  std::printf("--- snapshot weights (%s log_batch) ---\n", log_batch_vectorised() ? "avx2" : "scalar");
+
+  std::mt19937_64 rng(11);
+  std::lognormal_distribution<double> price_distribution(0.0, 6.0);
+  std::vector<double> sample(1 << 20);
+  for (double& price : sample) {
+    price = price_distribution(rng);
+  }
+  std::printf("%-44s %10.3f\n", "  max error vs long double, ulps", max_log_batch_ulps(sample));
+
+  /* 448 currencies give 100,128 pairs, enough for the largest snapshot */
+  std::vector<std::string> market = dense_market(448);
+  for (size_t num_quotes : {size_t{1000}, size_t{10000}, size_t{100000}}) {
+    std::vector<double> prices(2 * num_quotes);
+    for (double& price : prices) {
+      price = price_distribution(rng);
+    }
+    std::vector<double> logs(prices.size());
+    size_t repetitions = 2000000 / num_quotes;
+    std::string suffix = std::to_string(num_quotes) + " quotes";
+
+    double sum = 0.0;
+    report(("libm log, " + suffix).c_str(), repetitions, [&](size_t) {
+      for (size_t i = 0; i < prices.size(); i++) {
+        logs[i] = std::log(prices[i]);
+      }
+      sum += logs[0];
+    });
+    report(("log_batch, " + suffix).c_str(), repetitions, [&](size_t) {
+      log_batch(prices.data(), logs.data(), prices.size());
+      sum += logs[0];
+    });
+
+    std::vector<std::string> symbols(market.begin(), market.begin() + num_quotes);
+    std::vector<int32_t> pair_ids(num_quotes);
+    std::vector<double> bids(num_quotes);
+    std::vector<double> asks(num_quotes);
+    for (size_t i = 0; i < num_quotes; i++) {
+      pair_ids[i] = static_cast<int32_t>(i);
+      bids[i] = prices[2 * i];
+      asks[i] = prices[2 * i] * 1.0002;
+    }
+    /* Only the updates are timed; detection drains the dirty queue between snapshots and costs the same either way */
+    ArbitrageGraph graph(symbols);
+    Opportunity opportunity;
+    auto time_snapshots = [&](const char* name, auto&& apply) {
+      int64_t elapsed = 0;
+      for (size_t r = 0; r < repetitions; r++) {
+        int64_t start = steady_now_ns();
+        apply(static_cast<int64_t>(r));
+        elapsed += steady_now_ns() - start;
+        graph.find_arbitrage_cycle(opportunity);
+      }
+      std::printf("%-44s %10.1f ns/op\n", (name + (", " + suffix)).c_str(), static_cast<double>(elapsed) / repetitions);
+    };
+    time_snapshots("update_quote loop", [&](int64_t now) {
+      for (size_t i = 0; i < num_quotes; i++) {
+        graph.update_quote(pair_ids[i], bids[i], asks[i], 0, now);
+      }
+    });
+    time_snapshots("update_quotes batch", [&](int64_t now) {
+      graph.update_quotes(pair_ids.data(), bids.data(), asks.data(), num_quotes, now);
+    });
+    if (sum == 0.123) {
+      std::printf("%g\n", sum);
+    }
+  }
+}
+
+const char* backing_name(ArenaBacking backing) {
+  switch (backing) {
+    case ArenaBacking::HugeTlbPages: return "hugetlbfs 2 MiB pages";
+    case ArenaBacking::TransparentHugePages: return "transparent huge pages";
+    default: return "4 KiB pages";
+  }
+}
+
+void bench_arena() {
+  std::printf("--- engine arena ---\n");
+
+  std::mt19937_64 rng(7);
+  std::vector<std::string> symbols = exchange_market(250, rng);
+  /* Consistent rates, so no cycle is profitable and every detection does its full work */
+  std::lognormal_distribution<double> value_distribution(0.0, 4.0);
+  std::vector<double> values(symbols.size() * 2);
+  for (double& value : values) {
+    value = value_distribution(rng);
+  }
+
+  EngineArena arena;
+  std::printf("%-44s %s, NUMA node %d\n", "  backing", backing_name(arena.backing()), arena.numa_node());
+
+  /* Fragment the heap first, as a long-running process would have, so the heap graph's blocks are scattered */
+  std::vector<std::vector<char>> clutter;
+  for (size_t i = 0; i < 20000; i++) {
+    clutter.emplace_back(16 + rng() % 512);
+  }
+  for (size_t i = 0; i < clutter.size(); i += 2) {
+    clutter[i] = std::vector<char>();
+  }
+
+  for (EngineArena* engine_arena : {static_cast<EngineArena*>(nullptr), &arena}) {
+    const char* where = engine_arena != nullptr ? "arena" : "heap";
+    for (DetectionMode detection : {DetectionMode::Spfa, DetectionMode::Indexed}) {
+      ArbitrageGraph graph(symbols, 0, 0, engine_arena);
+      graph.set_detection_mode(detection);
+      graph.set_cycle_index(4, {0});
+      const PairCatalog& catalog = graph.catalog();
+      auto price = [&](int pair_id) { return values[catalog.base_id(pair_id)] / values[catalog.quote_id(pair_id)]; };
+      for (int pair_id = 0; pair_id < catalog.num_pairs(); pair_id++) {
+        graph.update_price(pair_id, price(pair_id));
+      }
+      Opportunity opportunity;
+      graph.find_arbitrage_cycle(opportunity);
+
+      std::string name = std::string("  ") + where + (detection == DetectionMode::Spfa ? ", spfa" : ", 4-leg index") +
+                         " update + detect";
+      size_t iterations = detection == DetectionMode::Spfa ? 2000 : 200000;
+      size_t found = 0;
+      report(name.c_str(), iterations, [&](size_t i) {
+        int pair_id = static_cast<int>(i % symbols.size());
+        graph.update_price(pair_id, price(pair_id), 0, static_cast<int64_t>(i));
+        found += graph.find_arbitrage_cycle(opportunity) ? 1 : 0;
+      });
+      if (found == SIZE_MAX) {
+        std::printf("%zu\n", found);
+      }
+    }
+  }
+
+  for (const ArenaUsage& usage : arena.usage()) {
+    std::printf("  %-42s %10zu bytes, peak %zu, %llu allocations\n", usage.name.c_str(), usage.bytes,
+                usage.peak_bytes, static_cast<unsigned long long>(usage.allocations));
+  }
+  std::printf("%-44s %10zu bytes of %zu\n", "  region used", arena.reserved_bytes(), arena.capacity_bytes());
+}
+
+void bench_symbols() {
+  std::printf("--- symbol resolution ---\n");
+
+  std::mt19937_64 rng(17);
+  std::vector<std::string> symbols = exchange_market(250, rng);
+  PairCatalog catalog;
+  std::unordered_map<std::string, int> symbol_map;
+  for (const std::string& symbol : symbols) {
+    symbol_map.emplace(symbol, catalog.add_pair(symbol));
+  }
+
+  /* Symbols in feed order, copied out as a message parser would hold them */
+  std::vector<std::string> messages(1 << 16);
+  for (std::string& message : messages) {
+    message = symbols[rng() % symbols.size()];
+  }
+  size_t mask = messages.size() - 1;
+  int64_t sum = 0;
+  std::printf("%-44s %10zu\n", "  symbols", symbols.size());
+  report("  std::unordered_map<std::string, int>", 10000000, [&](size_t i) {
+    sum += symbol_map.find(messages[i & mask])->second;
+  });
+  report("  PairCatalog::find_pair (perfect hash)", 10000000, [&](size_t i) {
+    sum += catalog.find_pair(messages[i & mask]);
+  });
+  report("  find_pair, unknown symbol", 10000000, [&](size_t i) {
+    sum += catalog.find_pair(i & 1 ? "DOGE-XYZ" : "ZZZ-USDT", 8);
+  });
+  if (sum == 42) {
+    std::printf("%lld\n", static_cast<long long>(sum));
+  }
+}
+
+void bench_csv() {
+  std::printf("--- csv ingestion ---\n");
+
+  /* A capture shaped like the data logger's: ~60-byte rows over a skewed set of symbols */
+  std::string path = "/tmp/engine_benchmarks_capture.csv";
+  std::FILE* file = std::fopen(path.c_str(), "w");
+  if (file == nullptr) {
+    std::printf("  could not write %s\n", path.c_str());
+    return;
+  }
+  std::mt19937_64 rng(13);
+  std::geometric_distribution<int> symbol_distribution(0.05);
+  std::uniform_real_distribution<double> price(0.1, 70000.0);
+  std::fprintf(file, "timestamp,symbol,price,quantity\n");
+  const size_t num_rows = 4000000;
+  for (size_t i = 0; i < num_rows; i++) {
+    std::fprintf(file, "2024-05-01 %02zu:%02zu:%02zu.%06zu+00:00,C%d-USD,%.6f,%.8f\n", i / 360000 % 24,
+                 i / 6000 % 60, i / 100 % 60, i % 1000000, std::min(symbol_distribution(rng), 99), price(rng),
+                 price(rng) / 70000.0);
+  }
+  long bytes = std::ftell(file);
+  std::fclose(file);
+
+  unsigned all = resolve_thread_count(0);
+  for (unsigned threads : {1u, all}) {
+    TickArchive archive;
+    int64_t start = steady_now_ns();
+    archive.open(path, threads);
+    double seconds = (steady_now_ns() - start) / 1e9;
+    std::printf("  %u thread(s): %zu ticks over %zu pairs in %.3f s, %.0f MB/s\n", threads, archive.size(),
+                archive.symbols().size(), seconds, bytes / seconds / 1e6);
+    if (all == 1) {
+      break;
+    }
+  }
+  std::remove(path.c_str());
+}
+
+void bench_ring() {
+  std::printf("--- tick fan-out to 3 stages ---\n");
+
+  const int num_stages = 3;
+  MulticastRing<TickRecord> ring(4096);
+  int stages[num_stages];
+  for (int stage = 0; stage < num_stages; stage++) {
+    stages[stage] = ring.add_consumer();
+  }
+  std::vector<moodycamel::ConcurrentQueue<TickRecord>> queues(num_stages);
+  TickRecord tick = {};
+  tick.price = 60000.0;
+  double sum = 0.0;
+
+  /* One thread plays producer and every stage, so this is the bare cost per tick */
+  report("  ConcurrentQueue x3 (3 enqueues + 3 dequeues)", 5000000, [&](size_t i) {
+    tick.exchange_ts_ns = static_cast<int64_t>(i);
+    for (auto& queue : queues) {
+      queue.enqueue(tick);
+    }
+    TickRecord received{};
+    for (auto& queue : queues) {
+      if (queue.try_dequeue(received)) {
+        sum += received.price;
+      }
+    }
+  });
+  report("  MulticastRing (1 write + 3 reads)", 5000000, [&](size_t i) {
+    TickRecord& slot = ring.claim();
+    slot = tick;
+    slot.exchange_ts_ns = static_cast<int64_t>(i);
+    ring.publish();
+    for (int stage : stages) {
+      ring.poll(stage, [&](const TickRecord& received, int64_t) { sum += received.price; });
+    }
+  });
+
+  /* A producer thread against three stage threads, each summing every tick */
+  const size_t num_ticks = 2000000;
+  auto run_stages = [&](auto&& stage_loop) {
+    std::vector<std::thread> threads;
+    for (int stage = 0; stage < num_stages; stage++) {
+      threads.emplace_back(stage_loop, stage);
+    }
+    return threads;
+  };
+  {
+    int64_t start = steady_now_ns();
+    std::vector<std::thread> threads = run_stages([&](int stage) {
+      TickRecord received;
+      size_t seen = 0;
+      while (seen < num_ticks) {
+        if (queues[stage].try_dequeue(received)) {
+          seen++;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+    for (size_t i = 0; i < num_ticks; i++) {
+      tick.exchange_ts_ns = static_cast<int64_t>(i);
+      for (auto& queue : queues) {
+        queue.enqueue(tick);
+      }
+    }
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+    std::printf("%-44s %10.1f ns/tick\n", "  ConcurrentQueue x3, 1 + 3 threads",
+                static_cast<double>(steady_now_ns() - start) / num_ticks);
+  }
+  {
+    MulticastRing<TickRecord> threaded(4096);
+    for (int stage = 0; stage < num_stages; stage++) {
+      threaded.add_consumer();
+    }
+    int64_t start = steady_now_ns();
+    std::vector<std::thread> threads = run_stages([&](int stage) {
+      while (threaded.cursor(stage) < static_cast<int64_t>(num_ticks) - 1) {
+        if (threaded.poll(stage, [](const TickRecord&, int64_t) {}) == 0) {
+          std::this_thread::yield();
+        }
+      }
+    });
+    for (size_t i = 0; i < num_ticks; i++) {
+      TickRecord& slot = threaded.claim();
+      slot = tick;
+      slot.exchange_ts_ns = static_cast<int64_t>(i);
+      threaded.publish();
+    }
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+    std::printf("%-44s %10.1f ns/tick\n", "  MulticastRing, 1 + 3 threads",
+                static_cast<double>(steady_now_ns() - start) / num_ticks);
+  }
+  if (sum == 42.0) {
+    std::printf("%f\n", sum);
+  }
+}
+
+void bench_wait() {
+  std::printf("--- consumer wait strategies (one tick every 100us) ---\n");
+
+  const size_t num_ticks = 2000;
+  for (WaitKind kind : {WaitKind::BusySpin, WaitKind::SpinYield, WaitKind::SpinPark, WaitKind::Blocking}) {
+    MulticastRing<TickRecord> ring(1024);
+    int consumer = ring.add_consumer();
+    WakeSignal signal;
+    WaitStats stats;
+
+    /* The publish time travels in the tick itself */
+    std::thread stage([&]() {
+      WaitConfig config;
+      config.kind = kind;
+      WaitStrategy waiter(config, &signal);
+      while (ring.cursor(consumer) < static_cast<int64_t>(num_ticks) - 1) {
+        bool waited = waiter.wait_until([&]() { return ring.available_to(consumer) > ring.cursor(consumer); });
+        ring.poll(consumer, [&](const TickRecord& tick, int64_t) {
+          if (waited) {
+            waiter.record_wakeup(steady_now_ns() - tick.receive_ts_ns);
+            waited = false;
+          }
+        });
+      }
+      stats = waiter.stats();
+    });
+    for (size_t i = 0; i < num_ticks; i++) {
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+      TickRecord& tick = ring.claim();
+      tick.receive_ts_ns = steady_now_ns();
+      ring.publish();
+      signal.notify();
+    }
+    stage.join();
+    std::printf("  %-6s wake-up p50 < %4lld us, p99 < %4lld us, %5.1f%% of a core, %llu yields %llu parks %llu sleeps\n",
+                wait_kind_name(kind), static_cast<long long>(stats.wakeup.quantile_ns(0.5) / 1000),
+                static_cast<long long>(stats.wakeup.quantile_ns(0.99) / 1000), 100 * stats.cpu_share(),
+                static_cast<unsigned long long>(stats.yields), static_cast<unsigned long long>(stats.parks),
+                static_cast<unsigned long long>(stats.sleeps));
+  }
+}
+
+int main(int argc, char** argv) {
+  std::string only = argc > 1 ? argv[1] : "";
+
+  if (only.empty() || only == "risk") {
+    bench_risk();
+  }
+  if (only.empty() || only == "weights") {
+    bench_weights();
+  }
+  if (only.empty() || only == "snapshot") {
+    bench_snapshot();
+  }
+  if (only.empty() || only == "cycles") {
+    bench_cycles();
+  }
+  if (only.empty() || only == "arena") {
+    bench_arena();
+  }
+  if (only.empty() || only == "symbols") {
+    bench_symbols();
+  }
+  if (only.empty() || only == "csv") {
+    bench_csv();
+  }
+  if (only.empty() || only == "ring") {
+    bench_ring();
+  }
+  if (only.empty() || only == "wait") {
+    bench_wait();
+  }
+  return 0;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+/**
+ * @brief Monotonic wall time in nanoseconds, the engine's common clock for latency stamps.
+ */
+inline int64_t steady_now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief Wall-clock time in nanoseconds since the Unix epoch, comparable with exchange timestamps.
+ */
+inline int64_t wall_now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::system_clock::now().time_since_epoch()).count();
+}
@@ -0,0 +1,187 @@
+/**
+ * @file cycleexecution.cpp
+ * @brief Implements conversion of detected cycles into orders and their fill accounting.
+ */
+
+#include "cycleexecution.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include "ordergateway.h"
+
+CycleExecutor::CycleExecutor(const PairCatalog& catalog, ExchangeSimulator& simulator, int valuation_currency_id,
+                             double notional, double limit_tolerance_bps)
+  : catalog(catalog), simulator(simulator), valuation_currency_id(valuation_currency_id),
+    notional(notional), limit_tolerance(limit_tolerance_bps * 1e-4) {
+  this->num_pairs = std::min(catalog.num_pairs(), simulator.num_pairs());
+  this->currency_deltas.resize(catalog.num_currencies(), 0.0);
+}
+
+/**
+ * @brief Plans every leg of the cycle; nothing is sent until `submit_planned`.
+ *
+ * A leg over a pair's forward edge sells the base; over its reverse edge it buys
+ * the base. Quantities are chained through the current top of book so that the
+ * expected proceeds of one leg are exactly the input of the next.
+ */
+bool CycleExecutor::plan(const Opportunity& cycle, int64_t send_ts_ns) {
+  planned_orders.clear();
+  if (in_flight() || cycle.num_legs < 2) {
+    return false;
+  }
+
+  for (int i = 0; i < cycle.num_legs; i++) {
+    int pair_id = edge_pair_id(cycle.edge_slots[i]);
+    if (pair_id >= num_pairs) {
+      throw std::out_of_range("Cycle trades " + catalog.symbol(pair_id) +
+                              ", which was listed after the executor was built");
+    }
+  }
+
+  int start_id = cycle.currency_ids[0];
+  double start_amount = simulator.convert(notional, valuation_currency_id, start_id);
+  if (inventory != nullptr) {
+    start_amount = std::min(start_amount, inventory->balance(start_id));
+  }
+  if (start_amount <= 0.0) {
+    return false;
+  }
+
+  double amount = start_amount;
+  for (int i = 0; i < cycle.num_legs; i++) {
+    Order order;
+    order.order_id = next_order_id++;
+    order.cycle_id = next_cycle_id;
+    order.send_ts_ns = send_ts_ns;
+    order.pair_id = edge_pair_id(cycle.edge_slots[i]);
+
+    if (!edge_buys_base(cycle.edge_slots[i]) && simulator.best_bid(order.pair_id) > 0.0) {
+      double bid = simulator.best_bid(order.pair_id);
+      order.side = OrderSide::Sell;
+      order.quantity = amount;
+      order.limit_price = bid * (1.0 - limit_tolerance);
+      amount *= bid;
+    } else if (edge_buys_base(cycle.edge_slots[i]) && simulator.best_ask(order.pair_id) > 0.0) {
+      double ask = simulator.best_ask(order.pair_id);
+      order.side = OrderSide::Buy;
+      order.quantity = amount / ask;
+      order.limit_price = ask * (1.0 + limit_tolerance);
+      amount = order.quantity;
+    } else {
+      planned_orders.clear();
+      return false;
+    }
+    planned_orders.push_back(order);
+  }
+
+  planned_gross_return = amount / start_amount - 1.0;
+  return true;
+}
+
+bool CycleExecutor::submit_planned(int64_t trigger_ts_ns) {
+  if (planned_orders.empty() || in_flight() ||
+      planned_orders.size() > static_cast<size_t>(CycleOrderRequest::MAX_LEGS)) {
+    return false;
+  }
+
+  if (risk != nullptr) {
+    reservation.num_legs = static_cast<int>(planned_orders.size());
+    reservation.notional = notional;
+    reservation.now_ns = planned_orders.front().send_ts_ns;
+    for (size_t i = 0; i < planned_orders.size(); i++) {
+      const Order& order = planned_orders[i];
+      int base = catalog.base_id(order.pair_id);
+      int quote = catalog.quote_id(order.pair_id);
+      double proceeds = order.quantity * order.limit_price;
+      reservation.legs[i] = order.side == OrderSide::Sell ? RiskLeg{base, order.quantity, quote, proceeds}
+                                                          : RiskLeg{quote, proceeds, base, order.quantity};
+    }
+    last_verdict = risk->check_cycle(reservation);
+    if (last_verdict != RiskVerdict::Accepted) {
+      return false;
+    }
+  }
+
+  if (gateway != nullptr) {
+    CycleOrderRequest request;
+    request.cycle_id = next_cycle_id;
+    request.trigger_ts_ns = trigger_ts_ns;
+    request.num_legs = static_cast<int>(planned_orders.size());
+    std::copy(planned_orders.begin(), planned_orders.end(), request.legs);
+    if (!gateway->submit_cycle(request)) {
+      if (risk != nullptr) {
+        risk->release_cycle(reservation);
+      }
+      return false;
+    }
+  } else {
+    for (const Order& order : planned_orders) {
+      simulator.submit(order);
+    }
+  }
+
+  current = CycleResult();
+  current.cycle_id = next_cycle_id++;
+  current.legs = static_cast<int>(planned_orders.size());
+  current.trigger_ts_ns = trigger_ts_ns;
+  std::fill(currency_deltas.begin(), currency_deltas.end(), 0.0);
+  legs_outstanding = current.legs;
+  planned_orders.clear();
+  return true;
+}
+
+bool CycleExecutor::execute(const Opportunity& cycle, int64_t trigger_ts_ns, int64_t send_ts_ns) {
+  if (!plan(cycle, send_ts_ns)) {
+    return false;
+  }
+  return submit_planned(trigger_ts_ns);
+}
+
+bool CycleExecutor::on_fill(const Fill& fill, CycleResult& result) {
+  if (!in_flight() || fill.cycle_id != current.cycle_id) {
+    return false;
+  }
+
+  if (fill.status == FillStatus::Filled) {
+    current.legs_filled++;
+  }
+  if (fill.filled_quantity > 0.0) {
+    int base = catalog.base_id(fill.pair_id);
+    int quote = catalog.quote_id(fill.pair_id);
+    double proceeds = fill.filled_quantity * fill.average_price;
+    double base_delta = fill.side == OrderSide::Buy ? fill.filled_quantity - fill.fee : -fill.filled_quantity;
+    double quote_delta = fill.side == OrderSide::Buy ? -proceeds : proceeds - fill.fee;
+    currency_deltas[base] += base_delta;
+    currency_deltas[quote] += quote_delta;
+    if (inventory != nullptr) {
+      inventory->adjust(base, base_delta);
+      inventory->adjust(quote, quote_delta);
+    }
+  }
+  current.last_report_ts_ns = std::max(current.last_report_ts_ns, fill.report_ts_ns);
+
+  if (--legs_outstanding > 0) {
+    return false;
+  }
+
+  /* Replace the reservation with what actually executed */
+  if (risk != nullptr) {
+    risk->release_cycle(reservation);
+    for (int id = 0; id < static_cast<int>(currency_deltas.size()); id++) {
+      if (currency_deltas[id] != 0.0) {
+        risk->adjust_position(id, currency_deltas[id]);
+      }
+    }
+  }
+
+  current.complete = current.legs_filled == current.legs;
+  current.realised_pnl = 0.0;
+  for (int id = 0; id < static_cast<int>(currency_deltas.size()); id++) {
+    if (currency_deltas[id] != 0.0) {
+      current.realised_pnl += simulator.convert(currency_deltas[id], id, valuation_currency_id);
+    }
+  }
+  result = current;
+  return true;
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "exchangesimulator.h"
+#include "opportunity.h"
+#include "paircatalog.h"
+#include "riskmanager.h"
+#include "inventory.h"
+
+class OrderGateway;
+
+/**
+ * @struct CycleResult
+ * @brief Outcome of one executed arbitrage cycle, reported once every leg has a fill.
+ */
+struct CycleResult {
+  uint64_t cycle_id = 0;
+  int legs = 0;
+  /// @brief Number of legs that executed their full quantity.
+  int legs_filled = 0;
+  /// @brief True if every leg fully filled.
+  bool complete = false;
+  /// @brief Net currency movements of the cycle, valued in the valuation currency.
+  double realised_pnl = 0.0;
+  /// @brief Timestamp of the tick that triggered the detection.
+  int64_t trigger_ts_ns = 0;
+  /// @brief Report time of the last leg's fill.
+  int64_t last_report_ts_ns = 0;
+
+  int64_t tick_to_fill_ns() const { return last_report_ts_ns - trigger_ts_ns; }
+};
+
+/**
+ * @class CycleExecutor
+ * @brief Turns a detected cycle into IOC orders and accounts for their fills.
+ *
+ * All legs of a cycle are sent at once, each priced off the current top of book
+ * with a limit tolerance, sized so that the proceeds of one leg fund the next.
+ * Only one cycle is in flight at a time; detections that arrive while a cycle is
+ * outstanding are not executed. Orders go straight to the simulator's inbound
+ * queue unless the executor is routed through an `OrderGateway`.
+ */
+class CycleExecutor {
+public:
+  /**
+   * @param catalog Pair and currency IDs shared with the simulator.
+   * @param simulator The venue orders are sent to and quotes are read from.
+   * @param valuation_currency_id Currency in which notional and PnL are expressed.
+   * @param notional Size of each cycle, in the valuation currency.
+   * @param limit_tolerance_bps How far past the current top of book each leg may fill.
+   */
+  CycleExecutor(const PairCatalog& catalog, ExchangeSimulator& simulator, int valuation_currency_id,
+                double notional, double limit_tolerance_bps);
+
+  /**
+   * @brief Plans and submits the orders for a cycle.
+   * @param cycle The detected cycle; its edge slots decide each leg's pair and side.
+   * @param trigger_ts_ns Timestamp of the tick that led to the detection.
+   * @param send_ts_ns Time the orders leave the engine.
+   * @return True if the orders were submitted; false if a cycle is already in
+   * flight or a leg cannot be priced.
+   * @throws std::out_of_range if a leg trades a pair registered after the executor or simulator was built.
+   */
+  bool execute(const Opportunity& cycle, int64_t trigger_ts_ns, int64_t send_ts_ns);
+
+  /**
+   * @brief Prices and sizes every leg of a cycle without sending anything.
+   * @return True if all legs could be priced and no cycle is in flight.
+   * @throws std::out_of_range if a leg trades a pair registered after the executor or simulator was built.
+   */
+  bool plan(const Opportunity& cycle, int64_t send_ts_ns);
+
+  /**
+   * @brief Expected gross return of the last planned cycle at current top of book, before fees.
+   */
+  double planned_return() const { return planned_gross_return; }
+
+  /**
+   * @brief Submits the orders of the last successful `plan`.
+   * @return False if nothing was planned or the gateway refused the cycle.
+   */
+  bool submit_planned(int64_t trigger_ts_ns);
+
+  /**
+   * @brief Sends future cycles through `gateway` instead of directly to the simulator.
+   */
+  void route_through(OrderGateway* gateway) { this->gateway = gateway; }
+
+  /**
+   * @brief Subjects future cycles to pre-trade checks. The risk manager must use
+   * the same currency IDs as the catalog.
+   */
+  void set_risk_manager(RiskManager* risk) { this->risk = risk; }
+
+  /**
+   * @brief Sizes cycles by, and books fills into, the given balances (nullptr detaches).
+   * A cycle then never commits more of its start currency than is held.
+   */
+  void set_inventory(Inventory* inventory) { this->inventory = inventory; }
+
+  /// @brief Verdict of the most recent pre-trade check.
+  RiskVerdict last_risk_verdict() const { return last_verdict; }
+
+  /**
+   * @brief Accounts for one execution report.
+   * @return True when the fill completes the in-flight cycle; `result` is then filled in.
+   */
+  bool on_fill(const Fill& fill, CycleResult& result);
+
+  bool in_flight() const { return legs_outstanding > 0; }
+
+private:
+  const PairCatalog& catalog;
+  ExchangeSimulator& simulator;
+  OrderGateway* gateway = nullptr;
+  RiskManager* risk = nullptr;
+  Inventory* inventory = nullptr;
+  int valuation_currency_id;
+  double notional;
+  double limit_tolerance;
+  /// @brief Pairs registered when the executor was built; `currency_deltas` covers their currencies.
+  int num_pairs;
+
+  uint64_t next_cycle_id = 1;
+  uint64_t next_order_id = 1;
+
+  /// @brief Orders of the cycle being planned, reused across cycles.
+  std::vector<Order> planned_orders;
+  double planned_gross_return = 0.0;
+
+  /// @brief Per-currency net movements of the in-flight cycle.
+  std::vector<double> currency_deltas;
+
+  int legs_outstanding = 0;
+  CycleResult current;
+
+  /// @brief Position reservation held by the in-flight cycle.
+  CycleRiskRequest reservation;
+  RiskVerdict last_verdict = RiskVerdict::Accepted;
+};
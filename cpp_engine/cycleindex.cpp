@@ -0,0 +1,412 @@
+/**
+ * @file cycleindex.cpp
+ * @brief Enumerates the directed triangles and anchored longer cycles of a market and indexes them by edge.
+ *
+ * @details
+ * Each triangle is found once from its smallest currency ID a, as a -> b -> c -> a
+ * over neighbours b and c of higher IDs; the opposite direction is found with b
+ * and c swapped. The cost is the sum over currencies of the degree products, which
+ * is small for exchange universes, where a few quote currencies carry most pairs.
+ *
+ * Longer cycles come from a depth-first walk out of each anchor that never
+ * revisits a currency and never enters an anchor with a lower ID, so a cycle
+ * through several anchors is only found from the lowest of them, once per
+ * direction. Without the anchor restriction the number of 5-cycles grows with
+ * the fourth power of the quote currencies' degree; with it, every indexed
+ * cycle is one that can start and end in a currency the desk holds.
+ *
+ * A newly listed pair u-v only adds cycles that use one of its edges, so
+ * `add_pair` walks simple paths of up to `max_length` - 1 legs from v back to u
+ * (and from u back to v) instead of repeating either search. Each cycle found is
+ * rotated to the start `build` would have given it: the lowest currency for a
+ * triangle, the lowest anchor otherwise. That keeps the legs in the same trading
+ * order and lets a returning cycle be matched against the retired ones by its
+ * slots.
+ */
+
+#include "cycleindex.h"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+/**
+ * @brief The slot of the listed edge from `source_id` to `destination_id`, or -1.
+ */
+int directed_slot(const PairCatalog& catalog, const std::pmr::vector<uint8_t>& listed, int source_id,
+                  int destination_id) {
+  int pair_id = catalog.find_pair(source_id, destination_id);
+  if (pair_id >= 0 && listed[pair_id]) {
+    return 2 * pair_id;
+  }
+  pair_id = catalog.find_pair(destination_id, source_id);
+  if (pair_id >= 0 && listed[pair_id]) {
+    return 2 * pair_id + 1;
+  }
+  return -1;
+}
+
+/**
+ * @brief The sorted, distinct currencies each currency shares a listed pair with.
+ */
+std::vector<std::vector<int>> listed_neighbours(const PairCatalog& catalog, const std::pmr::vector<uint8_t>& listed) {
+  std::vector<std::vector<int>> neighbours(catalog.num_currencies());
+  for (int pair_id = 0; pair_id < catalog.num_pairs(); pair_id++) {
+    if (listed[pair_id]) {
+      neighbours[catalog.base_id(pair_id)].push_back(catalog.quote_id(pair_id));
+      neighbours[catalog.quote_id(pair_id)].push_back(catalog.base_id(pair_id));
+    }
+  }
+  for (std::vector<int>& adjacent : neighbours) {
+    std::sort(adjacent.begin(), adjacent.end());
+    adjacent.erase(std::unique(adjacent.begin(), adjacent.end()), adjacent.end());
+  }
+  return neighbours;
+}
+
+/// @brief A cycle's edge slots padded with UINT32_MAX, to look cycles up by their legs.
+using CycleKey = std::array<uint32_t, CycleIndex::MAX_CYCLE_LENGTH>;
+
+CycleKey cycle_key(const uint32_t* slots, int length) {
+  CycleKey key;
+  key.fill(UINT32_MAX);
+  std::copy(slots, slots + length, key.begin());
+  return key;
+}
+
+}
+
+void CycleIndex::build(const PairCatalog& catalog, const std::pmr::vector<uint8_t>& listed, int max_length,
+                       const std::vector<int>& anchors) {
+  if (max_length < 3 || max_length > MAX_CYCLE_LENGTH) {
+    throw std::runtime_error("Indexed cycles must have 3 to " + std::to_string(MAX_CYCLE_LENGTH) + " legs, not " +
+                             std::to_string(max_length));
+  }
+
+  int num_currencies = catalog.num_currencies();
+  std::vector<std::vector<int>> neighbours = listed_neighbours(catalog, listed);
+  this->max_length = max_length;
+  is_anchor.assign(num_currencies, 0);
+  for (int anchor : anchors) {
+    if (anchor >= 0 && anchor < num_currencies) {
+      is_anchor[anchor] = 1;
+    }
+  }
+
+  cycle_slots.clear();
+  cycle_starts.assign(1, 0);
+  for (int a = 0; a < num_currencies; a++) {
+    for (int b : neighbours[a]) {
+      if (b < a) {
+        continue;
+      }
+      int ab = directed_slot(catalog, listed, a, b);
+      for (int c : neighbours[b]) {
+        if (c < a || c == b) {
+          continue;
+        }
+        int bc = directed_slot(catalog, listed, b, c);
+        int ca = directed_slot(catalog, listed, c, a);
+        if (ca < 0) {
+          continue;
+        }
+        uint32_t triangle[3] = {static_cast<uint32_t>(ab), static_cast<uint32_t>(bc), static_cast<uint32_t>(ca)};
+        add_cycle(triangle, 3);
+      }
+    }
+  }
+
+  if (max_length > 3) {
+    std::vector<uint8_t> on_path(num_currencies, 0);
+    int path[MAX_CYCLE_LENGTH];
+    uint32_t slots[MAX_CYCLE_LENGTH];
+
+    /* Extends path[0..length) by one currency at a time, closing back to the anchor from 4 legs up */
+    auto extend = [&](auto&& self, int length) -> void {
+      int last = path[length - 1];
+      if (length >= 4) {
+        int closing = directed_slot(catalog, listed, last, path[0]);
+        if (closing >= 0) {
+          slots[length - 1] = static_cast<uint32_t>(closing);
+          add_cycle(slots, length);
+        }
+      }
+      /* max_length never exceeds MAX_CYCLE_LENGTH; the second test lets the compiler see the arrays' bound */
+      if (length >= max_length || length >= MAX_CYCLE_LENGTH) {
+        return;
+      }
+      for (int next : neighbours[last]) {
+        if (on_path[next] || (is_anchor[next] && next < path[0])) {
+          continue;
+        }
+        slots[length - 1] = static_cast<uint32_t>(directed_slot(catalog, listed, last, next));
+        path[length] = next;
+        on_path[next] = 1;
+        self(self, length + 1);
+        on_path[next] = 0;
+      }
+    };
+    for (int anchor = 0; anchor < num_currencies; anchor++) {
+      if (is_anchor[anchor]) {
+        path[0] = anchor;
+        on_path[anchor] = 1;
+        extend(extend, 1);
+        on_path[anchor] = 0;
+      }
+    }
+  }
+
+  /* Inverted index: count cycles per slot, prefix-sum into offsets, then fill; runs start out full */
+  size_t num_slots = 2 * listed.size();
+  slot_starts.assign(num_slots + 1, 0);
+  for (uint32_t slot : cycle_slots) {
+    slot_starts[slot + 1]++;
+  }
+  for (size_t slot = 0; slot < num_slots; slot++) {
+    slot_starts[slot + 1] += slot_starts[slot];
+  }
+  slot_cycles.resize(cycle_slots.size());
+  slot_ends.assign(slot_starts.begin(), slot_starts.end() - 1);
+  for (int cycle = 0; cycle < num_cycles(); cycle++) {
+    for (uint32_t i = cycle_starts[cycle]; i < cycle_starts[cycle + 1]; i++) {
+      slot_cycles[slot_ends[cycle_slots[i]]++] = static_cast<uint32_t>(cycle);
+    }
+  }
+  slot_starts.pop_back();
+  slot_limits.assign(slot_ends.begin(), slot_ends.end());
+  live.assign(num_cycles(), 1);
+
+  /* Equal margins already form a heap, in cycle order */
+  margins.assign(num_cycles(), -std::numeric_limits<double>::infinity());
+  ranking.resize(num_cycles());
+  rank_positions.resize(num_cycles());
+  for (int cycle = 0; cycle < num_cycles(); cycle++) {
+    ranking[cycle] = static_cast<uint32_t>(cycle);
+    rank_positions[cycle] = static_cast<uint32_t>(cycle);
+  }
+}
+
+void CycleIndex::add_pair(const PairCatalog& catalog, const std::pmr::vector<uint8_t>& listed, int pair_id) {
+  std::vector<std::vector<int>> neighbours = listed_neighbours(catalog, listed);
+
+  /* Cycles indexed through the pair before, so that returning ones are not added twice */
+  std::map<CycleKey, uint32_t> known;
+  for (uint32_t slot : {static_cast<uint32_t>(2 * pair_id), static_cast<uint32_t>(2 * pair_id + 1)}) {
+    for (const uint32_t* cycle = cycles_begin(slot); cycle != cycles_end(slot); cycle++) {
+      known.emplace(cycle_key(cycle_edges(static_cast<int>(*cycle)), cycle_length(static_cast<int>(*cycle))), *cycle);
+    }
+  }
+
+  int num_currencies = catalog.num_currencies();
+
+  /* Each walked currency's neighbours with the slot leading to them, looked up once, on first visit */
+  std::vector<std::vector<std::pair<int, uint32_t>>> steps(num_currencies);
+  std::vector<uint8_t> stepped(num_currencies, 0);
+  auto steps_from = [&](int currency) -> const std::vector<std::pair<int, uint32_t>>& {
+    if (!stepped[currency]) {
+      for (int next : neighbours[currency]) {
+        steps[currency].emplace_back(next, static_cast<uint32_t>(directed_slot(catalog, listed, currency, next)));
+      }
+      stepped[currency] = 1;
+    }
+    return steps[currency];
+  };
+
+  std::vector<uint8_t> on_path(num_currencies, 0);
+  /* Slot from each neighbour of the walk's start back to it, or -1 */
+  std::vector<int> closing(num_currencies, -1);
+  int path[MAX_CYCLE_LENGTH];
+  uint32_t slots[MAX_CYCLE_LENGTH];
+
+  /* Indexes the cycle path[0..length) in the rotation build gives it */
+  auto emit = [&](int length) {
+    int start = -1;
+    for (int i = 0; i < length; i++) {
+      /* Currencies listed after the build are never anchors */
+      bool candidate = length == 3 || (static_cast<size_t>(path[i]) < is_anchor.size() && is_anchor[path[i]]);
+      if (candidate && (start < 0 || path[i] < path[start])) {
+        start = i;
+      }
+    }
+    if (start < 0) {
+      return;
+    }
+    uint32_t rotated[MAX_CYCLE_LENGTH];
+    for (int i = 0; i < length; i++) {
+      rotated[i] = slots[(start + i) % length];
+    }
+    auto found = known.find(cycle_key(rotated, length));
+    if (found == known.end()) {
+      insert_cycle(rotated, length);
+    } else {
+      live[found->second] = 1;
+    }
+  };
+
+  /* Extends path[0..length), which starts with the new edge, until it can close back to path[0] */
+  auto extend = [&](auto&& self, int length) -> void {
+    int last = path[length - 1];
+    if (length >= 3 && closing[last] >= 0) {
+      slots[length - 1] = static_cast<uint32_t>(closing[last]);
+      emit(length);
+    }
+    if (length >= max_length || length >= MAX_CYCLE_LENGTH) {
+      return;
+    }
+    /* The last currency of a cycle must be next to the start */
+    bool last_leg = length + 1 == max_length;
+    for (const std::pair<int, uint32_t>& step : steps_from(last)) {
+      if (on_path[step.first] || (last_leg && closing[step.first] < 0)) {
+        continue;
+      }
+      slots[length - 1] = step.second;
+      path[length] = step.first;
+      on_path[step.first] = 1;
+      self(self, length + 1);
+      on_path[step.first] = 0;
+    }
+  };
+
+  int base_id = catalog.base_id(pair_id);
+  int quote_id = catalog.quote_id(pair_id);
+  for (int direction = 0; direction < 2; direction++) {
+    int source_id = direction == 0 ? base_id : quote_id;
+    int destination_id = direction == 0 ? quote_id : base_id;
+    /* A pair listed under both orientations: build routes this direction through the other one */
+    if (directed_slot(catalog, listed, source_id, destination_id) != 2 * pair_id + direction) {
+      continue;
+    }
+    for (int neighbour : neighbours[source_id]) {
+      closing[neighbour] = directed_slot(catalog, listed, neighbour, source_id);
+    }
+    path[0] = source_id;
+    path[1] = destination_id;
+    slots[0] = static_cast<uint32_t>(2 * pair_id + direction);
+    on_path[source_id] = 1;
+    on_path[destination_id] = 1;
+    extend(extend, 2);
+    on_path[source_id] = 0;
+    on_path[destination_id] = 0;
+    for (int neighbour : neighbours[source_id]) {
+      closing[neighbour] = -1;
+    }
+  }
+}
+
+void CycleIndex::remove_pair(int pair_id) {
+  for (uint32_t slot : {static_cast<uint32_t>(2 * pair_id), static_cast<uint32_t>(2 * pair_id + 1)}) {
+    for (const uint32_t* cycle = cycles_begin(slot); cycle != cycles_end(slot); cycle++) {
+      rerank(static_cast<int>(*cycle), -std::numeric_limits<double>::infinity());
+      live[*cycle] = 0;
+    }
+  }
+}
+
+void CycleIndex::add_cycle(const uint32_t* slots, int length) {
+  cycle_slots.insert(cycle_slots.end(), slots, slots + length);
+  cycle_starts.push_back(static_cast<uint32_t>(cycle_slots.size()));
+}
+
+void CycleIndex::insert_cycle(const uint32_t* slots, int length) {
+  uint32_t cycle = static_cast<uint32_t>(num_cycles());
+  add_cycle(slots, length);
+  live.push_back(1);
+  /* -infinity is a valid leaf under any parent */
+  margins.push_back(-std::numeric_limits<double>::infinity());
+  rank_positions.push_back(static_cast<uint32_t>(ranking.size()));
+  ranking.push_back(cycle);
+  for (int i = 0; i < length; i++) {
+    push_slot_cycle(slots[i], cycle);
+  }
+}
+
+void CycleIndex::push_slot_cycle(uint32_t slot, uint32_t cycle) {
+  if (slot_ends[slot] == slot_limits[slot]) {
+    uint32_t count = slot_ends[slot] - slot_starts[slot];
+    uint32_t start = static_cast<uint32_t>(slot_cycles.size());
+    slot_cycles.resize(start + std::max<uint32_t>(4, 2 * count));
+    std::copy(slot_cycles.begin() + slot_starts[slot], slot_cycles.begin() + slot_ends[slot],
+              slot_cycles.begin() + start);
+    slot_starts[slot] = start;
+    slot_ends[slot] = start + count;
+    slot_limits[slot] = static_cast<uint32_t>(slot_cycles.size());
+  }
+  slot_cycles[slot_ends[slot]++] = cycle;
+}
+
+void CycleIndex::rerank(int cycle, double margin) {
+  if (!live[cycle]) {
+    return;
+  }
+  double previous = margins[cycle];
+  margins[cycle] = margin;
+  if (margin > previous) {
+    sift_up(rank_positions[cycle]);
+  } else if (margin < previous) {
+    sift_down(rank_positions[cycle]);
+  }
+}
+
+/**
+ * @brief Moves the cycle at `position` towards the root past every parent with a smaller margin.
+ */
+void CycleIndex::sift_up(size_t position) {
+  uint32_t cycle = ranking[position];
+  double margin = margins[cycle];
+  while (position > 0) {
+    size_t parent = (position - 1) / HEAP_ARITY;
+    if (!(margins[ranking[parent]] < margin)) {
+      break;
+    }
+    ranking[position] = ranking[parent];
+    rank_positions[ranking[position]] = static_cast<uint32_t>(position);
+    position = parent;
+  }
+  ranking[position] = cycle;
+  rank_positions[cycle] = static_cast<uint32_t>(position);
+}
+
+/**
+ * @brief Moves the cycle at `position` towards the leaves past every child with a larger margin.
+ */
+void CycleIndex::sift_down(size_t position) {
+  size_t size = ranking.size();
+  if (position >= size) {
+    return;
+  }
+  uint32_t cycle = ranking[position];
+  double margin = margins[cycle];
+  while (true) {
+    size_t first_child = position * HEAP_ARITY + 1;
+    if (first_child >= size) {
+      break;
+    }
+    size_t best_child = first_child;
+    size_t last_child = std::min(first_child + HEAP_ARITY, size);
+    for (size_t child = first_child + 1; child < last_child; child++) {
+      if (margins[ranking[child]] > margins[ranking[best_child]]) {
+        best_child = child;
+      }
+    }
+    if (!(margins[ranking[best_child]] > margin)) {
+      break;
+    }
+    ranking[position] = ranking[best_child];
+    rank_positions[ranking[position]] = static_cast<uint32_t>(position);
+    position = best_child;
+  }
+  ranking[position] = cycle;
+  rank_positions[cycle] = static_cast<uint32_t>(position);
+}
+
+size_t CycleIndex::memory_bytes() const {
+  return sizeof(uint32_t) * (cycle_slots.capacity() + cycle_starts.capacity() + slot_cycles.capacity() +
+                             slot_starts.capacity() + slot_ends.capacity() + slot_limits.capacity() +
+                             ranking.capacity() + rank_positions.capacity()) +
+         sizeof(double) * margins.capacity() + live.capacity() + is_anchor.capacity();
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory_resource>
+#include <vector>
+
+#include "paircatalog.h"
+
+/**
+ * @class CycleIndex
+ * @brief Every directed triangle of a market, and optionally every simple 4- and 5-leg cycle
+ * through a set of anchor currencies, as edge slots with an edge -> cycle inverted index.
+ *
+ * Cycles are stored back to back in one array of edge slots (see `Opportunity`
+ * for the slot layout) in trading order, and the cycles through each edge slot
+ * in a second array, one run per slot, so a price update reaches exactly the
+ * cycles it can change. Building allocates and takes tens of milliseconds for
+ * 5-leg cycles, so listing changes are applied in place instead: `remove_pair`
+ * retires the cycles through a pair and `add_pair` enumerates only the cycles
+ * through the new pair's two edges, bringing back retired ones rather than
+ * duplicating them. Each slot's run keeps spare room and moves to the end of the
+ * array when it fills up, so runs stay contiguous.
+ *
+ * The index also ranks its cycles by a caller-supplied margin in a 4-ary max-heap
+ * kept in flat arrays, with each cycle's heap position stored next to it, so the
+ * best cycle is read in O(1) and re-ranking one cycle costs O(log cycles).
+ */
+class CycleIndex {
+public:
+  /**
+   * @param memory Where the index arrays are allocated; the scratch used while building comes from the heap.
+   */
+  explicit CycleIndex(std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+    : cycle_slots(memory), cycle_starts(memory), live(memory), slot_cycles(memory), slot_starts(memory),
+      slot_ends(memory), slot_limits(memory), is_anchor(memory), margins(memory), ranking(memory),
+      rank_positions(memory) {}
+
+  /**
+   * @brief Rebuilds the index over the pairs flagged in `listed`; every cycle starts ranked at -infinity.
+   * @param listed Listing flag of every pair ID; its size fixes the number of edge slots indexed.
+   * @param max_length Longest cycle indexed, 3 to `MAX_CYCLE_LENGTH`; cycles longer than 3 must visit an anchor.
+   * @param anchors Currency IDs that longer cycles are routed through (stablecoins, fiat, majors).
+   * @throws std::runtime_error if `max_length` is out of range.
+   */
+  void build(const PairCatalog& catalog, const std::pmr::vector<uint8_t>& listed, int max_length = 3,
+             const std::vector<int>& anchors = {});
+
+  /**
+   * @brief Indexes the cycles through a pair that has just been flagged in `listed`, with the
+   * length limit and anchors of the last `build`.
+   *
+   * Costs a walk of up to `max_length` - 1 legs out of each of the pair's edges,
+   * not a rebuild. Cycles retired by `remove_pair` come back under their old
+   * numbers. New and returning cycles rank at -infinity until re-ranked.
+   */
+  void add_pair(const PairCatalog& catalog, const std::pmr::vector<uint8_t>& listed, int pair_id);
+
+  /**
+   * @brief Retires every cycle through a pair's two edges: each drops to the bottom of the ranking
+   * and ignores `rerank` until `add_pair` brings it back.
+   */
+  void remove_pair(int pair_id);
+
+  static constexpr int MAX_CYCLE_LENGTH = 5;
+
+  /// @brief Cycles ever indexed since the last build, retired ones included; numbers run from 0.
+  int num_cycles() const { return static_cast<int>(cycle_starts.size()) - 1; }
+
+  /// @brief False for a cycle retired by `remove_pair`; its slots still list it.
+  bool is_live(int cycle) const { return live[cycle] != 0; }
+
+  int cycle_length(int cycle) const { return static_cast<int>(cycle_starts[cycle + 1] - cycle_starts[cycle]); }
+
+  /// @brief Edge slots of a cycle in trading order.
+  const uint32_t* cycle_edges(int cycle) const { return cycle_slots.data() + cycle_starts[cycle]; }
+
+  /// @brief The cycles through an edge slot, retired ones included, as [cycles_begin, cycles_end).
+  const uint32_t* cycles_begin(uint32_t slot) const { return slot_cycles.data() + slot_starts[slot]; }
+  const uint32_t* cycles_end(uint32_t slot) const { return slot_cycles.data() + slot_ends[slot]; }
+
+  /**
+   * @brief Sets every live cycle's margin to `margin_of(cycle)` and re-ranks them all, in O(cycles).
+   */
+  template <typename MarginOf>
+  void rank_all(MarginOf margin_of);
+
+  /**
+   * @brief Moves a cycle to its rank for a new margin, in O(log cycles); retired cycles stay where they are.
+   */
+  void rerank(int cycle, double margin);
+
+  /// @brief The cycle with the largest margin, or -1 if there are none.
+  int best_cycle() const { return ranking.empty() ? -1 : static_cast<int>(ranking[0]); }
+
+  /// @brief The margin a cycle was last ranked with.
+  double ranked_margin(int cycle) const { return margins[cycle]; }
+
+  /// @brief Bytes held by the index and ranking arrays.
+  size_t memory_bytes() const;
+
+private:
+  /// @brief Edge slots of every cycle, back to back.
+  std::pmr::vector<uint32_t> cycle_slots;
+
+  /// @brief Offset of each cycle in `cycle_slots`, plus the end of the last one.
+  std::pmr::vector<uint32_t> cycle_starts;
+
+  /// @brief 1 for each cycle whose pairs are all listed.
+  std::pmr::vector<uint8_t> live;
+
+  /// @brief Cycle numbers grouped by edge slot, each slot's run followed by its spare room.
+  std::pmr::vector<uint32_t> slot_cycles;
+
+  /// @brief Each edge slot's run in `slot_cycles`: [start, end), with room up to the limit.
+  std::pmr::vector<uint32_t> slot_starts;
+  std::pmr::vector<uint32_t> slot_ends;
+  std::pmr::vector<uint32_t> slot_limits;
+
+  /// @brief Settings of the last build, reused by `add_pair`.
+  int max_length = 3;
+  std::pmr::vector<uint8_t> is_anchor;
+
+  /// @brief Children per node of the ranking heap; four share a cache line of positions.
+  static constexpr size_t HEAP_ARITY = 4;
+
+  /// @brief Last ranked margin of each cycle.
+  std::pmr::vector<double> margins;
+
+  /// @brief Cycle numbers in heap order, largest margin first.
+  std::pmr::vector<uint32_t> ranking;
+
+  /// @brief Position of each cycle in `ranking`.
+  std::pmr::vector<uint32_t> rank_positions;
+
+  /// @brief Appends one cycle given as its edge slots.
+  void add_cycle(const uint32_t* slots, int length);
+
+  /// @brief Appends a cycle after the build: unranked at the bottom of the heap and listed under its slots.
+  void insert_cycle(const uint32_t* slots, int length);
+
+  /// @brief Adds a cycle to a slot's run, moving the run to the end of `slot_cycles` with twice the room if full.
+  void push_slot_cycle(uint32_t slot, uint32_t cycle);
+
+  void sift_up(size_t position);
+  void sift_down(size_t position);
+};
+
+template <typename MarginOf>
+void CycleIndex::rank_all(MarginOf margin_of) {
+  for (int cycle = 0; cycle < num_cycles(); cycle++) {
+    margins[cycle] = live[cycle] ? margin_of(cycle) : -std::numeric_limits<double>::infinity();
+  }
+  /* Floyd's heap construction: sift every internal node down, deepest first */
+  for (size_t position = ranking.size() / HEAP_ARITY + 1; position-- > 0;) {
+    sift_down(position);
+  }
+}
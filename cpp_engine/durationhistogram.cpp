@@ -0,0 +1,56 @@
+/**
+ * @file durationhistogram.cpp
+ * @brief Implements the log2-bucketed duration histogram.
+ */
+
+#include "durationhistogram.h"
+
+void DurationHistogram::add(int64_t duration_ns) {
+  int bucket = 0;
+  uint64_t micros = duration_ns > 0 ? static_cast<uint64_t>(duration_ns / 1000) : 0;
+  while (micros != 0 && bucket < NUM_BUCKETS - 1) {
+    micros >>= 1;
+    bucket++;
+  }
+  counts[bucket]++;
+  total++;
+}
+
+void DurationHistogram::merge(const DurationHistogram& other) {
+  for (int b = 0; b < NUM_BUCKETS; b++) {
+    counts[b] += other.counts[b];
+  }
+  total += other.total;
+}
+
+int64_t DurationHistogram::bucket_upper_ns(int bucket) {
+  return (1LL << bucket) * 1000;
+}
+
+int64_t DurationHistogram::quantile_ns(double q) const {
+  if (total == 0) {
+    return 0;
+  }
+  uint64_t rank = static_cast<uint64_t>(q * (total - 1));
+  uint64_t seen = 0;
+  for (int b = 0; b < NUM_BUCKETS; b++) {
+    seen += counts[b];
+    if (seen > rank) {
+      return bucket_upper_ns(b);
+    }
+  }
+  return bucket_upper_ns(NUM_BUCKETS - 1);
+}
+
+double DurationHistogram::survival(int64_t duration_ns) const {
+  if (total == 0) {
+    return 0.0;
+  }
+  uint64_t surviving = 0;
+  for (int b = 1; b < NUM_BUCKETS; b++) {
+    if (bucket_upper_ns(b - 1) >= duration_ns) {
+      surviving += counts[b];
+    }
+  }
+  return static_cast<double>(surviving) / total;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * @struct DurationHistogram
+ * @brief Log2-bucketed histogram of durations.
+ *
+ * Bucket 0 holds durations under 1us; bucket b > 0 holds [2^(b-1), 2^b) microseconds.
+ */
+struct DurationHistogram {
+  static constexpr int NUM_BUCKETS = 40;
+
+  uint64_t counts[NUM_BUCKETS] = {};
+  uint64_t total = 0;
+
+  void add(int64_t duration_ns);
+  void merge(const DurationHistogram& other);
+
+  /// @brief Upper edge of the bucket holding quantile `q` in [0, 1], or 0 if empty.
+  int64_t quantile_ns(double q) const;
+
+  /// @brief Fraction of durations that certainly reach `duration_ns` (buckets entirely at or above it).
+  double survival(int64_t duration_ns) const;
+
+  static int64_t bucket_upper_ns(int bucket);
+};
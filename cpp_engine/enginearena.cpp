@@ -0,0 +1,204 @@
+/**
+ * @file enginearena.cpp
+ * @brief Implements the per-engine arena: the mapping, NUMA placement, size classes and accounts.
+ *
+ * @details
+ * The region is reserved with one mmap. With huge pages requested, an explicit
+ * hugetlbfs mapping is tried first; it reserves pool pages for the whole capacity
+ * up front, so it either succeeds or fails cleanly instead of faulting later. The
+ * fallback is an ordinary mapping aligned to 2 MiB and advised with MADV_HUGEPAGE.
+ * NUMA placement uses the raw getcpu and mbind system calls with MPOL_PREFERRED,
+ * so it needs no libnuma and never turns a full node into an allocation failure.
+ * Both are best effort: `backing` and `numa_node` report what was obtained.
+ */
+
+#include "enginearena.h"
+
+#include <algorithm>
+#include <new>
+#include <stdexcept>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr size_t HUGE_PAGE = size_t{2} << 20;
+
+/// @brief MPOL_PREFERRED from <linux/mempolicy.h>.
+constexpr int PREFERRED_NODE_POLICY = 1;
+
+size_t round_up(size_t value, size_t multiple) {
+  return (value + multiple - 1) / multiple * multiple;
+}
+
+char* align_up(char* pointer, size_t alignment) {
+  uintptr_t address = reinterpret_cast<uintptr_t>(pointer);
+  return reinterpret_cast<char*>((address + alignment - 1) & ~(uintptr_t{alignment} - 1));
+}
+
+}
+
+/**
+ * @class EngineArena::Account
+ * @brief A named view of the arena that counts what its structure allocates.
+ */
+class EngineArena::Account : public std::pmr::memory_resource {
+public:
+  Account(EngineArena& arena, const std::string& name) : arena(arena) { this->usage.name = name; }
+
+  ArenaUsage usage;
+
+private:
+  EngineArena& arena;
+
+  void* do_allocate(size_t bytes, size_t alignment) override {
+    void* block = arena.allocate(bytes, alignment);
+    usage.bytes += bytes;
+    usage.peak_bytes = std::max(usage.peak_bytes, usage.bytes);
+    usage.allocations++;
+    return block;
+  }
+
+  void do_deallocate(void* block, size_t bytes, size_t alignment) override {
+    arena.deallocate(block, bytes, alignment);
+    usage.bytes -= bytes;
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+};
+
+EngineArena::EngineArena(const ArenaConfig& config) {
+  size_t capacity = round_up(std::max<size_t>(config.capacity_bytes, HUGE_PAGE), HUGE_PAGE);
+
+  void* mapped = MAP_FAILED;
+#ifdef MAP_HUGETLB
+  if (config.huge_pages) {
+    mapped = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (mapped != MAP_FAILED) {
+      this->mapping = static_cast<char*>(mapped);
+      this->mapping_bytes = capacity;
+      this->region = this->mapping;
+      this->backing_kind = ArenaBacking::HugeTlbPages;
+    }
+  }
+#endif
+  if (mapped == MAP_FAILED) {
+    /* One spare huge page of address space lets the region start on a 2 MiB boundary */
+    mapped = mmap(nullptr, capacity + HUGE_PAGE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                  -1, 0);
+    if (mapped == MAP_FAILED) {
+      throw std::runtime_error("Failed to reserve " + std::to_string(capacity) + " bytes for the engine arena");
+    }
+    this->mapping = static_cast<char*>(mapped);
+    this->mapping_bytes = capacity + HUGE_PAGE;
+    this->region = align_up(this->mapping, HUGE_PAGE);
+#ifdef MADV_HUGEPAGE
+    if (config.huge_pages && madvise(this->region, capacity, MADV_HUGEPAGE) == 0) {
+      this->backing_kind = ArenaBacking::TransparentHugePages;
+    }
+#endif
+  }
+  this->next = this->region;
+  this->end = this->region + capacity;
+
+#if defined(SYS_getcpu) && defined(SYS_mbind)
+  /* Nothing has been touched yet, so every page will be placed by the policy */
+  unsigned cpu = 0;
+  unsigned local_node = 0;
+  if (config.bind_to_local_node && syscall(SYS_getcpu, &cpu, &local_node, nullptr) == 0 && local_node < 64) {
+    unsigned long node_mask = 1UL << local_node;
+    if (syscall(SYS_mbind, this->region, capacity, PREFERRED_NODE_POLICY, &node_mask, 8 * sizeof(node_mask) + 1,
+                0) == 0) {
+      this->node = static_cast<int>(local_node);
+    }
+  }
+#endif
+}
+
+EngineArena::~EngineArena() {
+  munmap(mapping, mapping_bytes);
+}
+
+std::pmr::memory_resource* EngineArena::resource(const std::string& name) {
+  for (const std::unique_ptr<Account>& account : accounts) {
+    if (account->usage.name == name) {
+      return account.get();
+    }
+  }
+  accounts.push_back(std::make_unique<Account>(*this, name));
+  return accounts.back().get();
+}
+
+std::vector<ArenaUsage> EngineArena::usage() const {
+  std::vector<ArenaUsage> all;
+  for (const std::unique_ptr<Account>& account : accounts) {
+    all.push_back(account->usage);
+  }
+  return all;
+}
+
+void* EngineArena::bump(size_t bytes, size_t alignment) {
+  char* block = align_up(next, alignment);
+  if (block > end || static_cast<size_t>(end - block) < bytes) {
+    throw std::bad_alloc();
+  }
+  next = block + bytes;
+  return block;
+}
+
+/**
+ * @brief Hands out a block from a size class or, above 64 KiB, a page-aligned run.
+ *
+ * A small block's class is the request rounded up to a power of two and to its
+ * alignment, and blocks are aligned to their size up to a cache line, so any
+ * block on a free list satisfies any request that maps to its class.
+ */
+void* EngineArena::allocate(size_t bytes, size_t alignment) {
+  size_t block_size = std::max({bytes, alignment, MIN_BLOCK});
+  if (block_size <= MAX_SMALL_BLOCK && alignment <= 64) {
+    int size_class = 64 - __builtin_clzll(block_size - 1) - 4;
+    if (free_lists[size_class] != nullptr) {
+      void* block = free_lists[size_class];
+      free_lists[size_class] = *static_cast<void**>(block);
+      return block;
+    }
+    size_t class_bytes = MIN_BLOCK << size_class;
+    return bump(class_bytes, std::min<size_t>(class_bytes, 64));
+  }
+
+  if (alignment > PAGE) {
+    throw std::bad_alloc();
+  }
+  size_t run = round_up(bytes, PAGE);
+  for (size_t i = 0; i < free_large.size(); i++) {
+    if (free_large[i].second >= run) {
+      char* block = free_large[i].first;
+      if (free_large[i].second == run) {
+        free_large[i] = free_large.back();
+        free_large.pop_back();
+      } else {
+        free_large[i].first += run;
+        free_large[i].second -= run;
+      }
+      return block;
+    }
+  }
+  return bump(run, PAGE);
+}
+
+void EngineArena::deallocate(void* block, size_t bytes, size_t alignment) {
+  size_t block_size = std::max({bytes, alignment, MIN_BLOCK});
+  if (block_size <= MAX_SMALL_BLOCK && alignment <= 64) {
+    int size_class = 64 - __builtin_clzll(block_size - 1) - 4;
+    *static_cast<void**>(block) = free_lists[size_class];
+    free_lists[size_class] = block;
+    return;
+  }
+  free_large.emplace_back(static_cast<char*>(block), round_up(bytes, PAGE));
+}
+
+std::pmr::memory_resource* arena_resource(EngineArena* arena, const std::string& name) {
+  return arena != nullptr ? arena->resource(name) : std::pmr::get_default_resource();
+}
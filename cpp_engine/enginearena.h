@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief What backs an EngineArena's region.
+ */
+enum class ArenaBacking {
+  Pages,                 ///< Ordinary 4 KiB pages.
+  TransparentHugePages,  ///< An ordinary mapping advised for 2 MiB pages, which the kernel promotes when it can.
+  HugeTlbPages           ///< Explicit 2 MiB pages from the hugetlbfs pool.
+};
+
+/**
+ * @struct ArenaConfig
+ * @brief How an EngineArena reserves its region.
+ */
+struct ArenaConfig {
+  /// @brief Address space reserved up front; ordinary and transparent huge pages are only committed when touched.
+  size_t capacity_bytes = size_t{256} << 20;
+  /// @brief Try 2 MiB pages: the hugetlbfs pool first (which must hold the whole capacity), then transparent ones.
+  bool huge_pages = true;
+  /// @brief Prefer the NUMA node of the constructing thread for every page of the region.
+  bool bind_to_local_node = true;
+};
+
+/**
+ * @struct ArenaUsage
+ * @brief Footprint of one named structure carved from an EngineArena.
+ */
+struct ArenaUsage {
+  std::string name;
+  /// @brief Bytes currently allocated, as requested by the structure.
+  size_t bytes = 0;
+  size_t peak_bytes = 0;
+  uint64_t allocations = 0;
+};
+
+/**
+ * @class EngineArena
+ * @brief One memory region per engine instance, from which its data structures are carved.
+ *
+ * The region is a single mapping, so the engine's hot state sits in a few (huge)
+ * pages instead of being scattered over the general heap, and it can be placed on
+ * the NUMA node of the thread that owns the engine. Structures allocate through
+ * named `std::pmr::memory_resource` accounts, which keep the per-structure
+ * footprint reported by `usage`.
+ *
+ * Blocks up to 64 KiB come from power-of-two size classes whose freed blocks are
+ * kept on intrusive free lists, so containers that churn (a deque's chunks, a
+ * rebuilt index) reuse memory instead of exhausting the region; larger blocks are
+ * page-aligned and reused first-fit. Running out of space throws `std::bad_alloc`.
+ *
+ * Not thread-safe: an arena belongs to the thread that runs its engine, and must
+ * outlive every structure allocated from it.
+ */
+class EngineArena {
+public:
+  /**
+   * @throws std::runtime_error if the region cannot be mapped at all.
+   */
+  explicit EngineArena(const ArenaConfig& config = ArenaConfig());
+  ~EngineArena();
+
+  EngineArena(const EngineArena&) = delete;
+  EngineArena& operator=(const EngineArena&) = delete;
+
+  /**
+   * @brief The resource that allocates from this arena on behalf of `name`.
+   * Asking for the same name again returns the same resource.
+   */
+  std::pmr::memory_resource* resource(const std::string& name);
+
+  /// @brief Footprint of every named structure, in the order they were first requested.
+  std::vector<ArenaUsage> usage() const;
+
+  /// @brief Bytes of the region handed out so far, including size-class rounding and free blocks.
+  size_t reserved_bytes() const { return static_cast<size_t>(next - region); }
+  size_t capacity_bytes() const { return static_cast<size_t>(end - region); }
+
+  ArenaBacking backing() const { return backing_kind; }
+
+  /// @brief The NUMA node the region prefers, or -1 if it was not bound.
+  int numa_node() const { return node; }
+
+private:
+  class Account;
+
+  static constexpr size_t MIN_BLOCK = 16;
+  static constexpr int NUM_SIZE_CLASSES = 13;
+  static constexpr size_t MAX_SMALL_BLOCK = MIN_BLOCK << (NUM_SIZE_CLASSES - 1);
+  static constexpr size_t PAGE = 4096;
+
+  char* mapping = nullptr;
+  size_t mapping_bytes = 0;
+  char* region = nullptr;
+  char* next = nullptr;
+  char* end = nullptr;
+  ArenaBacking backing_kind = ArenaBacking::Pages;
+  int node = -1;
+
+  /// @brief Heads of the intrusive free lists, one per size class of MIN_BLOCK << k bytes.
+  void* free_lists[NUM_SIZE_CLASSES] = {};
+
+  /// @brief Freed large blocks as (address, size).
+  std::vector<std::pair<char*, size_t>> free_large;
+
+  std::vector<std::unique_ptr<Account>> accounts;
+
+  void* allocate(size_t bytes, size_t alignment);
+  void deallocate(void* block, size_t bytes, size_t alignment);
+  void* bump(size_t bytes, size_t alignment);
+};
+
+/**
+ * @brief The arena's resource `name`, or the default heap resource if `arena` is null.
+ */
+std::pmr::memory_resource* arena_resource(EngineArena* arena, const std::string& name);
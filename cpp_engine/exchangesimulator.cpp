@@ -0,0 +1,256 @@
+/**
+ * @file exchangesimulator.cpp
+ * @brief Implements the local simulated exchange used for tick-to-fill measurement.
+ *
+ * @details
+ * The simulator is deliberately simple: it is an accounting device, not a model of
+ * a specific venue. Orders are IOC only, so there is no resting liquidity of our
+ * own to track, and the only sources of slippage are (a) the book moving between
+ * the triggering tick and the order's arrival, which is what the latency model
+ * controls, and (b) liquidity that competing flow is assumed to take first, which
+ * is what the queue-position rule controls. Liquidity our own orders consume is
+ * removed from the book until the next market data update for that pair.
+ */
+
+#include "exchangesimulator.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+/**
+ * @brief Draws one latency sample, in nanoseconds, from the configured distribution.
+ */
+int64_t LatencyModel::sample(std::mt19937_64& rng) const {
+  double latency_ns = 0.0;
+  switch (distribution) {
+    case LatencyDistribution::Constant:
+      latency_ns = param_a;
+      break;
+    case LatencyDistribution::Uniform:
+      latency_ns = std::uniform_real_distribution<double>(param_a, param_b)(rng);
+      break;
+    case LatencyDistribution::LogNormal:
+      latency_ns = param_a > 0.0 ? std::lognormal_distribution<double>(std::log(param_a), param_b)(rng) : 0.0;
+      break;
+  }
+  return static_cast<int64_t>(std::max(0.0, latency_ns));
+}
+
+ExchangeSimulator::ExchangeSimulator(const PairCatalog& catalog, const SimulatorConfig& config)
+  : catalog(catalog), config(config), rng(config.seed) {
+  this->books.resize(catalog.num_pairs());
+  this->balances.resize(catalog.num_currencies(), 0.0);
+}
+
+void ExchangeSimulator::check_pair(int pair_id) const {
+  if (pair_id < 0 || pair_id >= static_cast<int>(books.size())) {
+    throw std::out_of_range("Pair " + std::to_string(pair_id) + " was registered after the exchange simulator was built");
+  }
+}
+
+void ExchangeSimulator::on_trade(int pair_id, double price, double quantity, int64_t ts_ns) {
+  check_pair(pair_id);
+  Book& book = books[pair_id];
+  double half_spread = config.synthetic_half_spread_bps * 1e-4;
+  double size = quantity * config.synthetic_depth_multiplier;
+
+  book.bids.assign(1, {price * (1.0 - half_spread), size});
+  book.asks.assign(1, {price * (1.0 + half_spread), size});
+  current_ts_ns = std::max(current_ts_ns, ts_ns);
+}
+
+void ExchangeSimulator::on_top_of_book(int pair_id, OrderSide side, double price, double size, int64_t ts_ns) {
+  check_pair(pair_id);
+  std::vector<Level>& levels = side == OrderSide::Buy ? books[pair_id].bids : books[pair_id].asks;
+  if (size > 0.0) {
+    levels.assign(1, {price, size});
+  } else {
+    levels.clear();
+  }
+  current_ts_ns = std::max(current_ts_ns, ts_ns);
+}
+
+void ExchangeSimulator::on_book_level(int pair_id, OrderSide side, double price, double size, int64_t ts_ns) {
+  check_pair(pair_id);
+  std::vector<Level>& levels = side == OrderSide::Buy ? books[pair_id].bids : books[pair_id].asks;
+
+  /* Bids are kept descending and asks ascending, so "better" means "comes first" */
+  auto better = [side](const Level& level, double p) {
+    return side == OrderSide::Buy ? level.price > p : level.price < p;
+  };
+  auto iter = std::lower_bound(levels.begin(), levels.end(), price, better);
+
+  if (iter != levels.end() && iter->price == price) {
+    if (size > 0.0) {
+      iter->size = size;
+    } else {
+      levels.erase(iter);
+    }
+  } else if (size > 0.0) {
+    levels.insert(iter, {price, size});
+  }
+  current_ts_ns = std::max(current_ts_ns, ts_ns);
+}
+
+void ExchangeSimulator::submit(const Order& order) {
+  inbound_orders.enqueue(order);
+}
+
+/**
+ * @brief Moves submitted orders onto the network, sampling each one's arrival time.
+ */
+void ExchangeSimulator::drain_inbound() {
+  Order order;
+  while (inbound_orders.try_dequeue(order)) {
+    int64_t arrival = order.send_ts_ns + config.order_latency.sample(rng);
+    /* An order cannot reach the book before the simulation has caught up with its send time */
+    arrival = std::max(arrival, current_ts_ns);
+    pending_orders.push({arrival, next_sequence++, order});
+  }
+}
+
+void ExchangeSimulator::advance_to(int64_t now_ns) {
+  drain_inbound();
+
+  while (!pending_orders.empty() && pending_orders.top().arrival_ts_ns <= now_ns) {
+    PendingOrder pending = pending_orders.top();
+    pending_orders.pop();
+    current_ts_ns = std::max(current_ts_ns, pending.arrival_ts_ns);
+    match(pending.order, pending.arrival_ts_ns);
+  }
+
+  current_ts_ns = std::max(current_ts_ns, now_ns);
+
+  while (!pending_reports.empty() && pending_reports.top().fill.report_ts_ns <= now_ns) {
+    outbound_fills.enqueue(pending_reports.top().fill);
+    pending_reports.pop();
+  }
+}
+
+bool ExchangeSimulator::poll_fill(Fill& fill) {
+  return outbound_fills.try_dequeue(fill);
+}
+
+/**
+ * @brief Executes one IOC order against the current book and schedules its report.
+ */
+void ExchangeSimulator::match(const Order& order, int64_t arrival_ts_ns) {
+  Fill fill;
+  fill.order_id = order.order_id;
+  fill.cycle_id = order.cycle_id;
+  fill.pair_id = order.pair_id;
+  fill.side = order.side;
+  fill.requested_quantity = order.quantity;
+  fill.send_ts_ns = order.send_ts_ns;
+  fill.arrival_ts_ns = arrival_ts_ns;
+  fill.report_ts_ns = arrival_ts_ns + config.report_latency.sample(rng);
+
+  if (order.pair_id < 0 || order.pair_id >= static_cast<int>(books.size()) || !(order.quantity > 0.0) ||
+      (order.side != OrderSide::Buy && order.side != OrderSide::Sell)) {
+    fill.status = FillStatus::Rejected;
+    pending_reports.push({next_sequence++, fill});
+    return;
+  }
+
+  std::vector<Level>& levels = order.side == OrderSide::Buy ? books[order.pair_id].asks : books[order.pair_id].bids;
+  double share = config.queue_rule == QueuePositionRule::BehindCompetitors ? 1.0 - config.queue_ahead_fraction : 1.0;
+
+  double remaining = order.quantity;
+  double notional = 0.0;
+  size_t consumed_levels = 0;
+
+  for (Level& level : levels) {
+    if (remaining <= 0.0) {
+      break;
+    }
+    if (order.limit_price > 0.0 &&
+        (order.side == OrderSide::Buy ? level.price > order.limit_price : level.price < order.limit_price)) {
+      break;
+    }
+
+    double take = std::min(remaining, level.size * share);
+    remaining -= take;
+    notional += take * level.price;
+    level.size -= take;
+    if (level.size <= 0.0) {
+      consumed_levels++;
+    }
+  }
+  levels.erase(levels.begin(), levels.begin() + consumed_levels);
+
+  fill.filled_quantity = order.quantity - remaining;
+  if (fill.filled_quantity <= 0.0) {
+    fill.filled_quantity = 0.0;
+    fill.status = FillStatus::Cancelled;
+  } else {
+    fill.status = remaining > 0.0 ? FillStatus::PartiallyFilled : FillStatus::Filled;
+    fill.average_price = notional / fill.filled_quantity;
+    double received = order.side == OrderSide::Buy ? fill.filled_quantity : notional;
+    fill.fee = received * config.taker_fee_bps * 1e-4;
+    apply_fill(fill);
+  }
+
+  pending_reports.push({next_sequence++, fill});
+}
+
+/**
+ * @brief Books a fill's currency movements into the simulated account.
+ */
+void ExchangeSimulator::apply_fill(const Fill& fill) {
+  int base = catalog.base_id(fill.pair_id);
+  int quote = catalog.quote_id(fill.pair_id);
+  double notional = fill.filled_quantity * fill.average_price;
+
+  if (fill.side == OrderSide::Buy) {
+    balances[base] += fill.filled_quantity - fill.fee;
+    balances[quote] -= notional;
+  } else {
+    balances[base] -= fill.filled_quantity;
+    balances[quote] += notional - fill.fee;
+  }
+}
+
+double ExchangeSimulator::best_bid(int pair_id) const {
+  if (pair_id < 0 || pair_id >= static_cast<int>(books.size())) {
+    return 0.0;
+  }
+  const auto& bids = books[pair_id].bids;
+  return bids.empty() ? 0.0 : bids.front().price;
+}
+
+double ExchangeSimulator::best_ask(int pair_id) const {
+  if (pair_id < 0 || pair_id >= static_cast<int>(books.size())) {
+    return 0.0;
+  }
+  const auto& asks = books[pair_id].asks;
+  return asks.empty() ? 0.0 : asks.front().price;
+}
+
+double ExchangeSimulator::convert(double amount, int from_currency_id, int to_currency_id) const {
+  if (from_currency_id == to_currency_id) {
+    return amount;
+  }
+
+  int direct = catalog.find_pair(from_currency_id, to_currency_id);
+  if (direct >= 0 && best_bid(direct) > 0.0 && best_ask(direct) > 0.0) {
+    return amount * 0.5 * (best_bid(direct) + best_ask(direct));
+  }
+
+  int inverse = catalog.find_pair(to_currency_id, from_currency_id);
+  if (inverse >= 0 && best_bid(inverse) > 0.0 && best_ask(inverse) > 0.0) {
+    return amount / (0.5 * (best_bid(inverse) + best_ask(inverse)));
+  }
+
+  return 0.0;
+}
+
+double ExchangeSimulator::mark_to_market(int currency_id) const {
+  double total = 0.0;
+  for (int id = 0; id < static_cast<int>(balances.size()); id++) {
+    if (balances[id] != 0.0) {
+      total += convert(balances[id], id, currency_id);
+    }
+  }
+  return total;
+}
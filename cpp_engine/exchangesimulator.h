@@ -0,0 +1,249 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <random>
+#include <vector>
+
+#include "concurrentqueue.h"
+#include "paircatalog.h"
+
+enum class OrderSide : uint8_t { Buy, Sell };
+
+enum class FillStatus : uint8_t {
+  Filled,           ///< The full quantity executed.
+  PartiallyFilled,  ///< Some quantity executed, the remainder was cancelled (IOC).
+  Cancelled,        ///< Nothing executable within the limit price; cancelled (IOC).
+  Rejected          ///< Unknown pair or malformed order.
+};
+
+/**
+ * @struct Order
+ * @brief An immediate-or-cancel limit order sent to the exchange.
+ */
+struct Order {
+  uint64_t order_id = 0;
+  uint64_t cycle_id = 0;
+  int pair_id = -1;
+  OrderSide side = OrderSide::Buy;
+  /// @brief Quantity in base currency units.
+  double quantity = 0.0;
+  /// @brief Worst acceptable price; 0 means marketable at any price.
+  double limit_price = 0.0;
+  /// @brief Time the order left the engine.
+  int64_t send_ts_ns = 0;
+};
+
+/**
+ * @struct Fill
+ * @brief Execution report for one IOC order.
+ */
+struct Fill {
+  uint64_t order_id = 0;
+  uint64_t cycle_id = 0;
+  int pair_id = -1;
+  OrderSide side = OrderSide::Buy;
+  FillStatus status = FillStatus::Rejected;
+  double requested_quantity = 0.0;
+  double filled_quantity = 0.0;
+  double average_price = 0.0;
+  /// @brief Fee charged, in units of the currency received.
+  double fee = 0.0;
+  int64_t send_ts_ns = 0;
+  /// @brief Time the order reached the matching engine.
+  int64_t arrival_ts_ns = 0;
+  /// @brief Time the execution report reaches the engine.
+  int64_t report_ts_ns = 0;
+};
+
+enum class LatencyDistribution {
+  Constant,   ///< Always `param_a` nanoseconds.
+  Uniform,    ///< Uniform on [`param_a`, `param_b`] nanoseconds.
+  LogNormal   ///< Median `param_a` nanoseconds, log-space sigma `param_b`.
+};
+
+/**
+ * @struct LatencyModel
+ * @brief A one-way latency distribution for a simulated network hop.
+ */
+struct LatencyModel {
+  LatencyDistribution distribution = LatencyDistribution::Constant;
+  double param_a = 0.0;
+  double param_b = 0.0;
+
+  int64_t sample(std::mt19937_64& rng) const;
+};
+
+enum class QueuePositionRule {
+  FrontOfQueue,      ///< The full displayed size is available to our order.
+  BehindCompetitors  ///< `queue_ahead_fraction` of each level is taken by faster flow first.
+};
+
+/**
+ * @struct SimulatorConfig
+ * @brief Tunables for the simulated venue.
+ */
+struct SimulatorConfig {
+  LatencyModel order_latency;
+  LatencyModel report_latency;
+  QueuePositionRule queue_rule = QueuePositionRule::FrontOfQueue;
+  double queue_ahead_fraction = 0.0;
+  /// @brief Half spread placed around trade prints when the feed carries no quotes.
+  double synthetic_half_spread_bps = 0.0;
+  /// @brief Displayed size of a synthetic level, as a multiple of the trade quantity.
+  double synthetic_depth_multiplier = 1.0;
+  double taker_fee_bps = 0.0;
+  uint64_t seed = 42;
+};
+
+/**
+ * @class ExchangeSimulator
+ * @brief A local matching engine for measuring tick-to-fill latency and realised PnL.
+ *
+ * The simulator keeps one order book per pair, driven by the replayed feed, and
+ * executes IOC orders against it. Orders are handed over through a lock-free
+ * in-process queue, so the engine thread can submit while another thread drives
+ * the simulation. Time is entirely caller-supplied: `advance_to` moves the
+ * simulated clock, matching every order whose sampled arrival time has passed
+ * against the book as it stood at that moment, before any later market data is
+ * applied. Execution reports are released once their report time is reached.
+ */
+class ExchangeSimulator {
+public:
+  /**
+   * @brief Builds one book per pair registered in `catalog` so far; later pairs are not supported.
+   */
+  ExchangeSimulator(const PairCatalog& catalog, const SimulatorConfig& config);
+
+  /**
+   * @brief Applies a trade print, replacing each side with one synthetic level around it.
+   *
+   * Use this for pairs the feed only delivers trades for; pairs with depth data
+   * should be driven by `on_book_level` instead. Like the other market data
+   * calls, it throws std::out_of_range for a pair the simulator has no book for.
+   */
+  void on_trade(int pair_id, double price, double quantity, int64_t ts_ns);
+
+  /**
+   * @brief Replaces one side of the book with a single best level (L1 quote update).
+   */
+  void on_top_of_book(int pair_id, OrderSide side, double price, double size, int64_t ts_ns);
+
+  /**
+   * @brief Sets one price level of the book (L2 update); a size of zero removes it.
+   */
+  void on_book_level(int pair_id, OrderSide side, double price, double size, int64_t ts_ns);
+
+  /**
+   * @brief Submits an order. Safe to call from any thread.
+   */
+  void submit(const Order& order);
+
+  /**
+   * @brief Moves the simulated clock forward, matching arrived orders and releasing reports.
+   */
+  void advance_to(int64_t now_ns);
+
+  /**
+   * @brief Retrieves the next released execution report. Safe to call from any thread.
+   * @return True if a fill was written to `fill`.
+   */
+  bool poll_fill(Fill& fill);
+
+  /// @brief Pairs the simulator keeps a book for; orders for any other pair ID are rejected.
+  int num_pairs() const { return static_cast<int>(books.size()); }
+
+  /// @brief Best bid for a pair, or 0 if the bid side is empty or the pair has no book.
+  double best_bid(int pair_id) const;
+
+  /// @brief Best ask for a pair, or 0 if the ask side is empty or the pair has no book.
+  double best_ask(int pair_id) const;
+
+  /**
+   * @brief Converts an amount between currencies using the mid of a directly traded pair.
+   * @return The converted amount, or 0 if the currencies share no pair with a two-sided book.
+   */
+  double convert(double amount, int from_currency_id, int to_currency_id) const;
+
+  /// @brief Net balance change of a currency from all fills so far, after fees.
+  double balance(int currency_id) const { return balances[currency_id]; }
+
+  /**
+   * @brief Values all balance changes in one currency at current mids.
+   *
+   * Currencies without a direct pair to `currency_id` are left out.
+   */
+  double mark_to_market(int currency_id) const;
+
+  int64_t now() const { return current_ts_ns; }
+
+private:
+  /**
+   * @struct Level
+   * @brief One aggregated price level.
+   */
+  struct Level {
+    double price;
+    double size;
+  };
+
+  /**
+   * @struct Book
+   * @brief Per-pair book: bids descending, asks ascending.
+   */
+  struct Book {
+    std::vector<Level> bids;
+    std::vector<Level> asks;
+  };
+
+  /**
+   * @struct PendingOrder
+   * @brief An order in flight towards the matching engine.
+   */
+  struct PendingOrder {
+    int64_t arrival_ts_ns;
+    uint64_t sequence;
+    Order order;
+
+    bool operator>(const PendingOrder& other) const {
+      return arrival_ts_ns != other.arrival_ts_ns ? arrival_ts_ns > other.arrival_ts_ns : sequence > other.sequence;
+    }
+  };
+
+  /**
+   * @struct PendingReport
+   * @brief An execution report in flight back towards the engine.
+   */
+  struct PendingReport {
+    uint64_t sequence;
+    Fill fill;
+
+    bool operator>(const PendingReport& other) const {
+      return fill.report_ts_ns != other.fill.report_ts_ns ? fill.report_ts_ns > other.fill.report_ts_ns : sequence > other.sequence;
+    }
+  };
+
+  const PairCatalog& catalog;
+  SimulatorConfig config;
+  std::mt19937_64 rng;
+
+  std::vector<Book> books;
+  std::vector<double> balances;
+
+  moodycamel::ConcurrentQueue<Order> inbound_orders;
+  moodycamel::ConcurrentQueue<Fill> outbound_fills;
+
+  std::priority_queue<PendingOrder, std::vector<PendingOrder>, std::greater<PendingOrder>> pending_orders;
+  std::priority_queue<PendingReport, std::vector<PendingReport>, std::greater<PendingReport>> pending_reports;
+
+  uint64_t next_sequence = 0;
+
+  /// @brief Throws std::out_of_range unless `pair_id` has a book.
+  void check_pair(int pair_id) const;
+  int64_t current_ts_ns = 0;
+
+  void drain_inbound();
+  void match(const Order& order, int64_t arrival_ts_ns);
+  void apply_fill(const Fill& fill);
+};
@@ -0,0 +1,54 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "tickarchive.h"
+#include "trainingset.h"
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    std::cerr << "Usage: " << argv[0] << " <archive> <training.f32> [--threads N] [--latency-us MEDIAN]"
+              << " [--decision-us DELAY]" << std::endl;
+    return 1;
+  }
+
+  unsigned num_threads = 0;
+  double latency_us = 400.0;
+  double decision_us = 0.0;
+  for (int i = 3; i < argc; i++) {
+    if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      num_threads = static_cast<unsigned>(std::stoul(argv[++i]));
+    } else if (std::strcmp(argv[i], "--latency-us") == 0 && i + 1 < argc) {
+      latency_us = std::stod(argv[++i]);
+    } else if (std::strcmp(argv[i], "--decision-us") == 0 && i + 1 < argc) {
+      decision_us = std::stod(argv[++i]);
+    }
+  }
+
+  TickArchive archive;
+  archive.open(argv[1], num_threads);
+  std::cout << "Loaded " << archive.size() << " ticks over " << archive.symbols().size() << " pairs" << std::endl;
+  if (archive.skipped_rows() > 0) {
+    std::cout << "Skipped " << archive.skipped_rows() << " malformed rows" << std::endl;
+  }
+
+  TrainingSetConfig config;
+  config.simulator.order_latency = {LatencyDistribution::LogNormal, latency_us * 1000.0, 0.5};
+  config.simulator.report_latency = {LatencyDistribution::LogNormal, latency_us * 1000.0, 0.5};
+  config.simulator.synthetic_half_spread_bps = 1.0;
+  config.simulator.taker_fee_bps = 5.0;
+  config.decision_latency_ns = static_cast<int64_t>(decision_us * 1000.0);
+
+  auto start = std::chrono::steady_clock::now();
+  TrainingSet training_set = TrainingSetExtractor(archive).run(config, num_threads);
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  training_set.write(argv[2]);
+  std::printf("%zu detections, %zu rows x %d columns in %.2fs\n", training_set.detections, training_set.rows(),
+              TrainingSet::NUM_COLUMNS, elapsed);
+  std::printf("Load with numpy.fromfile(\"%s\", dtype=numpy.float32).reshape(-1, %d); names in %s.columns\n",
+              argv[2], TrainingSet::NUM_COLUMNS, argv[2]);
+  return 0;
+}
@@ -0,0 +1,143 @@
+/**
+ * @file fastlog.cpp
+ * @brief Implements the batch logarithm with an AVX2 kernel and a scalar fallback.
+ *
+ * @details
+ * The kernel is compiled with a function-level target attribute, so the rest of
+ * the engine keeps the baseline instruction set and the dispatch happens once,
+ * on the first call. Only AVX2 is enabled, not FMA, so the compiler cannot
+ * contract multiply-adds differently in the two paths.
+ */
+
+#include "fastlog.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define FASTLOG_HAVE_AVX2_KERNEL 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+/* fdlibm e_log.c */
+constexpr double LN2_HI = 6.93147180369123816490e-01;
+constexpr double LN2_LO = 1.90821492927058770002e-10;
+constexpr double LG1 = 6.666666666666735130e-01;
+constexpr double LG2 = 3.999999999940941908e-01;
+constexpr double LG3 = 2.857142874366239149e-01;
+constexpr double LG4 = 2.222219843214978396e-01;
+constexpr double LG5 = 1.818357216161805012e-01;
+constexpr double LG6 = 1.531383769920937332e-01;
+constexpr double LG7 = 1.479819860511658591e-01;
+constexpr double SQRT2 = 1.41421356237309504880;
+
+constexpr uint64_t MANTISSA_MASK = 0x000fffffffffffffULL;
+constexpr uint64_t EXPONENT_ONE = 0x3ff0000000000000ULL;
+
+double scalar_log(double x) {
+  uint64_t bits;
+  std::memcpy(&bits, &x, sizeof(bits));
+  double k = static_cast<double>(static_cast<int64_t>(bits >> 52) - 1023);
+  uint64_t mantissa_bits = (bits & MANTISSA_MASK) | EXPONENT_ONE;
+  double m;
+  std::memcpy(&m, &mantissa_bits, sizeof(m));
+  if (m >= SQRT2) {
+    m = m * 0.5;
+    k = k + 1.0;
+  }
+
+  double f = m - 1.0;
+  double s = f / (2.0 + f);
+  double z = s * s;
+  double w = z * z;
+  double t1 = w * (LG2 + w * (LG4 + w * LG6));
+  double t2 = z * (LG1 + w * (LG3 + w * (LG5 + w * LG7)));
+  double r = t2 + t1;
+  double hfsq = 0.5 * f * f;
+  return k * LN2_HI - ((hfsq - (s * (hfsq + r) + k * LN2_LO)) - f);
+}
+
+#ifdef FASTLOG_HAVE_AVX2_KERNEL
+
+__attribute__((target("avx2"))) void avx2_log(const double* in, double* out, size_t count) {
+  const __m256i mantissa_mask = _mm256_set1_epi64x(static_cast<long long>(MANTISSA_MASK));
+  const __m256i exponent_one = _mm256_set1_epi64x(static_cast<long long>(EXPONENT_ONE));
+  /* 2^52 + 1023 as a double: OR-ing a biased exponent into its low bits and subtracting converts it to k */
+  const __m256i magic_bits = _mm256_set1_epi64x(0x4330000000000000LL);
+  const __m256d magic = _mm256_set1_pd(4503599627370496.0 + 1023.0);
+  const __m256d one = _mm256_set1_pd(1.0);
+  const __m256d two = _mm256_set1_pd(2.0);
+  const __m256d half = _mm256_set1_pd(0.5);
+  const __m256d sqrt2 = _mm256_set1_pd(SQRT2);
+
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m256d x = _mm256_loadu_pd(in + i);
+    __m256i bits = _mm256_castpd_si256(x);
+    __m256i biased = _mm256_srli_epi64(bits, 52);
+    __m256d k = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(biased, magic_bits)), magic);
+    __m256d m = _mm256_castsi256_pd(_mm256_or_si256(_mm256_and_si256(bits, mantissa_mask), exponent_one));
+
+    __m256d high = _mm256_cmp_pd(m, sqrt2, _CMP_GE_OQ);
+    m = _mm256_blendv_pd(m, _mm256_mul_pd(m, half), high);
+    k = _mm256_blendv_pd(k, _mm256_add_pd(k, one), high);
+
+    __m256d f = _mm256_sub_pd(m, one);
+    __m256d s = _mm256_div_pd(f, _mm256_add_pd(two, f));
+    __m256d z = _mm256_mul_pd(s, s);
+    __m256d w = _mm256_mul_pd(z, z);
+    __m256d t1 = _mm256_mul_pd(w, _mm256_add_pd(_mm256_set1_pd(LG2),
+                 _mm256_mul_pd(w, _mm256_add_pd(_mm256_set1_pd(LG4), _mm256_mul_pd(w, _mm256_set1_pd(LG6))))));
+    __m256d t2 = _mm256_mul_pd(z, _mm256_add_pd(_mm256_set1_pd(LG1),
+                 _mm256_mul_pd(w, _mm256_add_pd(_mm256_set1_pd(LG3),
+                 _mm256_mul_pd(w, _mm256_add_pd(_mm256_set1_pd(LG5), _mm256_mul_pd(w, _mm256_set1_pd(LG7))))))));
+    __m256d r = _mm256_add_pd(t2, t1);
+    __m256d hfsq = _mm256_mul_pd(_mm256_mul_pd(half, f), f);
+    __m256d inner = _mm256_add_pd(_mm256_mul_pd(s, _mm256_add_pd(hfsq, r)),
+                                  _mm256_mul_pd(k, _mm256_set1_pd(LN2_LO)));
+    __m256d result = _mm256_sub_pd(_mm256_mul_pd(k, _mm256_set1_pd(LN2_HI)),
+                                   _mm256_sub_pd(_mm256_sub_pd(hfsq, inner), f));
+    _mm256_storeu_pd(out + i, result);
+  }
+  for (; i < count; i++) {
+    out[i] = scalar_log(in[i]);
+  }
+}
+
+bool detect_avx2() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+}
+
+#else
+
+bool detect_avx2() {
+  return false;
+}
+
+#endif
+
+}
+
+bool log_batch_vectorised() {
+  static const bool available = detect_avx2();
+  return available;
+}
+
+double fast_log(double x) {
+  return scalar_log(x);
+}
+
+void log_batch(const double* in, double* out, size_t count) {
+#ifdef FASTLOG_HAVE_AVX2_KERNEL
+  if (log_batch_vectorised()) {
+    avx2_log(in, out, count);
+    return;
+  }
+#endif
+  for (size_t i = 0; i < count; i++) {
+    out[i] = scalar_log(in[i]);
+  }
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+
+/**
+ * @brief Natural logarithms of `count` doubles, four at a time where the CPU has AVX2.
+ *
+ * The algorithm is fdlibm's `__ieee754_log`: x = 2^k * (1 + f) with
+ * 1 + f in [sqrt(2)/2, sqrt(2)), s = f / (2 + f), and ln(1 + f) from a degree-14
+ * even polynomial in s with a split ln(2). The error is below 1 ULP. The AVX2
+ * kernel is chosen at run time and performs the same operations in the same order
+ * as the scalar fallback (no fused multiply-adds), so results are bit-identical
+ * on every machine.
+ *
+ * Inputs must be positive, finite and normal, which every price is; other
+ * values give unspecified results rather than the IEEE special cases. `in` and
+ * `out` may be the same array.
+ */
+void log_batch(const double* in, double* out, size_t count);
+
+/// @brief `log_batch` for a single value, using the scalar path.
+double fast_log(double x);
+
+/// @brief True if `log_batch` runs the AVX2 kernel on this machine.
+bool log_batch_vectorised();
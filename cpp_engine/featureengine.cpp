@@ -0,0 +1,82 @@
+/**
+ * @file featureengine.cpp
+ * @brief Implements the streaming feature engine for latency model training.
+ */
+
+#include "featureengine.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const int64_t NANOS_PER_DAY = 86400LL * 1000000000LL;
+
+}
+
+const char* const FeatureEngine::FEATURE_NAMES[FeatureEngine::NUM_FEATURES] = {
+  "num_legs",
+  "log_profit_bps",
+  "hour_of_day",
+  "trigger_feed_delay_us",
+  "max_leg_feed_delay_ewma_us",
+  "max_leg_quote_age_ms",
+  "min_leg_trade_rate_hz",
+  "max_leg_abs_return_bps",
+  "trigger_pair_feed_delay_ewma_us",
+};
+
+FeatureEngine::FeatureEngine(int num_pairs, double ewma_alpha)
+  : pairs(num_pairs), delays(num_pairs), ewma_alpha(ewma_alpha) {}
+
+void FeatureEngine::on_tick(const TickRecord& tick) {
+  int pair_id = static_cast<int>(tick.pair_id);
+  delays.record(pair_id, tick.exchange_ts_ns, tick.receive_ts_ns);
+  if (tick.kind != TickKind::Trade || tick.price <= 0.0) {
+    return;
+  }
+
+  PairFeatures& state = pairs[pair_id];
+  double log_price = std::log(tick.price);
+  if (state.trades > 0) {
+    double interval = static_cast<double>(tick.receive_ts_ns - state.last_trade_ns);
+    double abs_return = std::fabs(log_price - state.last_log_price);
+    if (state.trades == 1) {
+      state.interval_ewma_ns = interval;
+      state.abs_return_ewma = abs_return;
+    } else {
+      state.interval_ewma_ns += ewma_alpha * (interval - state.interval_ewma_ns);
+      state.abs_return_ewma += ewma_alpha * (abs_return - state.abs_return_ewma);
+    }
+  }
+  state.last_trade_ns = tick.receive_ts_ns;
+  state.last_log_price = log_price;
+  state.trades++;
+}
+
+void FeatureEngine::cycle_features(const Opportunity& cycle, const TickRecord& trigger, float* out) const {
+  int64_t now = trigger.receive_ts_ns;
+  double max_delay_ewma = 0.0;
+  double max_age = 0.0;
+  double min_rate = HUGE_VAL;
+  double max_abs_return = 0.0;
+  for (int leg = 0; leg < cycle.num_legs; leg++) {
+    int pair_id = edge_pair_id(cycle.edge_slots[leg]);
+    const PairFeatures& state = pairs[pair_id];
+    max_delay_ewma = std::max(max_delay_ewma, delays.stats(pair_id).feed_ewma_ns);
+    max_age = std::max(max_age, static_cast<double>(now - state.last_trade_ns));
+    min_rate = std::min(min_rate, state.interval_ewma_ns > 0.0 ? 1e9 / state.interval_ewma_ns : 0.0);
+    max_abs_return = std::max(max_abs_return, state.abs_return_ewma);
+  }
+
+  int64_t time_of_day = ((now % NANOS_PER_DAY) + NANOS_PER_DAY) % NANOS_PER_DAY;
+  out[0] = static_cast<float>(cycle.num_legs);
+  out[1] = static_cast<float>(cycle.log_profit * 1e4);
+  out[2] = static_cast<float>(time_of_day / 3.6e12);
+  out[3] = static_cast<float>((trigger.receive_ts_ns - trigger.exchange_ts_ns) / 1e3);
+  out[4] = static_cast<float>(max_delay_ewma / 1e3);
+  out[5] = static_cast<float>(max_age / 1e6);
+  out[6] = static_cast<float>(min_rate);
+  out[7] = static_cast<float>(max_abs_return * 1e4);
+  out[8] = static_cast<float>(delays.stats(static_cast<int>(trigger.pair_id)).feed_ewma_ns / 1e3);
+}
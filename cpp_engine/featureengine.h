@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "feedlatency.h"
+#include "opportunity.h"
+#include "tickarchive.h"
+
+/**
+ * @struct PairFeatures
+ * @brief Running market state of one pair, updated tick by tick.
+ */
+struct PairFeatures {
+  int64_t last_trade_ns = 0;
+  double last_log_price = 0.0;
+  /// @brief Exponentially weighted mean time between trades.
+  double interval_ewma_ns = 0.0;
+  /// @brief Exponentially weighted mean absolute log return between consecutive trades.
+  double abs_return_ewma = 0.0;
+  uint64_t trades = 0;
+};
+
+/**
+ * @class FeatureEngine
+ * @brief Streaming per-pair features for the latency model, computed in one pass over the ticks.
+ *
+ * Every update is O(1) and allocation-free, so the same engine can run beside
+ * the live detector or over a replayed archive. `cycle_features` summarises a
+ * detected cycle by its weakest leg: the stalest quote, the slowest feed, the
+ * least active and the most volatile pair.
+ */
+class FeatureEngine {
+public:
+  static constexpr int NUM_FEATURES = 9;
+  /// @brief Column names of `cycle_features`, in order.
+  static const char* const FEATURE_NAMES[NUM_FEATURES];
+
+  /**
+   * @param num_pairs Pair IDs are in [0, num_pairs).
+   * @param ewma_alpha Weight of each new sample in the running averages.
+   */
+  explicit FeatureEngine(int num_pairs, double ewma_alpha = 1.0 / 32.0);
+
+  /// @brief Feeds one tick; trades update activity and volatility, every tick updates feed delay.
+  void on_tick(const TickRecord& tick);
+
+  const PairFeatures& pair(int pair_id) const { return pairs[pair_id]; }
+  const FeedDelayMonitor& feed_delays() const { return delays; }
+
+  /**
+   * @brief Writes `NUM_FEATURES` values describing `cycle`, detected on `trigger`, to `out`.
+   */
+  void cycle_features(const Opportunity& cycle, const TickRecord& trigger, float* out) const;
+
+private:
+  std::vector<PairFeatures> pairs;
+  FeedDelayMonitor delays;
+  double ewma_alpha;
+};
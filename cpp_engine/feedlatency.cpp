@@ -0,0 +1,100 @@
+/**
+ * @file feedlatency.cpp
+ * @brief Implements per-pair feed and queueing delay monitoring.
+ */
+
+#include "feedlatency.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+
+double FeedDelayStats::feed_stddev_ns() const {
+  if (feed.total < 2) {
+    return 0.0;
+  }
+  return std::sqrt(feed_m2 / feed.total);
+}
+
+void FeedDelayStats::merge(const FeedDelayStats& other) {
+  /* The EWMA is a recency estimate; keep whichever side saw more samples */
+  if (other.feed.total > feed.total) {
+    feed_ewma_ns = other.feed_ewma_ns;
+  }
+  if (other.feed.total != 0) {
+    /* Chan et al.'s pairwise combination of means and squared deviations */
+    double count = static_cast<double>(feed.total);
+    double other_count = static_cast<double>(other.feed.total);
+    double total = count + other_count;
+    double delta = other.feed_mean - feed_mean;
+    feed_mean += delta * other_count / total;
+    feed_m2 += other.feed_m2 + delta * delta * count * other_count / total;
+  }
+  feed.merge(other.feed);
+  negative_feed += other.negative_feed;
+  feed_max_ns = std::max(feed_max_ns, other.feed_max_ns);
+  queue.merge(other.queue);
+  queue_sum_ns += other.queue_sum_ns;
+  queue_max_ns = std::max(queue_max_ns, other.queue_max_ns);
+}
+
+FeedDelayMonitor::FeedDelayMonitor(int num_pairs, double ewma_alpha, std::pmr::memory_resource* memory)
+  : pairs(num_pairs, memory), ewma_alpha(ewma_alpha) {}
+
+void FeedDelayMonitor::record(int pair_id, int64_t exchange_ts_ns, int64_t receive_ts_ns, int64_t dequeue_ts_ns) {
+  FeedDelayStats& stats = pairs[pair_id];
+
+  if (exchange_ts_ns != 0 && receive_ts_ns != 0) {
+    int64_t delay = receive_ts_ns - exchange_ts_ns;
+    if (delay < 0) {
+      stats.negative_feed++;
+    }
+    double sample = static_cast<double>(delay);
+    if (stats.feed.total == 0) {
+      stats.feed_ewma_ns = sample;
+    } else {
+      stats.feed_ewma_ns += ewma_alpha * (sample - stats.feed_ewma_ns);
+    }
+    stats.feed.add(delay);
+    double deviation = sample - stats.feed_mean;
+    stats.feed_mean += deviation / stats.feed.total;
+    stats.feed_m2 += deviation * (sample - stats.feed_mean);
+    stats.feed_max_ns = std::max(stats.feed_max_ns, delay);
+  }
+
+  if (receive_ts_ns != 0 && dequeue_ts_ns != 0) {
+    int64_t delay = dequeue_ts_ns - receive_ts_ns;
+    stats.queue.add(delay);
+    stats.queue_sum_ns += static_cast<double>(delay);
+    stats.queue_max_ns = std::max(stats.queue_max_ns, delay);
+  }
+}
+
+void FeedDelayMonitor::merge(const FeedDelayMonitor& other) {
+  for (size_t p = 0; p < pairs.size() && p < other.pairs.size(); p++) {
+    pairs[p].merge(other.pairs[p]);
+  }
+}
+
+void FeedDelayMonitor::write_csv(const std::string& path, const std::vector<std::string>& symbols) const {
+  std::ofstream output(path);
+  if (!output.is_open()) {
+    throw std::runtime_error("Could not write feed delays: " + path);
+  }
+
+  output << "symbol,samples,negative,feed_mean_us,feed_stddev_us,feed_ewma_us,feed_p50_us,feed_p90_us,"
+            "feed_p99_us,feed_max_us,queue_samples,queue_mean_us,queue_p50_us,queue_p99_us,queue_max_us\n";
+  for (size_t p = 0; p < pairs.size() && p < symbols.size(); p++) {
+    const FeedDelayStats& stats = pairs[p];
+    output << symbols[p] << ',' << stats.feed.total << ',' << stats.negative_feed << ','
+           << stats.feed_mean_ns() / 1e3 << ',' << stats.feed_stddev_ns() / 1e3 << ',' << stats.feed_ewma_ns / 1e3
+           << ',' << stats.feed.quantile_ns(0.50) / 1e3 << ',' << stats.feed.quantile_ns(0.90) / 1e3 << ','
+           << stats.feed.quantile_ns(0.99) / 1e3 << ',' << stats.feed_max_ns / 1e3 << ',' << stats.queue.total
+           << ',' << stats.queue_mean_ns() / 1e3 << ',' << stats.queue.quantile_ns(0.50) / 1e3 << ','
+           << stats.queue.quantile_ns(0.99) / 1e3 << ',' << stats.queue_max_ns / 1e3 << '\n';
+  }
+  if (!output) {
+    throw std::runtime_error("Could not write feed delays: " + path);
+  }
+}
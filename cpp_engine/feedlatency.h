@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include "durationhistogram.h"
+
+/**
+ * @struct FeedDelayStats
+ * @brief Delays of one pair's updates on their way into the engine.
+ *
+ * The feed delay is receive time minus exchange time, so it includes any clock
+ * offset between the exchange and this host; updates received "before" they
+ * were stamped are counted in `negative_feed` and land in the lowest bucket.
+ * The queue delay is dequeue time minus receive time, both local.
+ */
+struct FeedDelayStats {
+  DurationHistogram feed;
+  uint64_t negative_feed = 0;
+  /// @brief Running mean and sum of squared deviations (Welford), stable for large offsets.
+  double feed_mean = 0.0;
+  double feed_m2 = 0.0;
+  /// @brief Exponentially weighted mean of recent feed delays, the live estimate.
+  double feed_ewma_ns = 0.0;
+  int64_t feed_max_ns = 0;
+
+  DurationHistogram queue;
+  double queue_sum_ns = 0.0;
+  int64_t queue_max_ns = 0;
+
+  double feed_mean_ns() const { return feed_mean; }
+  double feed_stddev_ns() const;
+  double queue_mean_ns() const { return queue.total ? queue_sum_ns / queue.total : 0.0; }
+
+  void merge(const FeedDelayStats& other);
+};
+
+/**
+ * @class FeedDelayMonitor
+ * @brief Online per-pair histograms of feed and queueing delay.
+ *
+ * `record` is O(1) and allocation-free, so it runs on the hot path for every
+ * update. A timestamp of 0 means "not known" and skips the measurements that
+ * need it. Not thread-safe: each consumer keeps its own monitor and merges.
+ */
+class FeedDelayMonitor {
+public:
+  /**
+   * @param num_pairs Pair IDs are in [0, num_pairs).
+   * @param ewma_alpha Weight of each new sample in `feed_ewma_ns`.
+   * @param memory Where the per-pair statistics are allocated.
+   */
+  explicit FeedDelayMonitor(int num_pairs, double ewma_alpha = 1.0 / 64.0,
+                            std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+
+  void record(int pair_id, int64_t exchange_ts_ns, int64_t receive_ts_ns, int64_t dequeue_ts_ns = 0);
+
+  const FeedDelayStats& stats(int pair_id) const { return pairs[pair_id]; }
+  int num_pairs() const { return static_cast<int>(pairs.size()); }
+
+  void merge(const FeedDelayMonitor& other);
+
+  /**
+   * @brief Writes one row of summary statistics per pair, in microseconds, for the latency model's training set.
+   * @param symbols Pair symbols by pair ID.
+   * @throws std::runtime_error if the file cannot be written.
+   */
+  void write_csv(const std::string& path, const std::vector<std::string>& symbols) const;
+
+private:
+  std::pmr::vector<FeedDelayStats> pairs;
+  double ewma_alpha;
+};
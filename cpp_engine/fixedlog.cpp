@@ -0,0 +1,65 @@
+/**
+ * @file fixedlog.cpp
+ * @brief Implements the table-plus-polynomial fixed-point logarithm.
+ */
+
+#include "fixedlog.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+constexpr int TABLE_BITS = 10;
+constexpr int TABLE_SIZE = 1 << TABLE_BITS;
+
+/**
+ * @struct LogTableEntry
+ * @brief One interval of the mantissa: 1 / centre, and ln(centre) already scaled to fixed-point units.
+ * Both are read together, so they share a cache line.
+ */
+struct LogTableEntry {
+  double inverse_centre;
+  double scaled_log_centre;
+};
+
+struct LogTable {
+  LogTableEntry entries[TABLE_SIZE];
+
+  LogTable() {
+    for (int i = 0; i < TABLE_SIZE; i++) {
+      double centre = 1.0 + (i + 0.5) / TABLE_SIZE;
+      entries[i] = {1.0 / centre, std::log(centre) * FIXED_LOG_SCALE};
+    }
+  }
+};
+
+const LogTable TABLE;
+
+/// @brief ln(2) in fixed-point units; exact to about 2^-14 units, so e * ln(2) stays well within one unit.
+constexpr double SCALED_LN2 = 0.69314718055994530942 * FIXED_LOG_SCALE;
+
+constexpr double ROUNDING_SHIFT = 6755399441055744.0;
+
+}
+
+int64_t fixed_log(double x) {
+  uint64_t bits;
+  std::memcpy(&bits, &x, sizeof(bits));
+  int exponent = static_cast<int>((bits >> 52) & 0x7ff) - 1023;
+  int index = static_cast<int>((bits >> (52 - TABLE_BITS)) & (TABLE_SIZE - 1));
+
+  /* The mantissa in [1, 2), with x's exponent replaced by zero */
+  uint64_t mantissa_bits = (bits & 0x000fffffffffffffULL) | 0x3ff0000000000000ULL;
+  double mantissa;
+  std::memcpy(&mantissa, &mantissa_bits, sizeof(mantissa));
+
+  const LogTableEntry& entry = TABLE.entries[index];
+  double r = mantissa * entry.inverse_centre - 1.0;
+  double r2 = r * r;
+  double log1p_r = r - r2 * (0.5 - r * (1.0 / 3.0 - r * 0.25));
+
+  double scaled = exponent * SCALED_LN2 + entry.scaled_log_centre + log1p_r * FIXED_LOG_SCALE;
+  /* Round to nearest without a sign branch: |scaled| < 2^51, so adding 1.5 * 2^52 leaves no fraction bits */
+  return static_cast<int64_t>((scaled + ROUNDING_SHIFT) - ROUNDING_SHIFT);
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * @brief Fraction bits of the engine's fixed-point logarithms.
+ *
+ * A fixed-point log is round(ln(x) * 2^FIXED_LOG_FRACTION_BITS). With 40
+ * fraction bits one unit is about 9.1e-13 in log space (9.1e-9 bp), and any
+ * sum of up to a few thousand logs of positive doubles stays far from int64
+ * overflow, so cycle weights add and compare exactly.
+ */
+
+constexpr int FIXED_LOG_FRACTION_BITS = 40;
+constexpr double FIXED_LOG_SCALE = static_cast<double>(int64_t{1} << FIXED_LOG_FRACTION_BITS);
+
+/**
+ * @brief ln(x) in fixed point, for finite x > 0.
+ *
+ * x = 2^e * m with m in [1, 2); m is divided by the centre c of one of 1024
+ * table intervals (16 KiB), and ln(m / c) is a degree-4 polynomial in
+ * r = m / c - 1, |r| < 2^-11. The truncation error is below 1e-17 and everything
+ * is summed in double before one final rounding, so the result is ln(x) * 2^40
+ * rounded to nearest except within about 0.01 units of a tie: never more than
+ * one unit from the correctly rounded value. Subnormal, zero, negative and
+ * non-finite inputs are not supported.
+ */
+int64_t fixed_log(double x);
+
+/// @brief A fixed-point log back in natural-log units.
+inline double fixed_log_to_double(int64_t value) {
+  return static_cast<double>(value) * (1.0 / FIXED_LOG_SCALE);
+}
@@ -0,0 +1,24 @@
+/**
+ * @file inventory.cpp
+ * @brief Implements the per-currency inventory used to choose cycle start points.
+ */
+
+#include "inventory.h"
+
+Inventory::Inventory(int num_currencies) {
+  this->balances.resize(num_currencies, 0.0);
+  this->marks.resize(num_currencies, 0.0);
+}
+
+int Inventory::best_start(const int* cycle, int length) const {
+  int best = -1;
+  double best_capacity = 0.0;
+  for (int i = 0; i < length; i++) {
+    double available = capacity(cycle[i]);
+    if (available > best_capacity) {
+      best_capacity = available;
+      best = i;
+    }
+  }
+  return best;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vector>
+
+/**
+ * @class Inventory
+ * @brief Current balances per currency ID, with marks to compare them in one unit.
+ *
+ * The inventory decides where a detected cycle can start: only a currency we hold
+ * can fund the first leg, and the one worth the most in the valuation currency has
+ * the most capacity. It is owned by the logic thread and is not thread-safe.
+ */
+class Inventory {
+public:
+  explicit Inventory(int num_currencies);
+
+  void set_balance(int currency_id, double amount) { balances[currency_id] = amount; }
+  void adjust(int currency_id, double delta) { balances[currency_id] += delta; }
+  double balance(int currency_id) const { return balances[currency_id]; }
+
+  /**
+   * @brief Sets the value of one unit of a currency in the valuation currency.
+   */
+  void set_mark(int currency_id, double price) { marks[currency_id] = price; }
+
+  /**
+   * @brief Value of the balance in the valuation currency; 0 if not held or not marked.
+   */
+  double capacity(int currency_id) const {
+    return balances[currency_id] > 0.0 ? balances[currency_id] * marks[currency_id] : 0.0;
+  }
+
+  /**
+   * @brief Picks the cycle vertex to start from.
+   * @param cycle Distinct currency IDs of the cycle, in trading order.
+   * @param length Number of vertices in `cycle`.
+   * @return Index into `cycle` of the held currency with the most capacity, or -1 if none is held.
+   */
+  int best_start(const int* cycle, int length) const;
+
+  int num_currencies() const { return static_cast<int>(balances.size()); }
+
+private:
+  std::vector<double> balances;
+  std::vector<double> marks;
+};
@@ -0,0 +1,186 @@
+/**
+ * @file lifetimeanalytics.cpp
+ * @brief Implements opportunity lifetime analysis over a replayed tick archive.
+ *
+ * @details
+ * Each shard owns a graph and a small list of open opportunities. After every
+ * trade tick the open cycles are re-priced from the graph's edge weights and
+ * closed if they are no longer profitable, then the detector runs and any
+ * newly found cycle is opened. Only opportunities that open inside the shard
+ * are recorded; those opened during warm-up are followed so that they are not
+ * mistaken for new ones, and then discarded.
+ */
+
+#include "lifetimeanalytics.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "arbitragegraph.h"
+#include "opportunitytracker.h"
+#include "parallel.h"
+
+namespace {
+
+const int64_t NANOS_PER_HOUR = 3600LL * 1000000000LL;
+
+/**
+ * @struct OpenCycle
+ * @brief An opportunity that is still profitable at current prices.
+ */
+struct OpenCycle {
+  uint64_t key;
+  int length;
+  int currency_ids[OpportunityLifetime::MAX_LENGTH];
+  int64_t first_seen_ns;
+  double peak_log_profit;
+  /// @brief Opened inside the shard, rather than during warm-up.
+  bool recorded;
+};
+
+}
+
+void LifetimeReport::merge(const LifetimeReport& other) {
+  ticks += other.ticks;
+  all.merge(other.all);
+  for (int h = 0; h < 24; h++) {
+    hours[h].occurrences += other.hours[h].occurrences;
+    hours[h].durations.merge(other.hours[h].durations);
+    hours[h].peak_log_profit_sum += other.hours[h].peak_log_profit_sum;
+  }
+  for (const auto& [key, theirs] : other.cycles) {
+    auto [it, inserted] = cycles.try_emplace(key, theirs);
+    if (inserted) {
+      continue;
+    }
+    CycleLifetimeStats& mine = it->second;
+    mine.occurrences += theirs.occurrences;
+    mine.censored += theirs.censored;
+    mine.durations.merge(theirs.durations);
+    mine.peak_log_profit_max = std::max(mine.peak_log_profit_max, theirs.peak_log_profit_max);
+    mine.peak_log_profit_sum += theirs.peak_log_profit_sum;
+    for (size_t p = 0; p < mine.closed_by_pair.size(); p++) {
+      mine.closed_by_pair[p] += theirs.closed_by_pair[p];
+    }
+  }
+}
+
+/**
+ * @brief Replays shard [first, last) with warm-up before it and follow-up after it.
+ */
+LifetimeReport LifetimeAnalyzer::run_shard(const LifetimeConfig& config, size_t first, size_t last) const {
+  const std::vector<std::string>& symbols = archive.symbols();
+  size_t num_pairs = symbols.size();
+
+  int64_t shard_start_ts = archive[first].receive_ts_ns;
+  const TickRecord* warm_start = std::lower_bound(
+      archive.begin(), archive.begin() + first, shard_start_ts - config.warmup_ns,
+      [](const TickRecord& record, int64_t ts) { return record.receive_ts_ns < ts; });
+  int64_t follow_until_ts = archive[last - 1].receive_ts_ns + config.max_lifetime_ns;
+
+  ArbitrageGraph graph(symbols);
+  std::vector<OpenCycle> open;
+  Opportunity opportunity;
+  LifetimeReport report;
+  report.ticks = last - first;
+
+  auto stats_for = [&](const OpenCycle& cycle) -> CycleLifetimeStats& {
+    CycleLifetimeStats& stats = report.cycles[cycle.key];
+    if (stats.currency_ids.empty()) {
+      stats.currency_ids.assign(cycle.currency_ids, cycle.currency_ids + cycle.length);
+      stats.closed_by_pair.assign(num_pairs, 0);
+    }
+    return stats;
+  };
+
+  for (size_t i = warm_start - archive.begin(); i < archive.size(); i++) {
+    const TickRecord& tick = archive[i];
+    int64_t ts = tick.receive_ts_ns;
+    if (i >= last && (open.empty() || ts > follow_until_ts)) {
+      break;
+    }
+    if (tick.kind != TickKind::Trade) {
+      continue;
+    }
+
+    int pair_id = static_cast<int>(tick.pair_id);
+    graph.update_price(pair_id, tick.price, tick.exchange_ts_ns, ts);
+
+    /* Re-price open opportunities; this tick closes any that are no longer profitable */
+    for (size_t k = 0; k < open.size();) {
+      OpenCycle& cycle = open[k];
+      double log_profit = graph.cycle_log_profit(cycle.currency_ids, cycle.length);
+      if (log_profit > 0.0) {
+        cycle.peak_log_profit = std::max(cycle.peak_log_profit, log_profit);
+        k++;
+        continue;
+      }
+
+      if (cycle.recorded) {
+        int64_t duration = ts - cycle.first_seen_ns;
+        CycleLifetimeStats& stats = stats_for(cycle);
+        stats.occurrences++;
+        stats.durations.add(duration);
+        stats.peak_log_profit_max = std::max(stats.peak_log_profit_max, cycle.peak_log_profit);
+        stats.peak_log_profit_sum += cycle.peak_log_profit;
+        stats.closed_by_pair[pair_id]++;
+
+        HourLifetimeStats& hour = report.hours[(cycle.first_seen_ns / NANOS_PER_HOUR) % 24];
+        hour.occurrences++;
+        hour.durations.add(duration);
+        hour.peak_log_profit_sum += cycle.peak_log_profit;
+        report.all.add(duration);
+      }
+      open[k] = open.back();
+      open.pop_back();
+    }
+
+    if (!graph.find_arbitrage_cycle(opportunity) || i >= last) {
+      continue;
+    }
+
+    OpenCycle cycle;
+    cycle.key = canonical_cycle_key(opportunity.currency_ids, opportunity.num_legs, cycle.currency_ids);
+    cycle.length = opportunity.num_legs;
+    bool already_open = std::any_of(open.begin(), open.end(),
+                                    [&](const OpenCycle& other) { return other.key == cycle.key; });
+    if (already_open) {
+      continue;
+    }
+    cycle.first_seen_ns = ts;
+    cycle.peak_log_profit = opportunity.log_profit;
+    cycle.recorded = i >= first;
+    open.push_back(cycle);
+  }
+
+  for (const OpenCycle& cycle : open) {
+    if (cycle.recorded) {
+      stats_for(cycle).censored++;
+    }
+  }
+  return report;
+}
+
+LifetimeReport LifetimeAnalyzer::run(const LifetimeConfig& config, unsigned num_threads) const {
+  /* Cut the archive into shards at `shard_ns` boundaries; records are in time order */
+  std::vector<std::pair<size_t, size_t>> shards;
+  size_t first = 0;
+  for (size_t i = 1; i <= archive.size(); i++) {
+    if (i == archive.size() ||
+        archive[i].receive_ts_ns / config.shard_ns != archive[first].receive_ts_ns / config.shard_ns) {
+      shards.push_back({first, i});
+      first = i;
+    }
+  }
+
+  std::vector<LifetimeReport> shard_reports(shards.size());
+  parallel_for(shards.size(), num_threads, [&](size_t shard) {
+    shard_reports[shard] = run_shard(config, shards[shard].first, shards[shard].second);
+  });
+
+  LifetimeReport report;
+  for (const LifetimeReport& shard_report : shard_reports) {
+    report.merge(shard_report);
+  }
+  return report;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "durationhistogram.h"
+#include "tickarchive.h"
+
+/**
+ * @struct CycleLifetimeStats
+ * @brief Every observed lifetime of one cycle.
+ */
+struct CycleLifetimeStats {
+  /// @brief Canonical currency sequence (smallest ID first, trading direction kept).
+  std::vector<int> currency_ids;
+  size_t occurrences = 0;
+  /// @brief Opportunities still open when the shard's replay ended; not in `durations`.
+  size_t censored = 0;
+  DurationHistogram durations;
+  double peak_log_profit_max = 0.0;
+  double peak_log_profit_sum = 0.0;
+  /// @brief How many times a tick on each pair (by pair ID) closed the cycle.
+  std::vector<size_t> closed_by_pair;
+};
+
+/**
+ * @struct HourLifetimeStats
+ * @brief Lifetimes of opportunities that opened within one UTC hour of the day.
+ */
+struct HourLifetimeStats {
+  size_t occurrences = 0;
+  DurationHistogram durations;
+  double peak_log_profit_sum = 0.0;
+};
+
+/**
+ * @struct LifetimeReport
+ * @brief Opportunity lifetimes aggregated per cycle and per UTC hour of the day.
+ */
+struct LifetimeReport {
+  size_t ticks = 0;
+  std::unordered_map<uint64_t, CycleLifetimeStats> cycles;
+  HourLifetimeStats hours[24];
+  DurationHistogram all;
+
+  void merge(const LifetimeReport& other);
+};
+
+/**
+ * @struct LifetimeConfig
+ * @brief Sharding and warm-up for a lifetime analysis.
+ */
+struct LifetimeConfig {
+  /// @brief Length of each independently replayed shard.
+  int64_t shard_ns = 3600LL * 1000000000LL;
+  /// @brief Ticks replayed before a shard starts so every pair is priced and open cycles are known.
+  int64_t warmup_ns = 300LL * 1000000000LL;
+  /// @brief How long past the shard's end to keep following its open opportunities.
+  int64_t max_lifetime_ns = 60LL * 1000000000LL;
+};
+
+/**
+ * @class LifetimeAnalyzer
+ * @brief Measures how long detected arbitrage cycles survive in recorded data.
+ *
+ * An opportunity opens when the graph first detects its cycle and closes on the
+ * first tick after which the cycle's rate product is no longer above 1; that
+ * tick's pair is recorded as the one that closed it. Open cycles are re-priced
+ * after every trade tick, so a cycle's lifetime does not depend on the detector
+ * reporting it again. The detector returns one cycle per tick, so a cycle that
+ * is always masked by a more negative one is never opened.
+ *
+ * The archive is cut into shards that are replayed in parallel by independent
+ * graphs. Each shard first replays a warm-up window and then follows its
+ * opportunities past its end, so results do not depend on the shard boundaries
+ * except for opportunities longer than `max_lifetime_ns`, which are counted as
+ * censored.
+ */
+class LifetimeAnalyzer {
+public:
+  explicit LifetimeAnalyzer(const TickArchive& archive) : archive(archive) {}
+
+  /**
+   * @param num_threads Worker threads; 0 means one per hardware thread.
+   */
+  LifetimeReport run(const LifetimeConfig& config, unsigned num_threads) const;
+
+private:
+  const TickArchive& archive;
+
+  LifetimeReport run_shard(const LifetimeConfig& config, size_t first, size_t last) const;
+};
@@ -4,23 +4,125 @@
 #include <sstream>
 #include <chrono>
 #include <thread>
+#include <functional>
+#include <atomic>
+#include <algorithm>
 
-#include "blockingconcurrentqueue.h"
+#include "multicastring.h"
 #include "arbitragegraph.h"
+#include "enginearena.h"
+#include "exchangesimulator.h"
+#include "cycleexecution.h"
+#include "ordergateway.h"
+#include "riskmanager.h"
+#include "inventory.h"
+#include "opportunitytracker.h"
+#include "feedlatency.h"
+#include "featureengine.h"
+#include "waitstrategy.h"
+#include "tickarchive.h"
+#include "clock.h"
 
-struct PriceUpdate {
-  std::string symbol;
-  double price;
-  /** TODO: Add timestamp, etc. */
+const std::vector<std::string> SYMBOLS = {"BTC-USD", "ETH-USD", "ETH-BTC"};
+const std::string VALUATION_CURRENCY = "USD";
+const double CYCLE_NOTIONAL = 1000.0;
+const double LIMIT_TOLERANCE_BPS = 2.0;
+const double MAX_CYCLE_NOTIONAL = 5000.0;
+const double MAX_ASSET_NOTIONAL = 20000.0;
+const double MAX_ORDERS_PER_SECOND = 30.0;
+const double MAX_ORDER_BURST = 9.0;
+const int64_t QUOTE_TTL_NS = 5000000000;
+const size_t OPPORTUNITY_TABLE_SIZE = 1024;
+const int64_t OPPORTUNITY_LIVE_GAP_NS = 500000000;
+const double OPPORTUNITY_IMPROVEMENT_BPS = 1.0;
+const std::string FEED_DELAY_EXPORT = "feed_delays.csv";
+const std::string TICK_JOURNAL = "live_ticks.bin";
+const size_t TICK_RING_CAPACITY = 4096;
+const int64_t JOURNAL_PARK_NS = 1000000;
+const std::vector<std::pair<std::string, double>> STARTING_BALANCES = {{"USD", 10000.0}, {"BTC", 0.1}};
+
+/// @brief `pair_id` of the event that ends the stream.
+const uint32_t END_OF_STREAM = UINT32_MAX;
+
+/**
+ * @struct TickEvent
+ * @brief One slot of the tick ring: a trade from the IO thread, plus what the stages before the detector add to it.
+ *
+ * Both stamps of `tick` are wall-clock nanoseconds since the epoch (0 if
+ * unknown). The CSV capture carries no receive time, so, as when `TickArchive`
+ * loads it, the exchange time stands in for it and no feed delay is measured.
+ */
+struct TickEvent {
+  TickRecord tick;
+  /// @brief Steady-clock time the IO thread published the event, for wake-up latency.
+  int64_t publish_ts_ns = 0;
+  /// @brief The pair's features just after this tick, written by the feature stage.
+  PairFeatures features;
+};
+
+using TickRing = MulticastRing<TickEvent>;
+
+/**
+ * @struct TickConsumers
+ * @brief Consumer IDs of the stages reading the tick ring.
+ *
+ * The journal and the feature engine read every tick independently; the
+ * detector trails the feature engine, so it sees each tick's features.
+ */
+struct TickConsumers {
+  int journal;
+  int features;
+  int detector;
 };
 
-void io_thread_fn(moodycamel::BlockingConcurrentQueue<PriceUpdate> queue) {
+std::string trim(const std::string& field) {
+  size_t first = field.find_first_not_of(" \t\r");
+  if (first == std::string::npos) {
+    return "";
+  }
+  size_t last = field.find_last_not_of(" \t\r");
+  return field.substr(first, last - first + 1);
+}
+
+/**
+ * @brief Hands each tick of the ring to `handler` until the end of the stream, waiting in between as `waiter` says.
+ *
+ * Signals `progress` after every batch, so Blocking stages trailing this one wake.
+ */
+template <typename Handler>
+void consume_ticks(TickRing& ring, int consumer, WaitStrategy& waiter, WakeSignal& progress, Handler&& handler) {
+  bool running = true;
+  while (running) {
+    bool waited = waiter.wait_until([&]() { return ring.available_to(consumer) > ring.cursor(consumer); });
+    ring.poll(consumer, [&](TickEvent& event, int64_t) {
+      if (waited) {
+        waiter.record_wakeup(steady_now_ns() - event.publish_ts_ns);
+        waited = false;
+      }
+      if (event.tick.pair_id == END_OF_STREAM) {
+        running = false;
+      } else {
+        handler(event);
+      }
+    });
+    progress.notify();
+  }
+}
+
+void print_wait_stats(const char* stage, const WaitStrategy& waiter) {
+  WaitStats stats = waiter.stats();
+  std::cout << stage << ": Waited (" << wait_kind_name(waiter.settings().kind) << ") " << stats.waits
+            << " times, wake-up p50 " << stats.wakeup.quantile_ns(0.5) / 1000 << "us p99 "
+            << stats.wakeup.quantile_ns(0.99) / 1000 << "us, idle " << stats.idle_ns / 1000000 << "ms, CPU "
+            << static_cast<int>(100 * stats.cpu_share()) << "% of a core" << std::endl;
+}
+
+void io_thread_fn(TickRing& ring, WakeSignal& ticks_ready, const PairCatalog& catalog) {
   std::cout << "IO Thread: Starting Up..." << std::endl;
 
   std::ifstream inputFile("trade_data_coinbase.csv");
   if (!inputFile.is_open()) {
     std::cerr << "Error: Could not open file." << std::endl;
-    return;
   }
 
   std::string line;
@@ -37,52 +139,241 @@ void io_thread_fn(moodycamel::BlockingConcurrentQueue<PriceUpdate> queue) {
     std::getline(ss, price_str, delimiter);
     std::getline(ss, quantity_str, delimiter);
 
-    PriceUpdate new_update;
-    new_update.symbol = symbol_str;
-    new_update.price = std::stod(price_str);
+    std::string symbol = trim(symbol_str);
+    int pair_id = catalog.find_pair(symbol);
+    if (pair_id < 0) {
+      std::cerr << "IO Thread: Ignoring update for untracked pair " << symbol << std::endl;
+      continue;
+    }
 
-    queue.enqueue(new_update);
+    /* Written once into the ring; every stage reads this same slot */
+    TickEvent& event = ring.claim();
+    TickRecord& tick = event.tick;
+    tick.pair_id = static_cast<uint32_t>(pair_id);
+    tick.kind = TickKind::Trade;
+    tick.price = std::stod(price_str);
+    tick.quantity = std::stod(quantity_str);
+    std::string exchange_time = trim(timestamp_str);
+    tick.exchange_ts_ns = std::max<int64_t>(0, parse_timestamp_ns(exchange_time.data(), exchange_time.size()));
+    tick.receive_ts_ns = tick.exchange_ts_ns;
+    event.publish_ts_ns = steady_now_ns();
+    ring.publish();
+    ticks_ready.notify();
 
     std::this_thread::sleep_for(std::chrono::milliseconds(5));
   }
 
-  std::cout << "IO Thread: Finished reading file. Sending poison pill." << std::endl;
+  std::cout << "IO Thread: Finished reading file. Publishing end of stream." << std::endl;
+
+  TickEvent& end = ring.claim();
+  end.tick.pair_id = END_OF_STREAM;
+  end.publish_ts_ns = steady_now_ns();
+  ring.publish();
+  ticks_ready.notify();
+}
+
+void journal_thread_fn(TickRing& ring, WakeSignal& ticks_ready, int consumer) {
+  /* Off the trading path, so it parks rather than holding a core */
+  WaitConfig wait_config;
+  wait_config.kind = WaitKind::SpinPark;
+  wait_config.park_ns = JOURNAL_PARK_NS;
+  WaitStrategy waiter(wait_config);
 
-  PriceUpdate poison_pill;
-  poison_pill.symbol = "STOP";
-  queue.enqueue(poison_pill);
+  TickArchiveWriter journal(TICK_JOURNAL, SYMBOLS);
+  uint64_t written = 0;
+  consume_ticks(ring, consumer, waiter, ticks_ready, [&](const TickEvent& event) {
+    journal.append(event.tick);
+    written++;
+  });
+  std::cout << "Journal Thread: Wrote " << written << " ticks to " << TICK_JOURNAL << std::endl;
+  print_wait_stats("Journal Thread", waiter);
 }
 
-void logic_thread_fn(moodycamel::BlockingConcurrentQueue<PriceUpdate> queue) {
+void features_thread_fn(TickRing& ring, WakeSignal& ticks_ready, int consumer, WaitConfig wait_config) {
+  WaitStrategy waiter(wait_config, &ticks_ready);
+  FeatureEngine features(static_cast<int>(SYMBOLS.size()));
+  consume_ticks(ring, consumer, waiter, ticks_ready, [&](TickEvent& event) {
+    features.on_tick(event.tick);
+    event.features = features.pair(static_cast<int>(event.tick.pair_id));
+  });
+  print_wait_stats("Features Thread", waiter);
+}
+
+void logic_thread_fn(TickRing& ring, WakeSignal& ticks_ready, int consumer, WaitConfig wait_config) {
   std::cout << "Logic Thread: Starting Up and Waiting for Data..." << std::endl;
 
-  while(true) {
-    PriceUpdate received_update;
+  /* Constructed on this thread, so the region prefers the NUMA node the engine runs on */
+  EngineArena arena;
+  ArbitrageGraph graph(SYMBOLS, 0, 0, &arena);
+  const PairCatalog& catalog = graph.catalog();
+  for (int pair_id = 0; pair_id < catalog.num_pairs(); pair_id++) {
+    graph.set_pair_ttl(pair_id, QUOTE_TTL_NS);
+  }
+  int valuation_id = catalog.find_currency(VALUATION_CURRENCY);
 
-    queue.wait_dequeue(received_update);
+  SimulatorConfig sim_config;
+  sim_config.order_latency = {LatencyDistribution::LogNormal, 400000.0, 0.5};
+  sim_config.report_latency = {LatencyDistribution::LogNormal, 400000.0, 0.5};
+  sim_config.synthetic_half_spread_bps = 1.0;
+  sim_config.taker_fee_bps = 5.0;
+  ExchangeSimulator simulator(catalog, sim_config);
+  CycleExecutor executor(catalog, simulator, valuation_id, CYCLE_NOTIONAL, LIMIT_TOLERANCE_BPS);
 
-    if (received_update.symbol == "STOP") {
-      std::cout << "Logic Thread: Poison pill received. Shutting down." << std::endl;
-      break;
+  RiskConfig risk_config;
+  risk_config.max_cycle_notional = MAX_CYCLE_NOTIONAL;
+  risk_config.orders_per_second = MAX_ORDERS_PER_SECOND;
+  risk_config.order_burst = MAX_ORDER_BURST;
+  RiskManager risk(catalog.num_currencies(), risk_config);
+  for (int id = 0; id < catalog.num_currencies(); id++) {
+    risk.set_notional_limit(id, MAX_ASSET_NOTIONAL);
+  }
+  executor.set_risk_manager(&risk);
+
+  Inventory inventory(catalog.num_currencies());
+  for (const auto& [currency, amount] : STARTING_BALANCES) {
+    inventory.set_balance(catalog.find_currency(currency), amount);
+  }
+  graph.set_inventory(&inventory);
+  executor.set_inventory(&inventory);
+
+  OpportunityTracker opportunities(OPPORTUNITY_TABLE_SIZE, OPPORTUNITY_LIVE_GAP_NS,
+                                   OPPORTUNITY_IMPROVEMENT_BPS * 1e-4);
+
+  /* Orders leave through the gateway stage, which feeds the simulator in-process */
+  SimulatorOrderSink order_sink(simulator);
+  OrderGateway gateway(catalog, order_sink, WireFormat::Binary);
+  executor.route_through(&gateway);
+  std::atomic<bool> stop_gateway{false};
+  std::thread gateway_thread([&gateway, &stop_gateway]() { gateway.run(stop_gateway); });
+
+  FeedDelayMonitor feed_delays(catalog.num_pairs(), 1.0 / 64.0, arena.resource("metrics"));
+
+  WaitStrategy waiter(wait_config, &ticks_ready);
+  Opportunity opportunity;
+  consume_ticks(ring, consumer, waiter, ticks_ready, [&](const TickEvent& event) {
+    const TickRecord& tick = event.tick;
+    int pair_id = static_cast<int>(tick.pair_id);
+    /* The replay clock says nothing about the feed, so only the IO-to-logic queue delay is timed, on the steady clock */
+    feed_delays.record(pair_id, 0, event.publish_ts_ns, steady_now_ns());
+
+    /* Orders that arrived before this tick match against the book as it was */
+    int64_t tick_ts = steady_now_ns();
+    simulator.advance_to(tick_ts);
+    simulator.on_trade(pair_id, tick.price, tick.quantity, tick_ts);
+    for (int currency_id : {catalog.base_id(pair_id), catalog.quote_id(pair_id)}) {
+      double mark = simulator.convert(1.0, currency_id, valuation_id);
+      risk.set_mark(currency_id, mark);
+      inventory.set_mark(currency_id, mark);
+    }
+
+    Fill fill;
+    CycleResult result;
+    while (simulator.poll_fill(fill) || gateway.poll_rejection(fill)) {
+      if (executor.on_fill(fill, result)) {
+        std::cout << "Logic Thread: Cycle " << result.cycle_id << (result.complete ? " filled" : " incomplete")
+                  << " (" << result.legs_filled << "/" << result.legs << " legs), PnL "
+                  << result.realised_pnl << " " << VALUATION_CURRENCY << ", tick-to-fill "
+                  << result.tick_to_fill_ns() / 1000 << "us" << std::endl;
+      }
+    }
+
+    graph.update_price(pair_id, tick.price, tick.exchange_ts_ns, tick_ts);
+
+    int expired[8];
+    int num_expired = graph.expire_stale(tick_ts, expired, 8);
+    for (int i = 0; i < num_expired; i++) {
+      std::cout << "Logic Thread: Quotes for " << catalog.symbol(expired[i]) << " expired" << std::endl;
+    }
+
+    if (graph.find_arbitrage_cycle(opportunity)) {
+      /* Entries of cycles that stopped appearing are only freed by a sweep, run at most once per live gap */
+      opportunities.expire_if_due(tick_ts, nullptr, 0);
+
+      /* A cycle that is still live is only acted on again if it has become more profitable */
+      TrackVerdict verdict = opportunities.observe(opportunity.currency_ids, opportunity.num_legs,
+                                                   opportunity.log_profit, tick_ts);
+      if (verdict == TrackVerdict::Suppressed) {
+        return;
+      }
+      if (executor.execute(opportunity, tick_ts, steady_now_ns())) {
+        std::cout << "Logic Thread: Sent cycle";
+        for (int leg = 0; leg <= opportunity.num_legs; leg++) {
+          std::cout << " " << catalog.currency_name(opportunity.currency_ids[leg]);
+        }
+        std::cout << " on " << catalog.symbol(pair_id) << " after " << event.features.trades << " trades"
+                  << ", mean interval " << event.features.interval_ewma_ns / 1e6 << "ms" << std::endl;
+      }
     }
+  });
+  std::cout << "Logic Thread: End of stream. Shutting down." << std::endl;
+  print_wait_stats("Logic Thread", waiter);
+
+  stop_gateway.store(true, std::memory_order_release);
+  gateway_thread.join();
 
-    std::cout << "Logic Thread: Dequeued update for " << received_update.symbol << " at price " << received_update.price << std::endl;
-    
-    /** TODO: add core logic */
+  for (int pair_id = 0; pair_id < catalog.num_pairs(); pair_id++) {
+    const FeedDelayStats& stats = feed_delays.stats(pair_id);
+    std::cout << "Logic Thread: " << catalog.symbol(pair_id) << " queue delay p50 "
+              << stats.queue.quantile_ns(0.5) / 1000 << "us, p99 " << stats.queue.quantile_ns(0.99) / 1000
+              << "us over " << stats.queue.total << " updates" << std::endl;
   }
+  feed_delays.write_csv(FEED_DELAY_EXPORT, SYMBOLS);
+
+  for (const ArenaUsage& usage : arena.usage()) {
+    std::cout << "Logic Thread: Arena " << usage.name << " holds " << usage.bytes << " bytes (peak "
+              << usage.peak_bytes << ") in " << usage.allocations << " allocations" << std::endl;
+  }
+  std::cout << "Logic Thread: Arena used " << arena.reserved_bytes() << " of " << arena.capacity_bytes()
+            << " bytes on NUMA node " << arena.numa_node() << std::endl;
+
+  std::cout << "Logic Thread: Session PnL " << simulator.mark_to_market(valuation_id)
+            << " " << VALUATION_CURRENCY << std::endl;
 }
 
-int main() {
+int main(int argc, char** argv) {
+  /* The feature stage and the detector are both on the tick-to-trade path, so they share a strategy */
+  WaitConfig wait_config;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--wait" && i + 1 < argc) {
+      wait_config.kind = parse_wait_kind(argv[++i]);
+    } else if (arg == "--spin-budget" && i + 1 < argc) {
+      wait_config.spin_budget = static_cast<uint32_t>(std::stoul(argv[++i]));
+    } else if (arg == "--park-us" && i + 1 < argc) {
+      wait_config.park_ns = std::stoll(argv[++i]) * 1000;
+    } else {
+      std::cerr << "Usage: " << argv[0] << " [--wait spin|yield|park|block] [--spin-budget N] [--park-us US]"
+                << std::endl;
+      return 1;
+    }
+  }
+
   std::cout << "Creating and Launching Threads..." << std::endl;
 
-  moodycamel::BlockingConcurrentQueue<PriceUpdate> shared_queue;
+  /* The IO thread resolves symbols against the same registration order the graph uses */
+  PairCatalog catalog;
+  for (const std::string& symbol : SYMBOLS) {
+    catalog.add_pair(symbol);
+  }
+
+  TickRing ring(TICK_RING_CAPACITY);
+  WakeSignal ticks_ready;
+  TickConsumers consumers;
+  consumers.journal = ring.add_consumer();
+  consumers.features = ring.add_consumer();
+  consumers.detector = ring.add_consumer({consumers.features});
 
-  std::thread io_thread(io_thread_fn, shared_queue);
-  std::thread logic_thread(logic_thread_fn, shared_queue);
+  std::thread journal_thread(journal_thread_fn, std::ref(ring), std::ref(ticks_ready), consumers.journal);
+  std::thread features_thread(features_thread_fn, std::ref(ring), std::ref(ticks_ready), consumers.features,
+                              wait_config);
+  std::thread logic_thread(logic_thread_fn, std::ref(ring), std::ref(ticks_ready), consumers.detector, wait_config);
+  std::thread io_thread(io_thread_fn, std::ref(ring), std::ref(ticks_ready), std::cref(catalog));
 
   std::cout << "Main: Threads launched." << std::endl;
 
   io_thread.join();
+  journal_thread.join();
+  features_thread.join();
   logic_thread.join();
 
   return 0;
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @class MulticastRing
+ * @brief A single-producer, multi-consumer sequenced ring (Disruptor-style) that every consumer reads in full.
+ *
+ * The producer writes each event once into a preallocated slot and publishes its
+ * sequence number; every consumer reads the same slots at its own cursor, so
+ * fanning a stream out to N stages costs one write and N reads rather than N
+ * enqueues. A consumer can be made to trail others: it only sees a sequence once
+ * every consumer it was registered `after` has processed it, which also lets it
+ * read whatever those consumers wrote into the slot. The producer only reuses a
+ * slot once every consumer has moved past it.
+ *
+ * Each cursor lives on its own cache line and is written once per batch, with
+ * release ordering; readers pair it with acquire loads. Consumers may write to
+ * the fields of an event that no concurrent consumer reads (results for the
+ * stages after them). Consumers must be registered before the first `claim`.
+ */
+template <typename T>
+class MulticastRing {
+public:
+  static constexpr int MAX_CONSUMERS = 8;
+
+  /**
+   * @param capacity Events the ring holds; rounded up to a power of two.
+   */
+  explicit MulticastRing(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    this->slots.resize(size);
+    this->mask = size - 1;
+  }
+
+  MulticastRing(const MulticastRing&) = delete;
+  MulticastRing& operator=(const MulticastRing&) = delete;
+
+  /**
+   * @brief Registers a consumer that reads each event only after every consumer in `after` has.
+   * @return The consumer's ID, to pass to `poll`.
+   * @throws std::runtime_error if there are too many consumers or a dependency is unknown.
+   */
+  int add_consumer(const std::vector<int>& after = {}) {
+    if (num_consumers == MAX_CONSUMERS) {
+      throw std::runtime_error("MulticastRing supports at most " + std::to_string(MAX_CONSUMERS) + " consumers");
+    }
+    for (int dependency : after) {
+      if (dependency < 0 || dependency >= num_consumers) {
+        throw std::runtime_error("MulticastRing consumer depends on unknown consumer " + std::to_string(dependency));
+      }
+    }
+    this->barriers[num_consumers] = after;
+    return num_consumers++;
+  }
+
+  size_t capacity() const { return slots.size(); }
+
+  // --- Producer ---
+
+  /**
+   * @brief The slot for the next sequence, or nullptr if the slowest consumer is a full ring behind.
+   * The event becomes visible at `publish`.
+   */
+  T* try_claim() {
+    int64_t sequence = claimed + 1;
+    if (sequence - static_cast<int64_t>(slots.size()) > cached_gate) {
+      this->cached_gate = slowest_cursor();
+      if (sequence - static_cast<int64_t>(slots.size()) > cached_gate) {
+        return nullptr;
+      }
+    }
+    this->claimed = sequence;
+    return &slots[static_cast<size_t>(sequence) & mask];
+  }
+
+  /**
+   * @brief The slot for the next sequence, yielding until the slowest consumer frees it.
+   */
+  T& claim() {
+    T* slot;
+    while ((slot = try_claim()) == nullptr) {
+      std::this_thread::yield();
+    }
+    return *slot;
+  }
+
+  /// @brief Makes the claimed event visible to consumers.
+  void publish() { published.value.store(claimed, std::memory_order_release); }
+
+  /// @brief The last published sequence, or -1.
+  int64_t last_published() const { return published.value.load(std::memory_order_acquire); }
+
+  // --- Consumers ---
+
+  /**
+   * @brief Hands every event available to `consumer` to `handler(event, sequence)`, then advances its cursor once.
+   * @param max_batch Most events handled in this call.
+   * @return Number of events handled.
+   */
+  template <typename Handler>
+  size_t poll(int consumer, Handler&& handler, size_t max_batch = SIZE_MAX) {
+    int64_t next = cursors[consumer].value.load(std::memory_order_relaxed) + 1;
+    int64_t limit = available_to(consumer);
+    if (limit < next || max_batch == 0) {
+      return 0;
+    }
+    if (static_cast<uint64_t>(limit - next) >= max_batch) {
+      limit = next + static_cast<int64_t>(max_batch) - 1;
+    }
+    for (int64_t sequence = next; sequence <= limit; sequence++) {
+      handler(slots[static_cast<size_t>(sequence) & mask], sequence);
+    }
+    cursors[consumer].value.store(limit, std::memory_order_release);
+    return static_cast<size_t>(limit - next + 1);
+  }
+
+  /// @brief The last sequence `consumer` has processed, or -1.
+  int64_t cursor(int consumer) const { return cursors[consumer].value.load(std::memory_order_acquire); }
+
+  /// @brief The highest sequence `consumer` may read: the last published one, capped by its barrier.
+  int64_t available_to(int consumer) const {
+    int64_t limit = published.value.load(std::memory_order_acquire);
+    for (int dependency : barriers[consumer]) {
+      limit = std::min(limit, cursors[dependency].value.load(std::memory_order_acquire));
+    }
+    return limit;
+  }
+
+private:
+  /**
+   * @struct Sequence
+   * @brief A sequence number alone on its cache line.
+   */
+  struct alignas(64) Sequence {
+    std::atomic<int64_t> value{-1};
+  };
+
+  std::vector<T> slots;
+  size_t mask;
+
+  Sequence published;
+  Sequence cursors[MAX_CONSUMERS];
+  std::vector<int> barriers[MAX_CONSUMERS];
+  int num_consumers = 0;
+
+  // --- Producer-only state ---
+
+  alignas(64) int64_t claimed = -1;
+  /// @brief Slowest cursor seen at the last check; only re-read when the ring looks full.
+  int64_t cached_gate = -1;
+
+  int64_t slowest_cursor() const {
+    int64_t slowest = claimed;
+    for (int c = 0; c < num_consumers; c++) {
+      slowest = std::min(slowest, cursors[c].value.load(std::memory_order_acquire));
+    }
+    return slowest;
+  }
+};
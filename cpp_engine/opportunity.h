@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+/**
+ * @struct Opportunity
+ * @brief A detected arbitrage cycle as plain data, written into caller-provided storage.
+ *
+ * Leg `i` trades `currency_ids[i]` into `currency_ids[i + 1]` over graph edge
+ * `edge_slots[i]` at `rates[i]`. Edge slot `2 * pair_id` is the pair's
+ * base -> quote edge (a sell of the base) and `2 * pair_id + 1` its
+ * quote -> base edge (a buy of the base). Currency names are resolved through
+ * the graph's PairCatalog, and only when logging.
+ */
+struct Opportunity {
+  static constexpr int MAX_LEGS = 8;
+
+  int num_legs;
+  /// @brief Currency IDs in trading order, with the start repeated at `num_legs`.
+  int currency_ids[MAX_LEGS + 1];
+  uint32_t edge_slots[MAX_LEGS];
+  /// @brief Units of the next currency received per unit of the current one.
+  double rates[MAX_LEGS];
+  /// @brief Log of the rate product around the cycle; positive means profit before fees.
+  double log_profit;
+  /// @brief Timestamps of the price update that triggered the detection.
+  int64_t exchange_ts_ns;
+  int64_t receive_ts_ns;
+};
+static_assert(std::is_trivial<Opportunity>::value && std::is_standard_layout<Opportunity>::value,
+              "Opportunity is filled in place on the detection path");
+
+/// @brief The pair an edge slot trades on.
+inline int edge_pair_id(uint32_t edge_slot) { return static_cast<int>(edge_slot >> 1); }
+
+/// @brief True if the edge slot buys the pair's base (quote -> base).
+inline bool edge_buys_base(uint32_t edge_slot) { return (edge_slot & 1) != 0; }
@@ -0,0 +1,139 @@
+/**
+ * @file opportunitytracker.cpp
+ * @brief Implements opportunity deduplication and lifetime tracking.
+ */
+
+#include "opportunitytracker.h"
+
+#include <algorithm>
+#include <cstring>
+
+uint64_t canonical_cycle_key(const int* cycle, int length, int* canonical) {
+  int start = static_cast<int>(std::min_element(cycle, cycle + length) - cycle);
+
+  /* FNV-1a over the rotated IDs, finished with a 64-bit mixer */
+  uint64_t hash = 14695981039346656037ULL;
+  for (int i = 0; i < length; i++) {
+    canonical[i] = cycle[(start + i) % length];
+    hash = (hash ^ static_cast<uint32_t>(canonical[i])) * 1099511628211ULL;
+  }
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+OpportunityTracker::OpportunityTracker(size_t capacity, int64_t live_gap_ns, double min_improvement)
+  : live_gap_ns(live_gap_ns), min_improvement(min_improvement) {
+  size_t size = 16;
+  while (size < capacity) {
+    size <<= 1;
+  }
+  this->mask = size - 1;
+  this->slots.reset(new Slot[size]());
+}
+
+TrackVerdict OpportunityTracker::observe(const int* cycle, int length, double log_profit, int64_t now_ns) {
+  if (length <= 0 || length > OpportunityLifetime::MAX_LENGTH) {
+    return TrackVerdict::Untracked;
+  }
+
+  int canonical[OpportunityLifetime::MAX_LENGTH];
+  uint64_t key = canonical_cycle_key(cycle, length, canonical);
+
+  size_t index = key & mask;
+  for (size_t probes = 0; probes <= mask; probes++, index = (index + 1) & mask) {
+    Slot& slot = slots[index];
+    OpportunityLifetime& life = slot.lifetime;
+
+    if (life.length == 0) {
+      /* Keep the table at most 3/4 full so probe sequences stay short */
+      if ((occupied + 1) * 4 > (mask + 1) * 3) {
+        return TrackVerdict::Untracked;
+      }
+      life.cycle_key = key;
+      life.length = length;
+      std::memcpy(life.currency_ids, canonical, length * sizeof(int));
+      life.first_seen_ns = now_ns;
+      life.last_seen_ns = now_ns;
+      life.first_log_profit = log_profit;
+      life.peak_log_profit = log_profit;
+      life.observations = 1;
+      life.emissions = 1;
+      slot.last_emitted_profit = log_profit;
+      occupied++;
+      return TrackVerdict::New;
+    }
+
+    if (life.cycle_key != key || life.length != length ||
+        std::memcmp(life.currency_ids, canonical, length * sizeof(int)) != 0) {
+      continue;
+    }
+
+    /* Seen before: a long enough gap means this is a new opportunity on the same cycle */
+    if (now_ns - life.last_seen_ns > live_gap_ns) {
+      life.first_seen_ns = now_ns;
+      life.first_log_profit = log_profit;
+      life.peak_log_profit = log_profit;
+      life.observations = 0;
+      life.emissions = 0;
+      slot.last_emitted_profit = -1e300;
+    }
+
+    life.last_seen_ns = now_ns;
+    life.observations++;
+    life.peak_log_profit = std::max(life.peak_log_profit, log_profit);
+
+    if (life.emissions == 0) {
+      life.emissions = 1;
+      slot.last_emitted_profit = log_profit;
+      return TrackVerdict::New;
+    }
+    if (log_profit >= slot.last_emitted_profit + min_improvement) {
+      life.emissions++;
+      slot.last_emitted_profit = log_profit;
+      return TrackVerdict::Improved;
+    }
+    return TrackVerdict::Suppressed;
+  }
+  return TrackVerdict::Untracked;
+}
+
+/**
+ * @brief Empties a slot and shifts later members of its probe run back to close the gap.
+ */
+void OpportunityTracker::erase(size_t index) {
+  size_t hole = index;
+  size_t next = (hole + 1) & mask;
+  while (slots[next].lifetime.length != 0) {
+    size_t home = slots[next].lifetime.cycle_key & mask;
+    /* The entry may move into the hole only if the hole lies on its probe path */
+    if (((next - home) & mask) >= ((next - hole) & mask)) {
+      slots[hole] = slots[next];
+      hole = next;
+    }
+    next = (next + 1) & mask;
+  }
+  slots[hole].lifetime.length = 0;
+  occupied--;
+}
+
+size_t OpportunityTracker::expire(int64_t now_ns, OpportunityLifetime* out, size_t max_out) {
+  this->swept = true;
+  this->last_sweep_ns = now_ns;
+  size_t reported = 0;
+  size_t index = 0;
+  while (index <= mask) {
+    const OpportunityLifetime& life = slots[index].lifetime;
+    if (life.length != 0 && now_ns - life.last_seen_ns > live_gap_ns) {
+      if (reported < max_out) {
+        out[reported++] = life;
+      }
+      /* Backward shift may pull a later entry into this slot, so look at it again */
+      erase(index);
+      continue;
+    }
+    index++;
+  }
+  return reported;
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "opportunity.h"
+
+enum class TrackVerdict {
+  New,         ///< First sighting, or the previous sighting had expired: emit.
+  Improved,    ///< Still live and profit improved by at least the margin: emit again.
+  Suppressed,  ///< Still live without enough improvement: do not emit.
+  Untracked    ///< Table full or cycle too long to track: emitted without deduplication.
+};
+
+/**
+ * @struct OpportunityLifetime
+ * @brief The life of one opportunity, reported when it expires.
+ */
+struct OpportunityLifetime {
+  static constexpr int MAX_LENGTH = Opportunity::MAX_LEGS;
+
+  uint64_t cycle_key = 0;
+  int length = 0;
+  /// @brief Canonical rotation of the cycle (smallest currency ID first).
+  int currency_ids[MAX_LENGTH];
+  int64_t first_seen_ns = 0;
+  int64_t last_seen_ns = 0;
+  double first_log_profit = 0.0;
+  double peak_log_profit = 0.0;
+  uint32_t observations = 0;
+  uint32_t emissions = 0;
+
+  int64_t duration_ns() const { return last_seen_ns - first_seen_ns; }
+};
+
+/**
+ * @class OpportunityTracker
+ * @brief Suppresses repeat reports of the same cycle while it stays live.
+ *
+ * Cycles are identified by a canonical key: the currency sequence rotated to start
+ * at its smallest ID (direction is kept, since the reverse cycle is a different
+ * trade). A cycle is live while it keeps being observed with gaps no longer than
+ * `live_gap_ns`; while live it is only re-emitted if its log-profit beats the last
+ * emitted value by `min_improvement`.
+ *
+ * The table is a fixed-size, power-of-two, linear-probing hash table allocated
+ * once at construction. Entries are compared on the full currency sequence, so
+ * hash collisions never merge different cycles. A cycle seen again after its
+ * entry expired restarts that same entry, but the entries of cycles that are never
+ * seen again stay in the table until `expire` removes them (with backward-shift
+ * deletion, no tombstones) and reports their lifetimes. Detection loops call
+ * `expire_if_due`, which sweeps at most once per live gap.
+ */
+class OpportunityTracker {
+public:
+  /**
+   * @param capacity Slots in the table; rounded up to a power of two.
+   * @param live_gap_ns Longest gap between sightings for a cycle to count as still live.
+   * @param min_improvement Log-profit improvement required to re-emit a live cycle.
+   */
+  OpportunityTracker(size_t capacity, int64_t live_gap_ns, double min_improvement);
+
+  /**
+   * @brief Records a sighting of a cycle and decides whether it should be emitted.
+   * @param cycle Currency IDs in trading order, without the start repeated at the end.
+   * @param length Number of currencies in the cycle.
+   */
+  TrackVerdict observe(const int* cycle, int length, double log_profit, int64_t now_ns);
+
+  /**
+   * @brief Removes every cycle not seen within the live gap, reporting up to `max_out` of them.
+   * @return Number of lifetimes written to `out`.
+   */
+  size_t expire(int64_t now_ns, OpportunityLifetime* out, size_t max_out);
+
+  /**
+   * @brief Runs `expire` once the table is over half full, unless a sweep already ran within the last live gap.
+   *
+   * Entries that were live at one sweep cannot expire before a full live gap has
+   * passed, so sweeping sooner mostly scans the table for nothing.
+   * @return Number of lifetimes written to `out`.
+   */
+  size_t expire_if_due(int64_t now_ns, OpportunityLifetime* out, size_t max_out) {
+    if (occupied * 2 <= mask + 1 || (swept && now_ns - last_sweep_ns < live_gap_ns)) {
+      return 0;
+    }
+    return expire(now_ns, out, max_out);
+  }
+
+  size_t live_count() const { return occupied; }
+  size_t capacity() const { return mask + 1; }
+
+private:
+  /**
+   * @struct Slot
+   * @brief One table entry; empty when `lifetime.length` is zero.
+   */
+  struct Slot {
+    OpportunityLifetime lifetime;
+    double last_emitted_profit;
+  };
+
+  std::unique_ptr<Slot[]> slots;
+  size_t mask;
+  size_t occupied = 0;
+  int64_t live_gap_ns;
+  double min_improvement;
+  bool swept = false;
+  int64_t last_sweep_ns = 0;
+
+  void erase(size_t index);
+};
+
+/**
+ * @brief Rotates `cycle` so its smallest currency ID comes first and hashes the result.
+ * @param canonical Receives the rotated sequence; must hold `length` entries.
+ */
+uint64_t canonical_cycle_key(const int* cycle, int length, int* canonical);
@@ -0,0 +1,241 @@
+/**
+ * @file orderencoding.cpp
+ * @brief Implements the allocation-free binary and FIX order encoders.
+ */
+
+#include "orderencoding.h"
+
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+const char SOH = '\x01';
+
+/// @brief Room left in front of a FIX body for "8=FIX.4.4|9=NNNN|".
+const size_t FIX_HEADER_GAP = 20;
+
+/// @brief Longest sender/target CompID accepted, so every message fits its buffer.
+const size_t MAX_COMP_ID_LENGTH = 32;
+
+int64_t to_e8(double value) {
+  return static_cast<int64_t>(std::llround(value * 1e8));
+}
+
+/**
+ * @brief Writes the decimal digits of `value` and returns the end pointer.
+ */
+char* write_uint(char* out, uint64_t value) {
+  char digits[20];
+  int count = 0;
+  do {
+    digits[count++] = static_cast<char>('0' + value % 10);
+    value /= 10;
+  } while (value != 0);
+  while (count > 0) {
+    *out++ = digits[--count];
+  }
+  return out;
+}
+
+/**
+ * @brief Writes an 8-decimal fixed-point value without trailing zeros (e.g. "0.0523").
+ */
+char* write_fixed_e8(char* out, int64_t value_e8) {
+  if (value_e8 < 0) {
+    *out++ = '-';
+    value_e8 = -value_e8;
+  }
+  out = write_uint(out, static_cast<uint64_t>(value_e8) / 100000000);
+
+  uint64_t fraction = static_cast<uint64_t>(value_e8) % 100000000;
+  if (fraction != 0) {
+    *out++ = '.';
+    int digits = 8;
+    while (fraction % 10 == 0) {
+      fraction /= 10;
+      digits--;
+    }
+    for (int i = digits - 1; i >= 0; i--) {
+      out[i] = static_cast<char>('0' + fraction % 10);
+      fraction /= 10;
+    }
+    out += digits;
+  }
+  return out;
+}
+
+char* write_two_digits(char* out, unsigned value) {
+  *out++ = static_cast<char>('0' + value / 10);
+  *out++ = static_cast<char>('0' + value % 10);
+  return out;
+}
+
+/// @brief Length of a UTCTimestamp with milliseconds, "YYYYMMDD-HH:MM:SS.sss".
+const size_t UTC_TIMESTAMP_LENGTH = 21;
+
+/**
+ * @brief Writes nanoseconds since the epoch as a FIX UTCTimestamp with milliseconds.
+ *
+ * The date comes from days since the epoch by the proleptic Gregorian calendar
+ * (Hinnant's civil_from_days), so no time zone tables or `gmtime` call are involved.
+ */
+char* write_utc_timestamp(char* out, int64_t epoch_ns) {
+  int64_t epoch_ms = epoch_ns > 0 ? epoch_ns / 1000000 : 0;
+  int64_t days = epoch_ms / 86400000;
+  unsigned ms_of_day = static_cast<unsigned>(epoch_ms % 86400000);
+
+  /* Eras of 400 years starting on 1 March, so the leap day ends the year */
+  int64_t shifted = days + 719468;
+  int64_t era = shifted / 146097;
+  unsigned day_of_era = static_cast<unsigned>(shifted - era * 146097);
+  unsigned year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+  unsigned day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+  unsigned shifted_month = (5 * day_of_year + 2) / 153;
+  unsigned day = day_of_year - (153 * shifted_month + 2) / 5 + 1;
+  unsigned month = shifted_month < 10 ? shifted_month + 3 : shifted_month - 9;
+  unsigned year = static_cast<unsigned>(era * 400 + year_of_era) + (month <= 2 ? 1 : 0);
+
+  out = write_two_digits(out, year / 100 % 100);
+  out = write_two_digits(out, year % 100);
+  out = write_two_digits(out, month);
+  out = write_two_digits(out, day);
+  *out++ = '-';
+  out = write_two_digits(out, ms_of_day / 3600000);
+  *out++ = ':';
+  out = write_two_digits(out, ms_of_day / 60000 % 60);
+  *out++ = ':';
+  out = write_two_digits(out, ms_of_day / 1000 % 60);
+  *out++ = '.';
+  unsigned millis = ms_of_day % 1000;
+  *out++ = static_cast<char>('0' + millis / 100);
+  return write_two_digits(out, millis % 100);
+}
+
+char* write_tag(char* out, const char* tag_and_equals, size_t length) {
+  std::memcpy(out, tag_and_equals, length);
+  return out + length;
+}
+
+}
+
+BinaryOrderEncoder::BinaryOrderEncoder(const PairCatalog& catalog) {
+  this->templates.resize(catalog.num_pairs());
+  for (int pair_id = 0; pair_id < catalog.num_pairs(); pair_id++) {
+    BinaryOrderMessage& message = templates[pair_id];
+    std::memset(&message, 0, sizeof(message));
+    message.message_type = BinaryOrderMessage::NEW_ORDER;
+    message.length = sizeof(BinaryOrderMessage);
+    message.pair_id = static_cast<uint32_t>(pair_id);
+    message.time_in_force = BinaryOrderMessage::TIME_IN_FORCE_IOC;
+  }
+}
+
+size_t BinaryOrderEncoder::encode(const Order& order, char* out) const {
+  BinaryOrderMessage message = templates[order.pair_id];
+  message.order_id = order.order_id;
+  message.cycle_id = order.cycle_id;
+  message.price_e8 = to_e8(order.limit_price);
+  message.quantity_e8 = to_e8(order.quantity);
+  message.send_ts_ns = order.send_ts_ns;
+  message.side = static_cast<uint8_t>(order.side);
+  std::memcpy(out, &message, sizeof(message));
+  return sizeof(message);
+}
+
+FixOrderEncoder::FixOrderEncoder(const PairCatalog& catalog, const std::string& sender_comp_id,
+                                 const std::string& target_comp_id) {
+  if (sender_comp_id.size() > MAX_COMP_ID_LENGTH || target_comp_id.size() > MAX_COMP_ID_LENGTH) {
+    throw std::runtime_error("FIX CompIDs are limited to 32 characters");
+  }
+  this->session_prefix = std::string("35=D") + SOH + "49=" + sender_comp_id + SOH + "56=" + target_comp_id + SOH;
+
+  this->instrument_templates.resize(catalog.num_pairs() * 2);
+  for (int pair_id = 0; pair_id < catalog.num_pairs(); pair_id++) {
+    if (catalog.symbol(pair_id).size() > MAX_COMP_ID_LENGTH) {
+      throw std::runtime_error("Symbol too long for FIX template: " + catalog.symbol(pair_id));
+    }
+    for (OrderSide side : {OrderSide::Buy, OrderSide::Sell}) {
+      /* 54: 1 = Buy, 2 = Sell; 40=2 limit; 59=3 immediate-or-cancel */
+      instrument_templates[pair_id * 2 + static_cast<int>(side)] =
+        "55=" + catalog.symbol(pair_id) + SOH + "54=" + (side == OrderSide::Buy ? "1" : "2") + SOH +
+        "40=2" + SOH + "59=3" + SOH;
+    }
+  }
+}
+
+size_t FixOrderEncoder::encode(const Order& order, int64_t sending_time_ns, char* out, size_t* end) {
+  char* body = out + FIX_HEADER_GAP;
+  char* cursor = body;
+  char timestamp[UTC_TIMESTAMP_LENGTH];
+  write_utc_timestamp(timestamp, sending_time_ns);
+
+  cursor = write_tag(cursor, session_prefix.data(), session_prefix.size());
+  cursor = write_tag(cursor, "34=", 3);
+  cursor = write_uint(cursor, next_sequence++);
+  *cursor++ = SOH;
+  cursor = write_tag(cursor, "52=", 3);
+  cursor = write_tag(cursor, timestamp, UTC_TIMESTAMP_LENGTH);
+  *cursor++ = SOH;
+  cursor = write_tag(cursor, "11=", 3);
+  cursor = write_uint(cursor, order.order_id);
+  *cursor++ = SOH;
+
+  const std::string& instrument = instrument_templates[order.pair_id * 2 + static_cast<int>(order.side)];
+  cursor = write_tag(cursor, instrument.data(), instrument.size());
+  cursor = write_tag(cursor, "38=", 3);
+  cursor = write_fixed_e8(cursor, to_e8(order.quantity));
+  *cursor++ = SOH;
+  cursor = write_tag(cursor, "44=", 3);
+  cursor = write_fixed_e8(cursor, to_e8(order.limit_price));
+  *cursor++ = SOH;
+  cursor = write_tag(cursor, "60=", 3);
+  cursor = write_tag(cursor, timestamp, UTC_TIMESTAMP_LENGTH);
+  *cursor++ = SOH;
+
+  /* BeginString and BodyLength go directly in front of the body */
+  char length_field[16];
+  char* length_end = write_tag(length_field, "8=FIX.4.4\x01" "9=", 12);
+  length_end = write_uint(length_end, static_cast<uint64_t>(cursor - body));
+  *length_end++ = SOH;
+  size_t header_length = static_cast<size_t>(length_end - length_field);
+  char* start = body - header_length;
+  std::memcpy(start, length_field, header_length);
+
+  unsigned checksum = 0;
+  for (const char* p = start; p < cursor; p++) {
+    checksum += static_cast<unsigned char>(*p);
+  }
+  checksum %= 256;
+  cursor = write_tag(cursor, "10=", 3);
+  *cursor++ = static_cast<char>('0' + checksum / 100);
+  *cursor++ = static_cast<char>('0' + checksum / 10 % 10);
+  *cursor++ = static_cast<char>('0' + checksum % 10);
+  *cursor++ = SOH;
+
+  *end = static_cast<size_t>(cursor - out);
+  return static_cast<size_t>(start - out);
+}
+
+size_t decode_binary_order(const char* data, size_t length, Order& order) {
+  if (length < sizeof(BinaryOrderMessage)) {
+    return 0;
+  }
+
+  BinaryOrderMessage message;
+  std::memcpy(&message, data, sizeof(message));
+  if (message.message_type != BinaryOrderMessage::NEW_ORDER || message.length != sizeof(message) ||
+      message.side > static_cast<uint8_t>(OrderSide::Sell) || message.pair_id > INT32_MAX) {
+    return MALFORMED_ORDER_MESSAGE;
+  }
+
+  order.order_id = message.order_id;
+  order.cycle_id = message.cycle_id;
+  order.pair_id = static_cast<int>(message.pair_id);
+  order.side = static_cast<OrderSide>(message.side);
+  order.quantity = static_cast<double>(message.quantity_e8) * 1e-8;
+  order.limit_price = static_cast<double>(message.price_e8) * 1e-8;
+  order.send_ts_ns = message.send_ts_ns;
+  return sizeof(message);
+}
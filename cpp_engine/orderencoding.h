@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "exchangesimulator.h"
+#include "paircatalog.h"
+
+/**
+ * @struct BinaryOrderMessage
+ * @brief New-order message of the engine's native binary protocol.
+ *
+ * Prices and quantities travel as fixed-point integers with 8 decimal places, so
+ * both ends agree exactly on what was sent.
+ */
+struct BinaryOrderMessage {
+  static constexpr uint16_t NEW_ORDER = 'N';
+  static constexpr uint8_t TIME_IN_FORCE_IOC = 3;
+
+  uint16_t message_type;
+  uint16_t length;
+  uint32_t pair_id;
+  uint64_t order_id;
+  uint64_t cycle_id;
+  int64_t price_e8;
+  int64_t quantity_e8;
+  int64_t send_ts_ns;
+  uint8_t side;
+  uint8_t time_in_force;
+  uint8_t reserved[6];
+};
+static_assert(sizeof(BinaryOrderMessage) == 56, "BinaryOrderMessage is a wire format");
+
+/// @brief Upper bound on the size of one encoded order in any supported format.
+constexpr size_t MAX_ENCODED_ORDER_SIZE = 320;
+
+/**
+ * @class BinaryOrderEncoder
+ * @brief Encodes orders as `BinaryOrderMessage`s from per-pair templates.
+ *
+ * Templates are built once per pair ID at construction; encoding copies the
+ * template and fills in the variable fields, with no allocation.
+ */
+class BinaryOrderEncoder {
+public:
+  explicit BinaryOrderEncoder(const PairCatalog& catalog);
+
+  /**
+   * @brief Writes one message into `out`, which must hold `MAX_ENCODED_ORDER_SIZE` bytes.
+   * `order.pair_id` must be below `num_pairs()`.
+   * @return Number of bytes written.
+   */
+  size_t encode(const Order& order, char* out) const;
+
+  /// @brief Pairs with a template: those registered when the encoder was built.
+  int num_pairs() const { return static_cast<int>(templates.size()); }
+
+private:
+  std::vector<BinaryOrderMessage> templates;
+};
+
+/**
+ * @class FixOrderEncoder
+ * @brief Encodes orders as FIX 4.4 NewOrderSingle (35=D) limit IOC messages.
+ *
+ * Every constant run of tags (session header, symbol, side, order type and time
+ * in force) is rendered once per pair and side at construction. SendingTime(52)
+ * and TransactTime(60) are UTC timestamps with milliseconds. Encoding writes
+ * the body after a reserved gap, then places BeginString and BodyLength directly
+ * in front of it and appends the checksum, so the message is produced in a single
+ * pass with hand-rolled number formatting and no allocation.
+ */
+class FixOrderEncoder {
+public:
+  FixOrderEncoder(const PairCatalog& catalog, const std::string& sender_comp_id, const std::string& target_comp_id);
+
+  /**
+   * @brief Writes one message into `out`, which must hold `MAX_ENCODED_ORDER_SIZE` bytes.
+   * `order.pair_id` must be below `num_pairs()`.
+   * @param sending_time_ns Wall-clock nanoseconds since the epoch, written as both SendingTime and
+   * TransactTime; `order.send_ts_ns` is on the engine's steady clock, so it cannot be used.
+   * @return Offset of the first byte of the message within `out`; the message ends at `*end`.
+   */
+  size_t encode(const Order& order, int64_t sending_time_ns, char* out, size_t* end);
+
+  /// @brief Pairs with a template: those registered when the encoder was built.
+  int num_pairs() const { return static_cast<int>(instrument_templates.size() / 2); }
+
+private:
+  /// @brief "35=D|49=..|56=..|" rendered once.
+  std::string session_prefix;
+  /// @brief "55=SYMBOL|54=S|" per pair ID and side (index pair_id * 2 + side).
+  std::vector<std::string> instrument_templates;
+
+  uint64_t next_sequence = 1;
+};
+
+/// @brief What `decode_binary_order` returns for bytes that are not a valid new-order message.
+constexpr size_t MALFORMED_ORDER_MESSAGE = SIZE_MAX;
+
+/**
+ * @brief Decodes one binary message from the front of `data`.
+ *
+ * Input may come straight off a socket, so malformed messages (wrong type or
+ * length, an unknown side, a pair ID beyond `int`) are reported, not thrown.
+ * @return Bytes consumed, 0 if `data` does not yet hold a complete message, or
+ * `MALFORMED_ORDER_MESSAGE`.
+ */
+size_t decode_binary_order(const char* data, size_t length, Order& order);
@@ -0,0 +1,182 @@
+/**
+ * @file ordergateway.cpp
+ * @brief Implements the outbound order gateway and its transports.
+ */
+
+#include "ordergateway.h"
+
+#include <cerrno>
+#include <cstring>
+#include <thread>
+
+#include <unistd.h>
+
+#include "clock.h"
+
+int StreamSocketSink::send(const iovec* messages, int count) {
+  std::memcpy(pending, messages, count * sizeof(iovec));
+  iovec* remaining = pending;
+  int total = count;
+
+  while (count > 0) {
+    ssize_t written = writev(fd, remaining, count);
+    if (written < 0) {
+      if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) {
+        continue;
+      }
+      return total - count;
+    }
+
+    /* A stream socket may take only part of the batch; resume where it stopped */
+    size_t consumed = static_cast<size_t>(written);
+    while (count > 0 && consumed >= remaining->iov_len) {
+      consumed -= remaining->iov_len;
+      remaining++;
+      count--;
+    }
+    if (count > 0) {
+      remaining->iov_base = static_cast<char*>(remaining->iov_base) + consumed;
+      remaining->iov_len -= consumed;
+    }
+  }
+  return total;
+}
+
+int DatagramSocketSink::send(const iovec* messages, int count) {
+  std::memset(headers, 0, count * sizeof(mmsghdr));
+  for (int i = 0; i < count; i++) {
+    headers[i].msg_hdr.msg_iov = const_cast<iovec*>(&messages[i]);
+    headers[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  int sent = 0;
+  while (sent < count) {
+    int result = sendmmsg(fd, headers + sent, count - sent, 0);
+    if (result < 0) {
+      if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) {
+        continue;
+      }
+      return sent;
+    }
+    sent += result;
+  }
+  return sent;
+}
+
+int SimulatorOrderSink::send(const iovec* messages, int count) {
+  Order order;
+  for (int i = 0; i < count; i++) {
+    size_t consumed = decode_binary_order(static_cast<const char*>(messages[i].iov_base), messages[i].iov_len, order);
+    if (consumed == 0 || consumed == MALFORMED_ORDER_MESSAGE || order.pair_id >= simulator.num_pairs()) {
+      return i;
+    }
+    simulator.submit(order);
+  }
+  return count;
+}
+
+int SimulatorSocketPort::poll() {
+  int submitted = 0;
+  while (true) {
+    ssize_t received = recv(fd, buffer + buffered, sizeof(buffer) - buffered, MSG_DONTWAIT);
+    if (received <= 0) {
+      break;
+    }
+    buffered += static_cast<size_t>(received);
+
+    size_t offset = 0;
+    Order order;
+    while (size_t consumed = decode_binary_order(buffer + offset, buffered - offset, order)) {
+      if (consumed == MALFORMED_ORDER_MESSAGE) {
+        rejected++;
+        offset = buffered;
+        break;
+      }
+      offset += consumed;
+      if (order.pair_id >= simulator.num_pairs()) {
+        rejected++;
+        continue;
+      }
+      simulator.submit(order);
+      submitted++;
+    }
+    std::memmove(buffer, buffer + offset, buffered - offset);
+    buffered -= offset;
+  }
+  return submitted;
+}
+
+OrderGateway::OrderGateway(const PairCatalog& catalog, OrderSink& sink, WireFormat format, size_t queue_capacity)
+  : sink(sink), format(format), binary_encoder(catalog), fix_encoder(catalog, "ARBENGINE", "SIMEX"),
+    handoff(queue_capacity) {
+}
+
+bool OrderGateway::submit_cycle(const CycleOrderRequest& request) {
+  /* The encoders only have templates for the pairs listed when they were built */
+  for (int i = 0; i < request.num_legs; i++) {
+    if (request.legs[i].pair_id < 0 || request.legs[i].pair_id >= binary_encoder.num_pairs()) {
+      return false;
+    }
+  }
+  return handoff.try_enqueue(request);
+}
+
+bool OrderGateway::poll() {
+  CycleOrderRequest request;
+  if (!handoff.try_dequeue(request)) {
+    return false;
+  }
+
+  int64_t send_ts = steady_now_ns();
+  /* FIX stamps SendingTime and TransactTime in UTC, which the steady clock cannot give */
+  int64_t sending_time = format == WireFormat::Fix ? wall_now_ns() : 0;
+  for (int i = 0; i < request.num_legs; i++) {
+    Order& leg = request.legs[i];
+    leg.send_ts_ns = send_ts;
+
+    if (format == WireFormat::Binary) {
+      messages[i].iov_base = buffers[i];
+      messages[i].iov_len = binary_encoder.encode(leg, buffers[i]);
+    } else {
+      size_t end = 0;
+      size_t start = fix_encoder.encode(leg, sending_time, buffers[i], &end);
+      messages[i].iov_base = buffers[i] + start;
+      messages[i].iov_len = end - start;
+    }
+  }
+
+  int sent = sink.send(messages, request.num_legs);
+  if (sent == request.num_legs) {
+    sent_count.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+  failure_count.fetch_add(1, std::memory_order_relaxed);
+
+  /* The executor waits for a report on every leg; the unsent ones are rejected here */
+  int64_t report_ts = steady_now_ns();
+  for (int i = sent; i < request.num_legs; i++) {
+    const Order& leg = request.legs[i];
+    Fill fill;
+    fill.order_id = leg.order_id;
+    fill.cycle_id = leg.cycle_id;
+    fill.pair_id = leg.pair_id;
+    fill.side = leg.side;
+    fill.status = FillStatus::Rejected;
+    fill.requested_quantity = leg.quantity;
+    fill.send_ts_ns = leg.send_ts_ns;
+    fill.arrival_ts_ns = report_ts;
+    fill.report_ts_ns = report_ts;
+    rejections.enqueue(fill);
+  }
+  return true;
+}
+
+void OrderGateway::run(const std::atomic<bool>& stop) {
+  while (!stop.load(std::memory_order_acquire)) {
+    if (!poll()) {
+      std::this_thread::yield();
+    }
+  }
+  while (poll()) {
+  }
+}
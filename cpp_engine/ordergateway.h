@@ -0,0 +1,185 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include "concurrentqueue.h"
+#include "exchangesimulator.h"
+#include "orderencoding.h"
+#include "paircatalog.h"
+
+/**
+ * @struct CycleOrderRequest
+ * @brief All legs of one cycle, handed from the decision stage to the gateway by value.
+ */
+struct CycleOrderRequest {
+  static constexpr int MAX_LEGS = 8;
+
+  uint64_t cycle_id = 0;
+  int64_t trigger_ts_ns = 0;
+  int num_legs = 0;
+  Order legs[MAX_LEGS];
+};
+
+/**
+ * @class OrderSink
+ * @brief Destination for encoded orders. Each iovec holds exactly one message.
+ */
+class OrderSink {
+public:
+  virtual ~OrderSink() = default;
+
+  /**
+   * @brief Sends every message in one operation.
+   * @return Number of leading messages sent in full: `count` unless the transport
+   * failed. Partial sends are completed before returning.
+   */
+  virtual int send(const iovec* messages, int count) = 0;
+};
+
+/**
+ * @class StreamSocketSink
+ * @brief Sends all messages of a cycle with a single `writev` on a connected stream socket.
+ */
+class StreamSocketSink : public OrderSink {
+public:
+  explicit StreamSocketSink(int fd) : fd(fd) {}
+  int send(const iovec* messages, int count) override;
+
+private:
+  int fd;
+  iovec pending[CycleOrderRequest::MAX_LEGS];
+};
+
+/**
+ * @class DatagramSocketSink
+ * @brief Sends each message as its own datagram, all in a single `sendmmsg` call.
+ */
+class DatagramSocketSink : public OrderSink {
+public:
+  explicit DatagramSocketSink(int fd) : fd(fd) {}
+  int send(const iovec* messages, int count) override;
+
+private:
+  int fd;
+  mmsghdr headers[CycleOrderRequest::MAX_LEGS];
+};
+
+/**
+ * @class SimulatorOrderSink
+ * @brief Decodes binary messages in-process and submits them to the simulator.
+ *
+ * A message that is malformed or names a pair the simulator does not know stops
+ * the batch there, as a failed transport would.
+ */
+class SimulatorOrderSink : public OrderSink {
+public:
+  explicit SimulatorOrderSink(ExchangeSimulator& simulator) : simulator(simulator) {}
+  int send(const iovec* messages, int count) override;
+
+private:
+  ExchangeSimulator& simulator;
+};
+
+/**
+ * @class SimulatorSocketPort
+ * @brief The simulator's end of a loopback socket: reads binary orders and submits them.
+ *
+ * Works with both stream and datagram sockets; partial stream reads are carried
+ * over to the next `poll`. Orders for pairs the simulator does not know are
+ * dropped. A malformed message leaves no way to find the next message boundary,
+ * so everything buffered is dropped with it.
+ */
+class SimulatorSocketPort {
+public:
+  SimulatorSocketPort(int fd, ExchangeSimulator& simulator) : fd(fd), simulator(simulator) {}
+
+  /**
+   * @brief Reads whatever is available without blocking and submits every complete order.
+   * @return Number of orders submitted.
+   */
+  int poll();
+
+  /// @brief Messages dropped as malformed or for an unknown pair.
+  uint64_t rejected_messages() const { return rejected; }
+
+private:
+  int fd;
+  ExchangeSimulator& simulator;
+  uint64_t rejected = 0;
+  char buffer[64 * 1024];
+  size_t buffered = 0;
+};
+
+enum class WireFormat { Binary, Fix };
+
+/**
+ * @class OrderGateway
+ * @brief Outbound stage: takes whole cycles from the decision stage and puts them on the wire.
+ *
+ * The decision thread hands over a `CycleOrderRequest` through a preallocated
+ * lock-free queue; the gateway thread stamps the send time, encodes every leg into
+ * its own reusable buffer and passes them to the sink in one call, which the socket
+ * sinks turn into a single syscall. Once the queue and the calling threads are warm,
+ * nothing on this path allocates.
+ */
+class OrderGateway {
+public:
+  /**
+   * @param catalog Pairs for which order templates are built.
+   * @param sink Where encoded cycles are sent.
+   * @param format Wire format of the encoded orders.
+   * @param queue_capacity Cycles that can wait between the decision stage and the gateway.
+   */
+  OrderGateway(const PairCatalog& catalog, OrderSink& sink, WireFormat format, size_t queue_capacity = 1024);
+
+  /**
+   * @brief Hands a cycle to the gateway. Lock-free; called from the decision thread.
+   * @return False if the handoff queue is full or a leg trades a pair registered
+   * after the gateway was built (the cycle is not sent).
+   */
+  bool submit_cycle(const CycleOrderRequest& request);
+
+  /**
+   * @brief Encodes and sends at most one waiting cycle.
+   * @return True if a cycle was taken from the queue.
+   */
+  bool poll();
+
+  /**
+   * @brief Polls until `stop` is set, then sends whatever is still queued.
+   */
+  void run(const std::atomic<bool>& stop);
+
+  /**
+   * @brief Retrieves a Rejected report for a leg the sink failed to send. Lock-free; called from the decision thread.
+   *
+   * Such legs never reach the venue, so the executor must see these reports
+   * through `CycleExecutor::on_fill` to finish the cycle as incomplete.
+   * @return True if a report was written to `fill`.
+   */
+  bool poll_rejection(Fill& fill) { return rejections.try_dequeue(fill); }
+
+  uint64_t cycles_sent() const { return sent_count.load(std::memory_order_relaxed); }
+  uint64_t send_failures() const { return failure_count.load(std::memory_order_relaxed); }
+
+private:
+  OrderSink& sink;
+  WireFormat format;
+  BinaryOrderEncoder binary_encoder;
+  FixOrderEncoder fix_encoder;
+
+  moodycamel::ConcurrentQueue<CycleOrderRequest> handoff;
+  moodycamel::ConcurrentQueue<Fill> rejections;
+
+  char buffers[CycleOrderRequest::MAX_LEGS][MAX_ENCODED_ORDER_SIZE];
+  iovec messages[CycleOrderRequest::MAX_LEGS];
+
+  std::atomic<uint64_t> sent_count{0};
+  std::atomic<uint64_t> failure_count{0};
+};
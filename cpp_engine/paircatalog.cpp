@@ -0,0 +1,89 @@
+/**
+ * @file paircatalog.cpp
+ * @brief Implements the PairCatalog symbol/ID registry.
+ */
+
+#include "paircatalog.h"
+#include <stdexcept>
+
+namespace {
+
+uint64_t currency_pair_key(int base_id, int quote_id) {
+  return (static_cast<uint64_t>(base_id) << 32) | static_cast<uint32_t>(quote_id);
+}
+
+}
+
+PairCatalog::PairCatalog(std::pmr::memory_resource* memory)
+  : pairs(memory), symbol_to_pair(memory), symbol_hash(memory), currencies_to_pair(memory),
+    currency_to_id(memory), id_to_currency(memory) {}
+
+/**
+ * @brief Returns the ID of a currency, assigning the next free ID if it is new.
+ */
+int PairCatalog::intern_currency(const std::string& currency) {
+  auto const iter = currency_to_id.find(currency);
+  if (iter != currency_to_id.end()) {
+    return iter->second;
+  }
+
+  int id = static_cast<int>(id_to_currency.size());
+  currency_to_id[currency] = id;
+  id_to_currency.push_back(currency);
+  return id;
+}
+
+/**
+ * @brief Registers a trading pair and its two currencies.
+ *
+ * @param symbol A trading pair in "BASE-QUOTE" form.
+ * @return The dense pair ID.
+ */
+int PairCatalog::add_pair(const std::string& symbol) {
+  auto const iter = symbol_to_pair.find(symbol);
+  if (iter != symbol_to_pair.end()) {
+    return iter->second;
+  }
+
+  size_t delimiter_pos = symbol.find('-');
+  if (delimiter_pos == std::string::npos) {
+    throw std::runtime_error("Invalid symbol format. Expected 'BASE-QUOTE', but received: '" + symbol + "'");
+  }
+
+  int base_id = intern_currency(symbol.substr(0, delimiter_pos));
+  int quote_id = intern_currency(symbol.substr(delimiter_pos+1));
+
+  int pair_id = static_cast<int>(pairs.size());
+  pairs.push_back({symbol, base_id, quote_id});
+  symbol_to_pair[symbol] = pair_id;
+  symbol_hash.insert(symbol.data(), symbol.size(), pair_id);
+  currencies_to_pair[currency_pair_key(base_id, quote_id)] = pair_id;
+  return pair_id;
+}
+
+void PairCatalog::reserve(int max_pairs, int max_currencies) {
+  pairs.reserve(max_pairs);
+  symbol_to_pair.reserve(max_pairs);
+  currencies_to_pair.reserve(max_pairs);
+  currency_to_id.reserve(max_currencies);
+  id_to_currency.reserve(max_currencies);
+}
+
+int PairCatalog::find_pair_slow(const char* symbol, size_t length) const {
+  /* Every registered symbol that fits in the perfect hash is in it, so only longer ones can be here */
+  if (length <= SymbolHash::MAX_SYMBOL_BYTES && static_cast<int>(symbol_hash.size()) == num_pairs()) {
+    return -1;
+  }
+  auto const iter = symbol_to_pair.find(std::string(symbol, length));
+  return iter == symbol_to_pair.end() ? -1 : iter->second;
+}
+
+int PairCatalog::find_pair(int base_id, int quote_id) const {
+  auto const iter = currencies_to_pair.find(currency_pair_key(base_id, quote_id));
+  return iter == currencies_to_pair.end() ? -1 : iter->second;
+}
+
+int PairCatalog::find_currency(const std::string& currency) const {
+  auto const iter = currency_to_id.find(currency);
+  return iter == currency_to_id.end() ? -1 : iter->second;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <memory_resource>
+#include <cstdint>
+
+#include "symbolhash.h"
+
+/**
+ * @class PairCatalog
+ * @brief Assigns dense integer IDs to trading pairs and the currencies they trade.
+ *
+ * Every component that sits downstream of the feed (simulator, order path, risk)
+ * refers to markets by pair ID and to assets by currency ID, so that the hot path
+ * never hashes or copies symbol strings. Names are only resolved for logging.
+ *
+ * Symbols of up to 16 bytes also go into a perfect hash, so resolving the
+ * product ID of a feed message is a word-sized hash and compare rather than a
+ * string hash and bucket walk.
+ */
+class PairCatalog {
+public:
+  /**
+   * @param memory Where the tables are allocated; names short enough for the small-string buffer live there too.
+   */
+  explicit PairCatalog(std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+
+  /**
+   * @brief Registers a trading pair, creating IDs for any new currencies.
+   * @param symbol A trading pair in "BASE-QUOTE" form (e.g., "BTC-USD").
+   * @return The pair ID (the existing one if the symbol was already registered).
+   */
+  int add_pair(const std::string& symbol);
+
+  /**
+   * @brief Preallocates room so that registering up to these totals never reallocates.
+   */
+  void reserve(int max_pairs, int max_currencies);
+
+  /**
+   * @brief Looks up a pair by symbol.
+   * @return The pair ID, or -1 if the symbol is not registered.
+   */
+  int find_pair(const std::string& symbol) const { return find_pair(symbol.data(), symbol.size()); }
+
+  /**
+   * @brief Looks up a pair by symbol bytes, for parsers that hold the symbol in their input buffer.
+   * @return The pair ID, or -1 if the symbol is not registered.
+   */
+  int find_pair(const char* symbol, size_t length) const {
+    int pair_id = symbol_hash.find(symbol, length);
+    return pair_id >= 0 ? pair_id : find_pair_slow(symbol, length);
+  }
+
+  /**
+   * @brief Looks up the pair that trades `base_id` against `quote_id`.
+   * @return The pair ID, or -1 if no such pair is registered in that orientation.
+   */
+  int find_pair(int base_id, int quote_id) const;
+
+  /**
+   * @brief Looks up a currency by name.
+   * @return The currency ID, or -1 if the currency is not registered.
+   */
+  int find_currency(const std::string& currency) const;
+
+  int num_pairs() const { return static_cast<int>(pairs.size()); }
+  int num_currencies() const { return static_cast<int>(id_to_currency.size()); }
+
+  const std::string& symbol(int pair_id) const { return pairs[pair_id].symbol; }
+  int base_id(int pair_id) const { return pairs[pair_id].base_id; }
+  int quote_id(int pair_id) const { return pairs[pair_id].quote_id; }
+  const std::string& currency_name(int currency_id) const { return id_to_currency[currency_id]; }
+
+private:
+  /**
+   * @struct PairInfo
+   * @brief Static description of one registered trading pair.
+   */
+  struct PairInfo {
+    std::string symbol;
+    int base_id;
+    int quote_id;
+  };
+
+  /// @brief Registered pairs, indexed by pair ID.
+  std::pmr::vector<PairInfo> pairs;
+
+  /// @brief Maps "BASE-QUOTE" symbols to pair IDs.
+  std::pmr::unordered_map<std::string, int> symbol_to_pair;
+
+  /// @brief Perfect hash over the symbols of `symbol_to_pair` that fit in 16 bytes.
+  SymbolHash symbol_hash;
+
+  /// @brief Maps (base_id, quote_id) keys to pair IDs.
+  std::pmr::unordered_map<uint64_t, int> currencies_to_pair;
+
+  /// @brief Maps currency names to currency IDs.
+  std::pmr::unordered_map<std::string, int> currency_to_id;
+
+  /// @brief Maps currency IDs back to names.
+  std::pmr::vector<std::string> id_to_currency;
+
+  int intern_currency(const std::string& currency);
+
+  /// @brief `symbol_to_pair` lookup, for symbols the perfect hash does not hold.
+  int find_pair_slow(const char* symbol, size_t length) const;
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Number of worker threads to use when the caller asks for "all cores" (0).
+ */
+inline unsigned resolve_thread_count(unsigned requested) {
+  if (requested != 0) {
+    return requested;
+  }
+  unsigned hardware = std::thread::hardware_concurrency();
+  return hardware == 0 ? 1 : hardware;
+}
+
+/**
+ * @brief Runs `task(index)` for every index in [0, count) on a pool of worker threads.
+ *
+ * Indices are handed out one at a time from a shared counter, so long and short
+ * tasks balance themselves across workers. The first exception thrown by a task
+ * is rethrown on the calling thread after all workers have stopped.
+ *
+ * @param count Number of tasks.
+ * @param num_threads Worker count; 0 means one per hardware thread.
+ * @param task Callable taking a `size_t` index. Must be safe to call concurrently.
+ */
+template <typename Task>
+void parallel_for(size_t count, unsigned num_threads, Task&& task) {
+  unsigned workers = static_cast<unsigned>(std::min<size_t>(resolve_thread_count(num_threads), count));
+  std::atomic<size_t> next_index{0};
+  std::exception_ptr first_error;
+  std::mutex error_mutex;
+
+  auto worker = [&]() {
+    for (size_t index = next_index++; index < count; index = next_index++) {
+      try {
+        task(index);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (!first_error) {
+          first_error = std::current_exception();
+        }
+        next_index = count;
+      }
+    }
+  };
+
+  std::vector<std::thread> pool;
+  for (unsigned i = 1; i < workers; i++) {
+    pool.emplace_back(worker);
+  }
+  worker();
+  for (auto& thread : pool) {
+    thread.join();
+  }
+
+  if (first_error) {
+    std::rethrow_exception(first_error);
+  }
+}
@@ -0,0 +1,195 @@
+/**
+ * @file pythonbindings.cpp
+ * @brief Python extension module exposing the pair catalog and the production detector.
+ *
+ * @details
+ * Built only with -DARBITRAGE_BUILD_PYTHON=ON (requires pybind11). Batch inputs
+ * are taken as C-contiguous NumPy arrays of exactly the documented dtypes and
+ * are read in place; arrays of any other dtype or layout are rejected rather
+ * than silently copied. The GIL is released while the engine runs, so several
+ * graphs can be driven from Python threads at once. A single graph is not
+ * thread-safe and must only be used by one thread at a time.
+ *
+ * Example:
+ * @code
+ *   import numpy as np, arbitrage
+ *   graph = arbitrage.ArbitrageGraph(["BTC-USD", "ETH-USD", "ETH-BTC"])
+ *   ids = np.array([0, 1, 2], dtype=np.int32)
+ *   graph.update_prices(ids, np.array([60000.0, 3000.0, 0.0505]), np.array([60001.0, 3000.5, 0.0506]))
+ *   opportunity = graph.find_arbitrage_cycle()   # dict of arrays, or None
+ * @endcode
+ */
+
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "arbitragegraph.h"
+
+namespace py = pybind11;
+
+namespace {
+
+using PairIdArray = py::array_t<int32_t, py::array::c_style>;
+using PriceArray = py::array_t<double, py::array::c_style>;
+using TimestampArray = py::array_t<int64_t, py::array::c_style>;
+
+/**
+ * @brief Checks that the quote columns line up and only reference pairs the graph can hold.
+ */
+void check_quote_columns(const ArbitrageGraph& graph, const PairIdArray& pair_ids, const PriceArray& bids,
+                         const PriceArray& asks) {
+  if (pair_ids.ndim() != 1 || bids.ndim() != 1 || asks.ndim() != 1) {
+    throw py::value_error("pair_ids, bids and asks must be one-dimensional");
+  }
+  if (bids.shape(0) != pair_ids.shape(0) || asks.shape(0) != pair_ids.shape(0)) {
+    throw py::value_error("pair_ids, bids and asks must have the same length");
+  }
+  const int32_t* ids = pair_ids.data();
+  for (py::ssize_t i = 0; i < pair_ids.shape(0); i++) {
+    if (ids[i] < 0 || ids[i] >= graph.pair_capacity()) {
+      throw py::value_error("pair_ids[" + std::to_string(i) + "] is not a valid pair ID");
+    }
+  }
+}
+
+/**
+ * @brief Copies one Opportunity into a dict of small NumPy arrays.
+ */
+py::dict opportunity_to_dict(const Opportunity& opportunity) {
+  py::array_t<int32_t> currency_ids(opportunity.num_legs + 1);
+  py::array_t<uint32_t> edge_slots(opportunity.num_legs);
+  py::array_t<double> rates(opportunity.num_legs);
+  std::copy(opportunity.currency_ids, opportunity.currency_ids + opportunity.num_legs + 1,
+            currency_ids.mutable_data());
+  std::copy(opportunity.edge_slots, opportunity.edge_slots + opportunity.num_legs, edge_slots.mutable_data());
+  std::copy(opportunity.rates, opportunity.rates + opportunity.num_legs, rates.mutable_data());
+
+  py::dict result;
+  result["currency_ids"] = currency_ids;
+  result["edge_slots"] = edge_slots;
+  result["rates"] = rates;
+  result["log_profit"] = opportunity.log_profit;
+  result["exchange_ts_ns"] = opportunity.exchange_ts_ns;
+  result["receive_ts_ns"] = opportunity.receive_ts_ns;
+  return result;
+}
+
+/**
+ * @brief Replays a column of quotes one at a time, detecting after each, and returns every hit.
+ *
+ * The result arrays are indexed by opportunity: `tick_index` is the row of the
+ * quote that triggered it and `currency_ids` is padded with -1 past `num_legs + 1`.
+ */
+py::dict scan(ArbitrageGraph& graph, const PairIdArray& pair_ids, const PriceArray& bids, const PriceArray& asks,
+              const TimestampArray& receive_ts_ns) {
+  check_quote_columns(graph, pair_ids, bids, asks);
+  if (receive_ts_ns.ndim() != 1 || receive_ts_ns.shape(0) != pair_ids.shape(0)) {
+    throw py::value_error("receive_ts_ns must have the same length as pair_ids");
+  }
+
+  size_t count = static_cast<size_t>(pair_ids.shape(0));
+  const int32_t* ids = pair_ids.data();
+  const double* bid = bids.data();
+  const double* ask = asks.data();
+  const int64_t* ts = receive_ts_ns.data();
+
+  std::vector<int64_t> tick_index;
+  std::vector<Opportunity> found;
+  {
+    py::gil_scoped_release release;
+    Opportunity opportunity;
+    for (size_t i = 0; i < count; i++) {
+      graph.update_quote(ids[i], bid[i], ask[i], 0, ts[i]);
+      if (graph.find_arbitrage_cycle(opportunity)) {
+        tick_index.push_back(static_cast<int64_t>(i));
+        found.push_back(opportunity);
+      }
+    }
+  }
+
+  const py::ssize_t rows = static_cast<py::ssize_t>(found.size());
+  const py::ssize_t width = Opportunity::MAX_LEGS + 1;
+  py::array_t<int64_t> index_array(rows);
+  py::array_t<int32_t> legs_array(rows);
+  py::array_t<int32_t> currency_array({rows, width});
+  py::array_t<double> profit_array(rows);
+
+  auto currencies = currency_array.mutable_unchecked<2>();
+  for (py::ssize_t r = 0; r < rows; r++) {
+    const Opportunity& opportunity = found[r];
+    index_array.mutable_data()[r] = tick_index[r];
+    legs_array.mutable_data()[r] = opportunity.num_legs;
+    profit_array.mutable_data()[r] = opportunity.log_profit;
+    for (py::ssize_t c = 0; c < width; c++) {
+      currencies(r, c) = c <= opportunity.num_legs ? opportunity.currency_ids[c] : -1;
+    }
+  }
+
+  py::dict result;
+  result["tick_index"] = index_array;
+  result["num_legs"] = legs_array;
+  result["currency_ids"] = currency_array;
+  result["log_profit"] = profit_array;
+  return result;
+}
+
+}
+
+PYBIND11_MODULE(arbitrage, module) {
+  module.doc() = "Bindings for the arbitrage engine's pair catalog and cycle detector";
+
+  py::class_<PairCatalog>(module, "PairCatalog")
+      .def("find_pair", py::overload_cast<const std::string&>(&PairCatalog::find_pair, py::const_),
+           py::arg("symbol"), "Pair ID of a 'BASE-QUOTE' symbol, or -1")
+      .def("find_currency", &PairCatalog::find_currency, py::arg("currency"), "Currency ID, or -1")
+      .def_property_readonly("num_pairs", &PairCatalog::num_pairs)
+      .def_property_readonly("num_currencies", &PairCatalog::num_currencies)
+      .def("symbol", &PairCatalog::symbol, py::arg("pair_id"))
+      .def("base_id", &PairCatalog::base_id, py::arg("pair_id"))
+      .def("quote_id", &PairCatalog::quote_id, py::arg("pair_id"))
+      .def("currency_name", &PairCatalog::currency_name, py::arg("currency_id"));
+
+  py::class_<ArbitrageGraph>(module, "ArbitrageGraph")
+      .def(py::init<const std::vector<std::string>&, int, int>(), py::arg("symbols"), py::arg("max_pairs") = 0,
+           py::arg("max_currencies") = 0)
+      .def_property_readonly("catalog", &ArbitrageGraph::catalog, py::return_value_policy::reference_internal)
+      .def("add_pair", &ArbitrageGraph::add_pair, py::arg("symbol"))
+      .def("remove_pair", &ArbitrageGraph::remove_pair, py::arg("pair_id"))
+      .def("set_pair_ttl", &ArbitrageGraph::set_pair_ttl, py::arg("pair_id"), py::arg("ttl_ns"))
+      .def(
+          "update_prices",
+          [](ArbitrageGraph& graph, const PairIdArray& pair_ids, const PriceArray& bids, const PriceArray& asks,
+             int64_t receive_ts_ns) {
+            check_quote_columns(graph, pair_ids, bids, asks);
+            py::gil_scoped_release release;
+            graph.update_quotes(pair_ids.data(), bids.data(), asks.data(), static_cast<size_t>(pair_ids.shape(0)),
+                                receive_ts_ns);
+          },
+          py::arg("pair_ids").noconvert(), py::arg("bids").noconvert(), py::arg("asks").noconvert(),
+          py::arg("receive_ts_ns") = 0,
+          "Apply top-of-book updates from int32 pair IDs and float64 bids/asks, read in place")
+      .def(
+          "find_arbitrage_cycle",
+          [](ArbitrageGraph& graph) -> py::object {
+            Opportunity opportunity;
+            bool found;
+            {
+              py::gil_scoped_release release;
+              found = graph.find_arbitrage_cycle(opportunity);
+            }
+            if (!found) {
+              return py::none();
+            }
+            return opportunity_to_dict(opportunity);
+          },
+          "Detect a cycle; returns a dict of arrays, or None")
+      .def("scan", &scan, py::arg("pair_ids").noconvert(), py::arg("bids").noconvert(),
+           py::arg("asks").noconvert(), py::arg("receive_ts_ns").noconvert(),
+           "Update and detect quote by quote; returns every opportunity as columns")
+      .def_property_readonly("pruned_cycle_count", &ArbitrageGraph::pruned_cycle_count);
+}
@@ -0,0 +1,158 @@
+/**
+ * @file riskmanager.cpp
+ * @brief Implements the lock-free pre-trade risk checks.
+ */
+
+#include "riskmanager.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+/**
+ * @brief Rounds to 1e-8 units; written out rather than `llround` to stay inline.
+ */
+int64_t to_e8(double value) {
+  double scaled = value * 1e8;
+  return static_cast<int64_t>(scaled >= 0.0 ? scaled + 0.5 : scaled - 0.5);
+}
+
+/**
+ * @brief True if moving from `current` to `projected` breaks the band in the direction of travel.
+ *
+ * A position that is already outside its band may always move back towards it.
+ */
+bool breaks_band(int64_t current, int64_t projected, int64_t min_e8, int64_t max_e8) {
+  return (projected > max_e8 && projected > current) || (projected < min_e8 && projected < current);
+}
+
+}
+
+RiskManager::RiskManager(int num_currencies, const RiskConfig& config)
+  : currency_count(num_currencies), config(config), assets(new AssetState[num_currencies]) {
+  if (config.orders_per_second > 0.0) {
+    this->emission_interval_ns = static_cast<int64_t>(1e9 / config.orders_per_second);
+    this->burst_tolerance_ns = static_cast<int64_t>(std::max(1.0, config.order_burst) * emission_interval_ns);
+  }
+}
+
+void RiskManager::set_position_limits(int currency_id, double min_position, double max_position) {
+  assets[currency_id].min_position_e8 = to_e8(min_position);
+  assets[currency_id].max_position_e8 = to_e8(max_position);
+}
+
+void RiskManager::set_notional_limit(int currency_id, double max_notional) {
+  assets[currency_id].max_notional = max_notional;
+}
+
+void RiskManager::set_mark(int currency_id, double price) {
+  assets[currency_id].mark.store(price, std::memory_order_relaxed);
+}
+
+double RiskManager::position(int currency_id) const {
+  return static_cast<double>(assets[currency_id].position_e8.load(std::memory_order_relaxed)) * 1e-8;
+}
+
+void RiskManager::adjust_position(int currency_id, double delta) {
+  assets[currency_id].position_e8.fetch_add(to_e8(delta), std::memory_order_acq_rel);
+}
+
+int RiskManager::net_deltas(const CycleRiskRequest& request, int* ids, int64_t* deltas_e8) {
+  int count = 0;
+  auto add = [&](int id, int64_t delta) {
+    for (int i = 0; i < count; i++) {
+      if (ids[i] == id) {
+        deltas_e8[i] += delta;
+        return;
+      }
+    }
+    ids[count] = id;
+    deltas_e8[count] = delta;
+    count++;
+  };
+
+  for (int i = 0; i < request.num_legs; i++) {
+    add(request.legs[i].currency_out, -to_e8(request.legs[i].amount_out));
+    add(request.legs[i].currency_in, to_e8(request.legs[i].amount_in));
+  }
+  return count;
+}
+
+/**
+ * @brief Takes budget for `orders` orders from the GCRA bucket, or nothing if there is not enough.
+ */
+bool RiskManager::consume_rate(int orders, int64_t now_ns) {
+  int64_t cost = orders * emission_interval_ns;
+  int64_t tat = theoretical_arrival_ns.load(std::memory_order_relaxed);
+  while (true) {
+    int64_t new_tat = std::max(tat, now_ns) + cost;
+    if (new_tat - now_ns > burst_tolerance_ns) {
+      return false;
+    }
+    if (theoretical_arrival_ns.compare_exchange_weak(tat, new_tat, std::memory_order_acq_rel,
+                                                     std::memory_order_relaxed)) {
+      return true;
+    }
+  }
+}
+
+void RiskManager::refund_rate(int orders) {
+  theoretical_arrival_ns.fetch_sub(orders * emission_interval_ns, std::memory_order_acq_rel);
+}
+
+RiskVerdict RiskManager::check_cycle(const CycleRiskRequest& request) {
+  if (config.max_cycle_notional > 0.0 && request.notional > config.max_cycle_notional) {
+    return RiskVerdict::CycleNotionalCap;
+  }
+
+  int ids[2 * CycleRiskRequest::MAX_LEGS];
+  int64_t deltas[2 * CycleRiskRequest::MAX_LEGS];
+  int count = net_deltas(request, ids, deltas);
+
+  /* Cheap pre-check against a snapshot; the commit below re-validates */
+  for (int i = 0; i < count; i++) {
+    const AssetState& asset = assets[ids[i]];
+    int64_t current = asset.position_e8.load(std::memory_order_relaxed);
+    int64_t projected = current + deltas[i];
+
+    if (breaks_band(current, projected, asset.min_position_e8, asset.max_position_e8)) {
+      return RiskVerdict::PositionLimit;
+    }
+    if (asset.max_notional > 0.0 && std::llabs(projected) > std::llabs(current)) {
+      double value = std::fabs(static_cast<double>(projected) * 1e-8 * asset.mark.load(std::memory_order_relaxed));
+      if (value > asset.max_notional) {
+        return RiskVerdict::AssetNotionalLimit;
+      }
+    }
+  }
+
+  if (emission_interval_ns > 0 && !consume_rate(request.num_legs, request.now_ns)) {
+    return RiskVerdict::RateLimited;
+  }
+
+  for (int i = 0; i < count; i++) {
+    AssetState& asset = assets[ids[i]];
+    int64_t previous = asset.position_e8.fetch_add(deltas[i], std::memory_order_acq_rel);
+    if (breaks_band(previous, previous + deltas[i], asset.min_position_e8, asset.max_position_e8)) {
+      for (int j = 0; j <= i; j++) {
+        assets[ids[j]].position_e8.fetch_sub(deltas[j], std::memory_order_acq_rel);
+      }
+      if (emission_interval_ns > 0) {
+        refund_rate(request.num_legs);
+      }
+      return RiskVerdict::PositionLimit;
+    }
+  }
+
+  return RiskVerdict::Accepted;
+}
+
+void RiskManager::release_cycle(const CycleRiskRequest& request) {
+  int ids[2 * CycleRiskRequest::MAX_LEGS];
+  int64_t deltas[2 * CycleRiskRequest::MAX_LEGS];
+  int count = net_deltas(request, ids, deltas);
+  for (int i = 0; i < count; i++) {
+    assets[ids[i]].position_e8.fetch_sub(deltas[i], std::memory_order_acq_rel);
+  }
+}
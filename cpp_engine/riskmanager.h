@@ -0,0 +1,142 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+/**
+ * @struct RiskLeg
+ * @brief Currency movement of one order: `amount_out` of one currency for `amount_in` of another.
+ */
+struct RiskLeg {
+  int currency_out;
+  double amount_out;
+  int currency_in;
+  double amount_in;
+};
+
+/**
+ * @struct CycleRiskRequest
+ * @brief Everything the pre-trade check needs to know about one cycle.
+ */
+struct CycleRiskRequest {
+  static constexpr int MAX_LEGS = 8;
+
+  int num_legs = 0;
+  RiskLeg legs[MAX_LEGS];
+  /// @brief Size of the cycle in the valuation currency.
+  double notional = 0.0;
+  /// @brief Time of the check, used by the order-rate limit.
+  int64_t now_ns = 0;
+};
+
+enum class RiskVerdict {
+  Accepted,
+  CycleNotionalCap,  ///< The cycle is larger than the per-cycle cap.
+  PositionLimit,     ///< A currency would leave its [min, max] position band.
+  AssetNotionalLimit,///< A currency's position would be worth more than its notional limit.
+  RateLimited        ///< Not enough order-rate budget for every leg.
+};
+
+/**
+ * @struct RiskConfig
+ * @brief Limits that apply across all currencies.
+ */
+struct RiskConfig {
+  /// @brief Largest cycle notional accepted, in the valuation currency (0 disables the cap).
+  double max_cycle_notional = 0.0;
+  /// @brief Sustained order rate (orders per second; 0 disables the limit).
+  double orders_per_second = 0.0;
+  /// @brief Orders that may be sent back-to-back above the sustained rate.
+  double order_burst = 1.0;
+};
+
+/**
+ * @class RiskManager
+ * @brief Lock-free pre-trade risk checks indexed by dense currency ID.
+ *
+ * Per-asset state lives in one cache line per currency: an atomic position held
+ * as fixed-point (1e-8 units) so it can be updated with a single `fetch_add`, the
+ * position band, a notional limit and an atomic mark price. A cycle is checked in
+ * one pass: the per-cycle cap, then each touched currency's projected position,
+ * then the rate limit, and finally the cycle's net deltas are committed with one
+ * `fetch_add` per currency. If a concurrent commit pushes a currency out of its
+ * band, everything this check committed is rolled back and the cycle is refused.
+ * Under contention the check can be conservative, but no accepted cycle ever takes
+ * a currency past its band. Notional limits are evaluated against the pre-check
+ * snapshot and marks.
+ *
+ * The order-rate limit is a token bucket implemented as GCRA: one atomic holds
+ * the theoretical arrival time of the next order, and a check for N orders is a
+ * single compare-and-swap that advances it by N emission intervals.
+ */
+class RiskManager {
+public:
+  RiskManager(int num_currencies, const RiskConfig& config);
+
+  /**
+   * @brief Sets the allowed position band of a currency, in currency units.
+   * Defaults are unbounded.
+   */
+  void set_position_limits(int currency_id, double min_position, double max_position);
+
+  /**
+   * @brief Sets the largest absolute position value, in the valuation currency (0 disables).
+   */
+  void set_notional_limit(int currency_id, double max_notional);
+
+  /**
+   * @brief Updates the value of one unit of a currency in the valuation currency.
+   */
+  void set_mark(int currency_id, double price);
+
+  /**
+   * @brief Checks a cycle and, if it passes, reserves its net position changes.
+   */
+  RiskVerdict check_cycle(const CycleRiskRequest& request);
+
+  /**
+   * @brief Applies a position change outside of `check_cycle` (fills differing from
+   * the reservation, transfers, releasing a refused or cancelled cycle).
+   */
+  void adjust_position(int currency_id, double delta);
+
+  /**
+   * @brief Reverses the reservation made by a successful `check_cycle`.
+   */
+  void release_cycle(const CycleRiskRequest& request);
+
+  double position(int currency_id) const;
+  int num_currencies() const { return currency_count; }
+
+private:
+  /**
+   * @struct AssetState
+   * @brief All risk state of one currency, on its own cache line.
+   */
+  struct alignas(64) AssetState {
+    std::atomic<int64_t> position_e8{0};
+    std::atomic<double> mark{0.0};
+    int64_t min_position_e8 = INT64_MIN;
+    int64_t max_position_e8 = INT64_MAX;
+    double max_notional = 0.0;
+  };
+
+  int currency_count;
+  RiskConfig config;
+  std::unique_ptr<AssetState[]> assets;
+
+  /// @brief GCRA state: time at which the bucket is full again.
+  alignas(64) std::atomic<int64_t> theoretical_arrival_ns{0};
+  int64_t emission_interval_ns = 0;
+  int64_t burst_tolerance_ns = 0;
+
+  bool consume_rate(int orders, int64_t now_ns);
+  void refund_rate(int orders);
+
+  /**
+   * @brief Nets a cycle's legs into one delta per currency.
+   * @return Number of distinct currencies written to `ids` / `deltas_e8`.
+   */
+  static int net_deltas(const CycleRiskRequest& request, int* ids, int64_t* deltas_e8);
+};
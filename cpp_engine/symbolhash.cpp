@@ -0,0 +1,125 @@
+/**
+ * @file symbolhash.cpp
+ * @brief Builds and extends the hash-and-displace symbol table.
+ *
+ * @details
+ * With half as many buckets as slots, a bucket holds one or two keys on average
+ * and the table is at most half full, so a random seed places a bucket of k keys
+ * with probability of roughly 2^-k; the few large buckets are seated first, while
+ * the table is emptiest. Building is meant for startup and for the rare listing
+ * of a new pair, never for the tick path.
+ */
+
+#include "symbolhash.h"
+
+#include <algorithm>
+
+bool SymbolHash::insert(const char* symbol, size_t length, int id) {
+  if (length == 0 || length > MAX_SYMBOL_BYTES) {
+    return false;
+  }
+  Key key;
+  load_words(symbol, length, key.words);
+  key.length = static_cast<uint32_t>(length);
+  key.id = id;
+  keys.push_back(key);
+
+  if (2 * keys.size() > slots.size()) {
+    size_t num_slots = 16;
+    while (num_slots < 4 * keys.size()) {
+      num_slots <<= 1;
+    }
+    rebuild(num_slots);
+    return find(symbol, length) == id;
+  }
+
+  /* Usually the bucket's current seed already has a free slot for the new key */
+  uint64_t hash = base_hash(key.words[0], key.words[1]);
+  size_t bucket = static_cast<size_t>(hash >> bucket_shift);
+  Key& slot = slots[slot_of(hash, seeds[bucket])];
+  if (slot.length == 0) {
+    slot = key;
+    placed++;
+    return true;
+  }
+
+  /* Otherwise lift the bucket's placed keys and look for a seed that fits them all */
+  std::vector<const Key*> members;
+  std::vector<const Key*> lifted;
+  uint32_t old_seed = seeds[bucket];
+  for (const Key& other : keys) {
+    uint64_t other_hash = base_hash(other.words[0], other.words[1]);
+    if (static_cast<size_t>(other_hash >> bucket_shift) != bucket) {
+      continue;
+    }
+    members.push_back(&other);
+    Key& other_slot = slots[slot_of(other_hash, old_seed)];
+    if (&other != &keys.back() && other_slot.length == other.length && other_slot.words[0] == other.words[0] &&
+        other_slot.words[1] == other.words[1]) {
+      other_slot = Key();
+      placed--;
+      lifted.push_back(&other);
+    }
+  }
+  if (seat_bucket(bucket, members)) {
+    return true;
+  }
+  for (const Key* other : lifted) {
+    slots[slot_of(base_hash(other->words[0], other->words[1]), old_seed)] = *other;
+    placed++;
+  }
+  return false;
+}
+
+bool SymbolHash::seat_bucket(size_t bucket, const std::vector<const Key*>& members) {
+  size_t targets[64];
+  if (members.size() > 64) {
+    return false;
+  }
+  for (uint32_t seed = 0; seed < MAX_SEED_ATTEMPTS; seed++) {
+    bool fits = true;
+    for (size_t i = 0; i < members.size() && fits; i++) {
+      targets[i] = slot_of(base_hash(members[i]->words[0], members[i]->words[1]), seed);
+      fits = slots[targets[i]].length == 0 && std::find(targets, targets + i, targets[i]) == targets + i;
+    }
+    if (!fits) {
+      continue;
+    }
+    for (size_t i = 0; i < members.size(); i++) {
+      slots[targets[i]] = *members[i];
+    }
+    seeds[bucket] = seed;
+    placed += members.size();
+    return true;
+  }
+  return false;
+}
+
+void SymbolHash::rebuild(size_t num_slots) {
+  int slot_bits = __builtin_ctzll(num_slots);
+  slot_shift = 64 - slot_bits;
+  bucket_shift = slot_shift + 1;
+  slots.assign(num_slots, Key());
+  seeds.assign(num_slots / 2, 0);
+  placed = 0;
+
+  std::vector<std::vector<const Key*>> buckets(seeds.size());
+  for (const Key& key : keys) {
+    buckets[static_cast<size_t>(base_hash(key.words[0], key.words[1]) >> bucket_shift)].push_back(&key);
+  }
+  std::vector<size_t> order;
+  for (size_t bucket = 0; bucket < buckets.size(); bucket++) {
+    if (!buckets[bucket].empty()) {
+      order.push_back(bucket);
+    }
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [&](size_t a, size_t b) { return buckets[a].size() > buckets[b].size(); });
+  for (size_t bucket : order) {
+    seat_bucket(bucket, buckets[bucket]);
+  }
+}
+
+size_t SymbolHash::memory_bytes() const {
+  return sizeof(Key) * (keys.capacity() + slots.capacity()) + sizeof(uint32_t) * seeds.capacity();
+}
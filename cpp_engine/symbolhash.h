@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+#include <vector>
+
+/**
+ * @class SymbolHash
+ * @brief A collision-free hash of short symbols ("ETH-BTC") to integer IDs.
+ *
+ * Symbols of up to 16 bytes are stored as two zero-padded 64-bit words, so a
+ * lookup is one multiply-and-shift hash, one table probe and a two-word compare,
+ * with no string hashing, no chains and no probing. The table is a
+ * hash-and-displace perfect hash: keys are grouped into buckets by a first hash,
+ * and each bucket carries a seed chosen so that its keys land on free slots.
+ *
+ * Inserting re-seeds only the new key's bucket, and the table doubles (and every
+ * bucket is re-seeded) when it becomes half full. A key that cannot be placed,
+ * or is longer than `MAX_SYMBOL_BYTES`, is rejected and must be looked up
+ * elsewhere; `find` then returns -1 for it.
+ */
+class SymbolHash {
+public:
+  static constexpr size_t MAX_SYMBOL_BYTES = 16;
+
+  /**
+   * @param memory Where the table is allocated.
+   */
+  explicit SymbolHash(std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+    : keys(memory), slots(memory), seeds(memory) {}
+
+  /**
+   * @brief Adds a symbol that is not already present.
+   * @return False if the symbol is too long, empty, or could not be given a slot.
+   */
+  bool insert(const char* symbol, size_t length, int id);
+
+  /**
+   * @brief The ID of a symbol, or -1 if it was never inserted (or was rejected).
+   */
+  int find(const char* symbol, size_t length) const {
+    if (length == 0 || length > MAX_SYMBOL_BYTES || slots.empty()) {
+      return -1;
+    }
+    uint64_t words[2];
+    load_words(symbol, length, words);
+    uint64_t hash = base_hash(words[0], words[1]);
+    const Key& key = slots[slot_of(hash, seeds[hash >> bucket_shift])];
+    bool match = key.words[0] == words[0] && key.words[1] == words[1] && key.length == length;
+    return match ? key.id : -1;
+  }
+
+  /// @brief Symbols that have a slot.
+  size_t size() const { return placed; }
+
+  /// @brief Bytes held by the table and key list.
+  size_t memory_bytes() const;
+
+private:
+  /**
+   * @struct Key
+   * @brief One symbol as two zero-padded words; a slot is empty while `length` is 0.
+   */
+  struct Key {
+    uint64_t words[2] = {0, 0};
+    uint32_t length = 0;
+    int32_t id = -1;
+  };
+
+  /// @brief Seeds tried per bucket before its keys are rejected.
+  static constexpr uint32_t MAX_SEED_ATTEMPTS = 1 << 16;
+
+  /// @brief Every accepted key, placed or not, in insertion order.
+  std::pmr::vector<Key> keys;
+
+  /// @brief The table, a power of two of at least twice the key count.
+  std::pmr::vector<Key> slots;
+
+  /// @brief Seed of each bucket; there are half as many buckets as slots.
+  std::pmr::vector<uint32_t> seeds;
+
+  int slot_shift = 64;
+  int bucket_shift = 64;
+  size_t placed = 0;
+
+  /**
+   * @brief Reads 1 to 16 bytes as two zero-padded little-endian words, without reading past them.
+   *
+   * Longer symbols take two 8-byte loads, the second overlapping the first and
+   * shifted down; shorter ones take two overlapping 4-byte loads, or three byte
+   * loads under 4 bytes.
+   */
+  static void load_words(const char* symbol, size_t length, uint64_t words[2]) {
+    if (length >= 8) {
+      uint64_t tail;
+      std::memcpy(&words[0], symbol, 8);
+      std::memcpy(&tail, symbol + length - 8, 8);
+      words[1] = length == 8 ? 0 : tail >> (8 * (16 - length));
+    } else if (length >= 4) {
+      uint32_t head;
+      uint32_t tail;
+      std::memcpy(&head, symbol, 4);
+      std::memcpy(&tail, symbol + length - 4, 4);
+      words[0] = head | (static_cast<uint64_t>(tail) << (8 * (length - 4)));
+      words[1] = 0;
+    } else {
+      const unsigned char* bytes = reinterpret_cast<const unsigned char*>(symbol);
+      words[0] = bytes[0] | (static_cast<uint64_t>(bytes[length / 2]) << (8 * (length / 2))) |
+                 (static_cast<uint64_t>(bytes[length - 1]) << (8 * (length - 1)));
+      words[1] = 0;
+    }
+  }
+
+  static uint64_t base_hash(uint64_t first, uint64_t second) {
+    uint64_t hash = (first ^ (second * 0xc2b2ae3d27d4eb4fULL)) * 0x9e3779b97f4a7c15ULL;
+    return hash ^ (hash >> 29);
+  }
+
+  size_t slot_of(uint64_t hash, uint32_t seed) const {
+    return static_cast<size_t>(((hash ^ seed) * 0xbf58476d1ce4e5b9ULL) >> slot_shift);
+  }
+
+  /// @brief Finds a seed that puts every key of `bucket` on a free slot, and places them.
+  bool seat_bucket(size_t bucket, const std::vector<const Key*>& members);
+
+  /// @brief Resizes the table for `keys` and re-seats every bucket, largest first.
+  void rebuild(size_t num_slots);
+};
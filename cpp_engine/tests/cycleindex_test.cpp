@@ -0,0 +1,178 @@
+/**
+ * @file cycleindex_test.cpp
+ * @brief Checks that listing and delisting pairs keeps a graph's cycle index equal to a fresh build,
+ * and that detection sees cycles through pairs listed after the build.
+ *
+ * Exits non-zero on the first violated expectation.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "arbitragegraph.h"
+#include "cycleindex.h"
+
+namespace {
+
+int failures = 0;
+
+#define EXPECT(condition, ...)                                                    \
+  do {                                                                            \
+    if (!(condition)) {                                                           \
+      std::fprintf(stderr, "%s:%d: FAILED %s: ", __FILE__, __LINE__, #condition); \
+      std::fprintf(stderr, __VA_ARGS__);                                          \
+      std::fprintf(stderr, "\n");                                                 \
+      failures++;                                                                 \
+    }                                                                             \
+  } while (0)
+
+using CycleLegs = std::vector<uint32_t>;
+
+/**
+ * @brief The live cycles of an index as their edge slots, sorted.
+ */
+std::vector<CycleLegs> live_cycles(const CycleIndex& index) {
+  std::vector<CycleLegs> cycles;
+  for (int cycle = 0; cycle < index.num_cycles(); cycle++) {
+    if (index.is_live(cycle)) {
+      cycles.emplace_back(index.cycle_edges(cycle), index.cycle_edges(cycle) + index.cycle_length(cycle));
+    }
+  }
+  std::sort(cycles.begin(), cycles.end());
+  return cycles;
+}
+
+/**
+ * @brief Compares the graph's maintained index with one built from scratch over the same listing.
+ */
+void expect_matches_build(ArbitrageGraph& graph, int max_legs, const std::vector<int>& anchors, const char* step) {
+  const CycleIndex& maintained = graph.indexed_cycles();
+  std::pmr::vector<uint8_t> listed(graph.pair_capacity(), 0);
+  for (int pair_id = 0; pair_id < graph.catalog().num_pairs(); pair_id++) {
+    listed[pair_id] = graph.is_listed(pair_id) ? 1 : 0;
+  }
+  CycleIndex fresh;
+  fresh.build(graph.catalog(), listed, max_legs, anchors);
+
+  std::vector<CycleLegs> expected = live_cycles(fresh);
+  std::vector<CycleLegs> actual = live_cycles(maintained);
+  EXPECT(actual == expected, "%s: %zu live cycles, a fresh build has %zu", step, actual.size(), expected.size());
+
+  /* Every live cycle is listed under each of its slots, once */
+  for (int cycle = 0; cycle < maintained.num_cycles(); cycle++) {
+    if (!maintained.is_live(cycle)) {
+      continue;
+    }
+    for (int leg = 0; leg < maintained.cycle_length(cycle); leg++) {
+      uint32_t slot = maintained.cycle_edges(cycle)[leg];
+      long listings = std::count(maintained.cycles_begin(slot), maintained.cycles_end(slot),
+                                 static_cast<uint32_t>(cycle));
+      EXPECT(listings == 1, "%s: cycle %d listed %ld times under slot %u", step, cycle, listings, slot);
+    }
+  }
+}
+
+/**
+ * @brief Random delistings, relistings and new listings on an anchored 5-leg index.
+ */
+void test_listing_changes() {
+  std::vector<std::string> currencies = {"USD", "USDT", "EUR", "BTC", "ETH", "SOL", "ADA", "XRP", "DOT", "LTC",
+                                         "LINK", "AVAX"};
+  std::vector<std::string> symbols;
+  for (size_t base = 3; base < currencies.size(); base++) {
+    for (size_t quote = 0; quote < 3; quote++) {
+      symbols.push_back(currencies[base] + "-" + currencies[quote]);
+    }
+  }
+  symbols.push_back("USDT-USD");
+  symbols.push_back("EUR-USD");
+  symbols.push_back("ETH-BTC");
+  symbols.push_back("SOL-BTC");
+
+  const int max_legs = 5;
+  ArbitrageGraph graph(symbols, 200, 40);
+  std::vector<int> anchors = {graph.catalog().find_currency("USD"), graph.catalog().find_currency("USDT"),
+                              graph.catalog().find_currency("EUR")};
+  graph.set_detection_mode(DetectionMode::Indexed);
+  graph.set_cycle_index(max_legs, anchors);
+  expect_matches_build(graph, max_legs, anchors, "initial build");
+
+  std::mt19937 random(7);
+  for (int step = 0; step < 300; step++) {
+    std::string label = "step " + std::to_string(step);
+    int action = static_cast<int>(random() % 3);
+    if (action == 0) {
+      graph.remove_pair(static_cast<int>(random() % graph.catalog().num_pairs()));
+    } else if (action == 1) {
+      graph.add_pair(graph.catalog().symbol(static_cast<int>(random() % graph.catalog().num_pairs())));
+    } else if (graph.catalog().num_pairs() < graph.pair_capacity()) {
+      /* A new pair between two existing currencies, or with a new one */
+      int base = static_cast<int>(random() % graph.catalog().num_currencies());
+      int quote = static_cast<int>(random() % graph.catalog().num_currencies());
+      std::string base_name = random() % 4 == 0 ? "NEW" + std::to_string(step) : graph.catalog().currency_name(base);
+      std::string quote_name = graph.catalog().currency_name(quote);
+      if (base_name != quote_name && graph.catalog().find_pair(base_name + "-" + quote_name) < 0 &&
+          graph.catalog().find_pair(quote_name + "-" + base_name) < 0 &&
+          graph.catalog().num_currencies() < graph.currency_capacity()) {
+        graph.add_pair(base_name + "-" + quote_name);
+      }
+    }
+    expect_matches_build(graph, max_legs, anchors, label.c_str());
+    if (failures > 0) {
+      return;
+    }
+  }
+}
+
+/**
+ * @brief A triangle closed by a pair listed after the build is detected and ranked; delisting the pair retires it.
+ */
+void test_detection_after_listing() {
+  ArbitrageGraph graph({"BTC-USD", "ETH-USD"}, 4, 4);
+  graph.set_detection_mode(DetectionMode::Indexed);
+  graph.set_cycle_index(3, {});
+  EXPECT(graph.indexed_cycles().num_cycles() == 0, "two pairs should close no triangle");
+
+  graph.update_price(0, 60000.0, 0, 1);
+  graph.update_price(1, 3000.0, 0, 1);
+  int eth_btc = graph.add_pair("ETH-BTC");
+  EXPECT(graph.indexed_cycles().num_cycles() == 2, "ETH-BTC should close both directions of one triangle, got %d",
+         graph.indexed_cycles().num_cycles());
+
+  /* ETH is cheap in BTC terms: USD -> BTC -> ETH -> USD gains 1% */
+  graph.update_price(eth_btc, 0.0495, 0, 2);
+  Opportunity opportunity;
+  EXPECT(graph.find_arbitrage_cycle(opportunity), "the new triangle was not detected");
+  EXPECT(std::fabs(opportunity.log_profit - std::log(3000.0 / (60000.0 * 0.0495))) < 1e-9,
+         "log-profit %.6f, expected log(1.0101)", opportunity.log_profit);
+  EXPECT(graph.best_indexed_cycle(opportunity), "the new triangle did not rank first");
+
+  graph.remove_pair(eth_btc);
+  EXPECT(!graph.best_indexed_cycle(opportunity), "a retired cycle is still ranked first");
+  graph.update_price(0, 60000.0, 0, 3);
+  EXPECT(!graph.find_arbitrage_cycle(opportunity), "a retired cycle was detected");
+
+  graph.add_pair("ETH-BTC");
+  EXPECT(graph.indexed_cycles().num_cycles() == 2, "relisting should revive the two cycles, not add %d",
+         graph.indexed_cycles().num_cycles() - 2);
+  graph.update_price(eth_btc, 0.0495, 0, 4);
+  EXPECT(graph.find_arbitrage_cycle(opportunity), "the revived triangle was not detected");
+}
+
+}  // namespace
+
+int main() {
+  test_listing_changes();
+  test_detection_after_listing();
+  if (failures > 0) {
+    std::fprintf(stderr, "%d expectation(s) failed\n", failures);
+    return EXIT_FAILURE;
+  }
+  std::printf("cycleindex_test: all checks passed\n");
+  return EXIT_SUCCESS;
+}
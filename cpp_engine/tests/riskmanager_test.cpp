@@ -0,0 +1,239 @@
+/**
+ * @file riskmanager_test.cpp
+ * @brief Concurrent-update tests of RiskManager: several threads check, keep,
+ * release and roll back cycles against one instance, and every limit is checked
+ * once they have settled.
+ *
+ * Exits non-zero on the first violated expectation.
+ */
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "clock.h"
+#include "riskmanager.h"
+
+namespace {
+
+int failures = 0;
+
+#define EXPECT(condition, ...)                                        \
+  do {                                                                \
+    if (!(condition)) {                                               \
+      std::fprintf(stderr, "%s:%d: FAILED %s: ", __FILE__, __LINE__, #condition); \
+      std::fprintf(stderr, __VA_ARGS__);                              \
+      std::fprintf(stderr, "\n");                                     \
+      failures++;                                                     \
+    }                                                                 \
+  } while (0)
+
+const unsigned NUM_THREADS = 8;
+
+/**
+ * @brief A three-leg USD -> BTC -> ETH -> USD cycle over currency IDs 0, 1, 2 that leaves +0.01% USD.
+ */
+CycleRiskRequest triangle_request(double usd_amount, int64_t now_ns) {
+  CycleRiskRequest request;
+  request.num_legs = 3;
+  request.notional = usd_amount;
+  request.now_ns = now_ns;
+  request.legs[0] = {0, usd_amount, 1, usd_amount / 60000.0};
+  request.legs[1] = {1, usd_amount / 60000.0, 2, usd_amount / 3000.0};
+  request.legs[2] = {2, usd_amount / 3000.0, 0, usd_amount * 1.0001};
+  return request;
+}
+
+/**
+ * @brief Runs `body(thread_index)` on `NUM_THREADS` threads released together, and waits for all of them.
+ */
+template <typename Body>
+void run_threads(Body&& body) {
+  std::atomic<bool> go{false};
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < NUM_THREADS; t++) {
+    threads.emplace_back([&, t]() {
+      while (!go.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+      }
+      body(t);
+    });
+  }
+  go.store(true, std::memory_order_release);
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+/**
+ * @brief Kept reservations fill the USD band; after every round the settled positions must be inside
+ * every band and equal exactly the kept cycles.
+ */
+void test_position_band() {
+  RiskConfig config;
+  RiskManager risk(3, config);
+  const double band = 25.0;
+  risk.set_position_limits(0, -band, band);
+  risk.set_position_limits(1, -band / 60000.0, band / 60000.0);
+  risk.set_position_limits(2, -band / 3000.0, band / 3000.0);
+
+  /* What one reservation moves, measured on an unconstrained instance */
+  RiskManager reference(3, config);
+  CycleRiskRequest request = triangle_request(1000.0, 0);
+  reference.check_cycle(request);
+  double unit[3] = {reference.position(0), reference.position(1), reference.position(2)};
+
+  std::atomic<long> kept{0};
+  for (int round = 0; round < 20; round++) {
+    run_threads([&](unsigned) {
+      CycleRiskRequest mine = triangle_request(1000.0, 0);
+      long local_kept = 0;
+      for (int i = 0; i < 20000; i++) {
+        if (risk.check_cycle(mine) != RiskVerdict::Accepted) {
+          continue;
+        }
+        if (i % 7 == 0) {
+          local_kept++;
+        } else {
+          risk.release_cycle(mine);
+        }
+      }
+      kept += local_kept;
+    });
+
+    EXPECT(std::fabs(risk.position(0)) <= band + 1e-9, "round %d: USD position %.8f outside +-%.2f", round,
+           risk.position(0), band);
+    EXPECT(std::fabs(risk.position(1)) <= band / 60000.0 + 1e-9, "round %d: BTC position %.8f outside band", round,
+           risk.position(1));
+    EXPECT(std::fabs(risk.position(2)) <= band / 3000.0 + 1e-9, "round %d: ETH position %.8f outside band", round,
+           risk.position(2));
+    for (int id = 0; id < 3; id++) {
+      double expected = kept.load() * unit[id];
+      EXPECT(std::fabs(risk.position(id) - expected) < 1e-6, "round %d: currency %d at %.8f, kept cycles make %.8f",
+             round, id, risk.position(id), expected);
+    }
+  }
+  EXPECT(kept.load() > 0, "no cycle was ever kept");
+}
+
+/**
+ * @brief Every accepted cycle is released and many are rolled back at the band: nothing may be left over.
+ */
+void test_release_and_rollback() {
+  RiskConfig config;
+  config.orders_per_second = 1e12;
+  config.order_burst = 1e6;
+  RiskManager risk(3, config);
+  /* Room for one 0.1 USD reservation, so commits collide and roll back */
+  risk.set_position_limits(0, -0.15, 0.15);
+
+  std::atomic<int> held{0};
+  std::atomic<int> most_held{0};
+  std::atomic<long> accepted{0};
+  std::atomic<long> refused{0};
+  run_threads([&](unsigned) {
+    CycleRiskRequest mine = triangle_request(1000.0, 0);
+    for (int i = 0; i < 2000000; i++) {
+      mine.now_ns = i;
+      if (risk.check_cycle(mine) == RiskVerdict::Accepted) {
+        int now_held = ++held;
+        int seen = most_held.load();
+        while (seen < now_held && !most_held.compare_exchange_weak(seen, now_held)) {
+        }
+        accepted++;
+        held--;
+        risk.release_cycle(mine);
+      } else {
+        refused++;
+      }
+    }
+  });
+
+  EXPECT(most_held.load() <= 1, "%d reservations of 0.1 USD were held at once in a 0.15 USD band", most_held.load());
+
+  for (int id = 0; id < 3; id++) {
+    EXPECT(risk.position(id) == 0.0, "currency %d left at %.8f after %ld releases", id, risk.position(id),
+           accepted.load());
+  }
+  EXPECT(accepted.load() > 0, "no cycle was accepted (%ld refused)", refused.load());
+}
+
+/**
+ * @brief No cycle over the per-cycle cap is accepted, whatever the interleaving.
+ */
+void test_cycle_cap() {
+  RiskConfig config;
+  config.max_cycle_notional = 5000.0;
+  RiskManager risk(3, config);
+
+  std::atomic<long> oversized_accepted{0};
+  std::atomic<long> allowed_accepted{0};
+  run_threads([&](unsigned t) {
+    for (int i = 0; i < 100000; i++) {
+      double notional = (i + t) % 2 == 0 ? 4999.0 : 5001.0;
+      CycleRiskRequest mine = triangle_request(notional, 0);
+      if (risk.check_cycle(mine) == RiskVerdict::Accepted) {
+        (notional > config.max_cycle_notional ? oversized_accepted : allowed_accepted)++;
+        risk.release_cycle(mine);
+      }
+    }
+  });
+  EXPECT(oversized_accepted.load() == 0, "%ld cycles over the cap were accepted", oversized_accepted.load());
+  EXPECT(allowed_accepted.load() == NUM_THREADS * 50000L, "%ld of %ld cycles under the cap were accepted",
+         allowed_accepted.load(), NUM_THREADS * 50000L);
+}
+
+/**
+ * @brief Orders let through never exceed burst + rate * elapsed, counted over all threads.
+ */
+void test_rate_limit() {
+  RiskConfig config;
+  config.orders_per_second = 200000.0;
+  config.order_burst = 30.0;
+  RiskManager risk(3, config);
+
+  const int64_t duration_ns = 50000000;
+  int64_t start = steady_now_ns();
+  std::atomic<long> orders{0};
+  std::atomic<int64_t> last_now{start};
+  run_threads([&](unsigned) {
+    CycleRiskRequest mine = triangle_request(1000.0, 0);
+    while (true) {
+      int64_t now = steady_now_ns();
+      if (now - start > duration_ns) {
+        break;
+      }
+      mine.now_ns = now;
+      if (risk.check_cycle(mine) == RiskVerdict::Accepted) {
+        orders += mine.num_legs;
+        int64_t seen = last_now.load();
+        while (seen < now && !last_now.compare_exchange_weak(seen, now)) {
+        }
+      }
+    }
+  });
+
+  double elapsed_s = (last_now.load() - start) / 1e9;
+  double allowed = config.order_burst + config.orders_per_second * elapsed_s;
+  EXPECT(orders.load() <= allowed + 1e-9, "%ld orders went through, limit %.1f over %.6f s", orders.load(), allowed,
+         elapsed_s);
+  EXPECT(orders.load() > 0, "the rate limit let nothing through");
+}
+
+}  // namespace
+
+int main() {
+  test_position_band();
+  test_release_and_rollback();
+  test_cycle_cap();
+  test_rate_limit();
+  if (failures > 0) {
+    std::fprintf(stderr, "%d expectation(s) failed\n", failures);
+    return EXIT_FAILURE;
+  }
+  std::printf("riskmanager_test: all checks passed\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,459 @@
+/**
+ * @file tickarchive.cpp
+ * @brief Implements loading and writing of tick archives.
+ *
+ * @details
+ * CSV captures are memory-mapped and cut into chunks of about `CSV_CHUNK_BYTES`
+ * that start just after a newline. Each chunk is parsed by its own task into a
+ * private record buffer, with pair IDs local to the chunk, so workers share
+ * nothing. The chunks are then handed on in file order: their symbols are
+ * registered in order of first appearance, which gives the same pair IDs as a
+ * single sequential pass, and each buffer is remapped and copied into place in
+ * parallel. Field boundaries come from a delimiter bitmask built 64 bytes at a
+ * time with SSE2 compares, part of the x86-64 baseline, with a scalar fallback
+ * elsewhere.
+ */
+
+#include "tickarchive.h"
+
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "parallel.h"
+
+namespace {
+
+struct ArchiveHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t num_symbols;
+};
+static_assert(sizeof(ArchiveHeader) == 16, "ArchiveHeader is part of the on-disk format");
+
+/**
+ * @brief Days since 1970-01-01 for a proleptic Gregorian date (Howard Hinnant's algorithm).
+ */
+int64_t days_from_civil(int64_t year, unsigned month, unsigned day) {
+  year -= month <= 2;
+  const int64_t era = (year >= 0 ? year : year - 399) / 400;
+  const unsigned year_of_era = static_cast<unsigned>(year - era * 400);
+  const unsigned day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+  const unsigned day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+  return era * 146097 + static_cast<int64_t>(day_of_era) - 719468;
+}
+
+bool read_digits(const char* text, size_t length, size_t& pos, size_t count, int64_t& value) {
+  value = 0;
+  for (size_t i = 0; i < count; i++, pos++) {
+    if (pos >= length || text[pos] < '0' || text[pos] > '9') {
+      return false;
+    }
+    value = value * 10 + (text[pos] - '0');
+  }
+  return true;
+}
+
+std::string_view trim(std::string_view field) {
+  size_t first = field.find_first_not_of(" \t\r");
+  if (first == std::string_view::npos) {
+    return std::string_view();
+  }
+  size_t last = field.find_last_not_of(" \t\r");
+  return field.substr(first, last - first + 1);
+}
+
+/**
+ * @brief Parses a decimal field, allowing blanks around it and a leading '+'.
+ * @return False if the field is not entirely one finite number.
+ */
+bool parse_number(const char* begin, const char* end, double& value) {
+  while (begin < end && (*begin == ' ' || *begin == '+')) {
+    begin++;
+  }
+  std::from_chars_result result = std::from_chars(begin, end, value);
+  if (result.ec != std::errc() || !std::isfinite(value)) {
+    return false;
+  }
+  for (const char* rest = result.ptr; rest < end; rest++) {
+    if (*rest != ' ' && *rest != '\t' && *rest != '\r') {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief True if `symbol` fits an archive symbol field and reads "BASE-QUOTE" with both sides non-empty.
+ */
+bool valid_symbol(std::string_view symbol) {
+  size_t delimiter = symbol.find('-');
+  return symbol.size() <= TickArchive::SYMBOL_FIELD_SIZE && delimiter != std::string_view::npos && delimiter > 0 &&
+         delimiter + 1 < symbol.size();
+}
+
+/**
+ * @class DelimiterScanner
+ * @brief Yields the positions of every ',' and '\n' in a buffer, in order.
+ *
+ * Each 64-byte block is classified into one bitmask of delimiter positions,
+ * which are then read off with count-trailing-zeros, so a row costs a few bit
+ * operations rather than a byte-by-byte search per field.
+ */
+class DelimiterScanner {
+public:
+  DelimiterScanner(const char* begin, const char* end) : block(begin), end(end) { classify(); }
+
+  /// @brief The next delimiter, or `end` once there are none left.
+  const char* next() {
+    while (mask == 0) {
+      block += 64;
+      if (block >= end) {
+        return end;
+      }
+      classify();
+    }
+    const char* delimiter = block + __builtin_ctzll(mask);
+    mask &= mask - 1;
+    return delimiter;
+  }
+
+private:
+  const char* block;
+  const char* end;
+  uint64_t mask = 0;
+
+  void classify() {
+    size_t length = static_cast<size_t>(end - block);
+#if defined(__SSE2__)
+    if (length >= 64) {
+      const __m128i comma = _mm_set1_epi8(',');
+      const __m128i newline = _mm_set1_epi8('\n');
+      mask = 0;
+      for (int i = 0; i < 4; i++) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * i));
+        __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(bytes, comma), _mm_cmpeq_epi8(bytes, newline));
+        mask |= static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(hits))) << (16 * i);
+      }
+      return;
+    }
+#endif
+    mask = 0;
+    for (size_t i = 0; i < length && i < 64; i++) {
+      if (block[i] == ',' || block[i] == '\n') {
+        mask |= uint64_t{1} << i;
+      }
+    }
+  }
+};
+
+/**
+ * @struct CsvChunk
+ * @brief Trades parsed from one chunk of a capture, with pair IDs into the chunk's own symbol list.
+ */
+struct CsvChunk {
+  const char* begin;
+  const char* end;
+  std::vector<TickRecord> records;
+  /// @brief Symbols in order of first appearance in the chunk; they point into the mapped file.
+  std::vector<std::string_view> symbols;
+  /// @brief Rows dropped for a bad timestamp, symbol or number, or missing fields.
+  size_t skipped_rows = 0;
+};
+
+/**
+ * @brief Parses the rows of a chunk (timestamp, symbol, price, quantity), skipping malformed ones.
+ *
+ * A row is kept only if its timestamp parses, its symbol is a "BASE-QUOTE" that
+ * fits the archive's symbol field, and both numbers parse in full. Anything else
+ * would either stop the load when the symbol is registered or enter the
+ * archive as a zero price.
+ */
+void parse_csv_chunk(CsvChunk& chunk) {
+  std::unordered_map<std::string_view, uint32_t> local_ids;
+  chunk.records.reserve(static_cast<size_t>(chunk.end - chunk.begin) / 48);
+
+  DelimiterScanner scanner(chunk.begin, chunk.end);
+  const char* row = chunk.begin;
+  while (row < chunk.end) {
+    /* The first three commas bound the fields, and a fourth (extra columns) or the newline ends the quantity */
+    const char* commas[4];
+    int num_commas = 0;
+    const char* row_end = chunk.end;
+    for (const char* delimiter = scanner.next(); delimiter != chunk.end; delimiter = scanner.next()) {
+      if (*delimiter == '\n') {
+        row_end = delimiter;
+        break;
+      }
+      if (num_commas < 4) {
+        commas[num_commas] = delimiter;
+      }
+      num_commas++;
+    }
+
+    bool kept = false;
+    if (num_commas >= 3) {
+      int64_t ts = parse_timestamp_ns(row, static_cast<size_t>(commas[0] - row));
+      std::string_view symbol = trim(std::string_view(commas[0] + 1, static_cast<size_t>(commas[1] - commas[0] - 1)));
+      TickRecord record{};
+      if (ts >= 0 && valid_symbol(symbol) && parse_number(commas[1] + 1, commas[2], record.price) &&
+          parse_number(commas[2] + 1, num_commas > 3 ? commas[3] : row_end, record.quantity)) {
+        auto inserted = local_ids.emplace(symbol, static_cast<uint32_t>(chunk.symbols.size()));
+        if (inserted.second) {
+          chunk.symbols.push_back(symbol);
+        }
+
+        record.exchange_ts_ns = ts;
+        record.receive_ts_ns = ts;
+        record.pair_id = inserted.first->second;
+        record.kind = TickKind::Trade;
+        chunk.records.push_back(record);
+        kept = true;
+      }
+    }
+    /* Blank lines, such as a trailing one, are not rows */
+    if (!kept && row_end > row && !(row_end == row + 1 && *row == '\r')) {
+      chunk.skipped_rows++;
+    }
+    row = row_end + 1;
+  }
+}
+
+}
+
+int64_t parse_timestamp_ns(const char* text, size_t length) {
+  size_t pos = 0;
+  while (pos < length && text[pos] == ' ') {
+    pos++;
+  }
+
+  int64_t year, month, day, hour, minute, second;
+  if (!read_digits(text, length, pos, 4, year) || pos >= length || text[pos++] != '-' ||
+      !read_digits(text, length, pos, 2, month) || pos >= length || text[pos++] != '-' ||
+      !read_digits(text, length, pos, 2, day) || pos >= length || (text[pos] != ' ' && text[pos] != 'T')) {
+    return -1;
+  }
+  pos++;
+  if (!read_digits(text, length, pos, 2, hour) || pos >= length || text[pos++] != ':' ||
+      !read_digits(text, length, pos, 2, minute) || pos >= length || text[pos++] != ':' ||
+      !read_digits(text, length, pos, 2, second)) {
+    return -1;
+  }
+
+  /* Fractional seconds, truncated to nanoseconds */
+  int64_t fraction_ns = 0;
+  if (pos < length && text[pos] == '.') {
+    pos++;
+    int64_t scale = 100000000;
+    while (pos < length && text[pos] >= '0' && text[pos] <= '9') {
+      fraction_ns += (text[pos] - '0') * scale;
+      scale /= 10;
+      pos++;
+    }
+  }
+
+  /* UTC offset: "Z", "+HH:MM" or "-HH:MM"; absent means UTC */
+  int64_t offset_seconds = 0;
+  if (pos < length && (text[pos] == '+' || text[pos] == '-')) {
+    int sign = text[pos++] == '-' ? -1 : 1;
+    int64_t offset_hours, offset_minutes;
+    if (!read_digits(text, length, pos, 2, offset_hours) || pos >= length || text[pos++] != ':' ||
+        !read_digits(text, length, pos, 2, offset_minutes)) {
+      return -1;
+    }
+    offset_seconds = sign * (offset_hours * 3600 + offset_minutes * 60);
+  }
+
+  int64_t seconds = days_from_civil(year, static_cast<unsigned>(month), static_cast<unsigned>(day)) * 86400 +
+                    hour * 3600 + minute * 60 + second - offset_seconds;
+  return seconds * 1000000000LL + fraction_ns;
+}
+
+TickArchive::~TickArchive() {
+  if (mapped_region != nullptr) {
+    munmap(mapped_region, mapped_size);
+  }
+}
+
+void TickArchive::add_symbol(const std::string& symbol) {
+  pair_catalog.add_pair(symbol);
+  symbol_list.push_back(symbol);
+}
+
+void TickArchive::open(const std::string& path, unsigned num_threads) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("Could not open tick archive: " + path);
+  }
+
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0) {
+    ::close(fd);
+    throw std::runtime_error("Could not stat tick archive: " + path);
+  }
+
+  ArchiveHeader header;
+  bool is_binary = file_stat.st_size >= static_cast<off_t>(sizeof(header)) &&
+                   pread(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)) &&
+                   std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0;
+  if (!is_binary) {
+    ::close(fd);
+    load_csv(path, num_threads);
+    return;
+  }
+
+  if (header.version != VERSION) {
+    ::close(fd);
+    throw std::runtime_error("Unsupported tick archive version in " + path);
+  }
+
+  size_t records_offset = sizeof(header) + header.num_symbols * SYMBOL_FIELD_SIZE;
+  size_t file_size = static_cast<size_t>(file_stat.st_size);
+  if (file_size < records_offset) {
+    ::close(fd);
+    throw std::runtime_error("Truncated tick archive: " + path);
+  }
+
+  void* region = mmap(nullptr, file_size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (region == MAP_FAILED) {
+    throw std::runtime_error("Could not map tick archive: " + path);
+  }
+  madvise(region, file_size, MADV_SEQUENTIAL);
+  mapped_region = region;
+  mapped_size = file_size;
+
+  const char* base = static_cast<const char*>(region);
+  for (uint32_t i = 0; i < header.num_symbols; i++) {
+    const char* field = base + sizeof(header) + i * SYMBOL_FIELD_SIZE;
+    add_symbol(std::string(field, strnlen(field, SYMBOL_FIELD_SIZE)));
+  }
+
+  records = reinterpret_cast<const TickRecord*>(base + records_offset);
+  record_count = (file_size - records_offset) / sizeof(TickRecord);
+}
+
+/**
+ * @brief Parses a data logger CSV capture (timestamp, symbol, price, quantity) into trade ticks.
+ */
+void TickArchive::load_csv(const std::string& path, unsigned num_threads) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  struct stat file_stat;
+  if (fd < 0 || fstat(fd, &file_stat) != 0) {
+    if (fd >= 0) {
+      ::close(fd);
+    }
+    throw std::runtime_error("Could not open tick archive: " + path);
+  }
+  size_t file_size = static_cast<size_t>(file_stat.st_size);
+  if (file_size == 0) {
+    ::close(fd);
+    return;
+  }
+  void* region = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (region == MAP_FAILED) {
+    throw std::runtime_error("Could not map tick archive: " + path);
+  }
+  madvise(region, file_size, MADV_WILLNEED);
+
+  /* Skip the header row, then cut the rest into chunks that each start just after a newline */
+  const char* text = static_cast<const char*>(region);
+  const char* text_end = text + file_size;
+  const char* header_end = static_cast<const char*>(std::memchr(text, '\n', file_size));
+  const char* data = header_end != nullptr ? header_end + 1 : text_end;
+  std::vector<CsvChunk> chunks;
+  while (data < text_end) {
+    const char* chunk_end = text_end;
+    if (static_cast<size_t>(text_end - data) > CSV_CHUNK_BYTES) {
+      const char* newline = static_cast<const char*>(
+          std::memchr(data + CSV_CHUNK_BYTES, '\n', static_cast<size_t>(text_end - data) - CSV_CHUNK_BYTES));
+      chunk_end = newline != nullptr ? newline + 1 : text_end;
+    }
+    chunks.push_back(CsvChunk{data, chunk_end, {}, {}, 0});
+    data = chunk_end;
+  }
+
+  try {
+    parallel_for(chunks.size(), num_threads, [&](size_t c) { parse_csv_chunk(chunks[c]); });
+
+    /* Registering symbols chunk by chunk, in file order, assigns pair IDs by first appearance */
+    std::vector<std::vector<uint32_t>> pair_ids(chunks.size());
+    std::vector<size_t> offsets(chunks.size() + 1, 0);
+    for (size_t c = 0; c < chunks.size(); c++) {
+      for (std::string_view symbol : chunks[c].symbols) {
+        std::string name(symbol);
+        int pair_id = pair_catalog.find_pair(name);
+        if (pair_id < 0) {
+          add_symbol(name);
+          pair_id = pair_catalog.find_pair(name);
+        }
+        pair_ids[c].push_back(static_cast<uint32_t>(pair_id));
+      }
+      offsets[c + 1] = offsets[c] + chunks[c].records.size();
+      skipped_row_count += chunks[c].skipped_rows;
+    }
+
+    owned_records.resize(offsets.back());
+    parallel_for(chunks.size(), num_threads, [&](size_t c) {
+      TickRecord* out = owned_records.data() + offsets[c];
+      for (const TickRecord& record : chunks[c].records) {
+        *out = record;
+        out->pair_id = pair_ids[c][record.pair_id];
+        out++;
+      }
+      std::vector<TickRecord>().swap(chunks[c].records);
+    });
+  } catch (...) {
+    munmap(region, file_size);
+    throw;
+  }
+  munmap(region, file_size);
+
+  records = owned_records.data();
+  record_count = owned_records.size();
+}
+
+TickArchiveWriter::TickArchiveWriter(const std::string& path, const std::vector<std::string>& symbols) {
+  file = std::fopen(path.c_str(), "wb");
+  if (file == nullptr) {
+    throw std::runtime_error("Could not create tick archive: " + path);
+  }
+
+  ArchiveHeader header;
+  std::memcpy(header.magic, TickArchive::MAGIC, sizeof(header.magic));
+  header.version = TickArchive::VERSION;
+  header.num_symbols = static_cast<uint32_t>(symbols.size());
+  std::fwrite(&header, sizeof(header), 1, file);
+
+  for (const auto& symbol : symbols) {
+    if (symbol.size() > TickArchive::SYMBOL_FIELD_SIZE) {
+      std::fclose(file);
+      throw std::runtime_error("Symbol too long for tick archive: " + symbol);
+    }
+    char field[TickArchive::SYMBOL_FIELD_SIZE] = {};
+    std::memcpy(field, symbol.data(), symbol.size());
+    std::fwrite(field, sizeof(field), 1, file);
+  }
+}
+
+TickArchiveWriter::~TickArchiveWriter() {
+  std::fclose(file);
+}
+
+void TickArchiveWriter::append(const TickRecord& record) {
+  std::fwrite(&record, sizeof(record), 1, file);
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "paircatalog.h"
+
+enum class TickKind : uint8_t {
+  Trade = 0,    ///< A print: `price` and `quantity` of the trade.
+  BestBid = 1,  ///< New best bid: `price` and displayed `quantity`.
+  BestAsk = 2   ///< New best ask: `price` and displayed `quantity`.
+};
+
+/**
+ * @struct TickRecord
+ * @brief One fixed-size market data event in the engine's binary tick format.
+ *
+ * The layout is shared with the Python tooling, so it must not change without
+ * bumping `TickArchive::VERSION`.
+ */
+struct TickRecord {
+  int64_t exchange_ts_ns;
+  int64_t receive_ts_ns;
+  uint32_t pair_id;
+  TickKind kind;
+  uint8_t reserved[3];
+  double price;
+  double quantity;
+};
+static_assert(sizeof(TickRecord) == 40, "TickRecord is part of the on-disk format");
+
+/**
+ * @class TickArchive
+ * @brief A read-only, in-memory sequence of ticks shared by replay consumers.
+ *
+ * Binary archives are memory-mapped read-only, so any number of threads (and
+ * processes) share the same physical pages. CSV captures from the data logger
+ * are parsed once into an owned buffer, in newline-aligned chunks on a pool of
+ * worker threads. Either way, the archive is immutable after `open` and safe to
+ * read concurrently.
+ *
+ * Binary layout: a 16-byte header ("ARBTICK1", version, symbol count), a table
+ * of 16-byte NUL-padded symbols whose positions are the pair IDs, then
+ * `TickRecord`s until end of file.
+ */
+class TickArchive {
+public:
+  static constexpr char MAGIC[8] = {'A', 'R', 'B', 'T', 'I', 'C', 'K', '1'};
+  static constexpr uint32_t VERSION = 1;
+  static constexpr size_t SYMBOL_FIELD_SIZE = 16;
+
+  TickArchive() = default;
+  ~TickArchive();
+  TickArchive(const TickArchive&) = delete;
+  TickArchive& operator=(const TickArchive&) = delete;
+
+  /**
+   * @brief Opens a binary archive, or parses a CSV capture if the file has no archive header.
+   * @param num_threads Threads that parse a CSV capture; 0 means one per hardware thread.
+   * @throws std::runtime_error if the file cannot be read or is malformed.
+   */
+  void open(const std::string& path, unsigned num_threads = 0);
+
+  /// @brief Bytes of CSV parsed by one task; pair IDs still follow first appearance in the file.
+  static constexpr size_t CSV_CHUNK_BYTES = size_t{4} << 20;
+
+  const TickRecord* begin() const { return records; }
+  const TickRecord* end() const { return records + record_count; }
+  size_t size() const { return record_count; }
+  const TickRecord& operator[](size_t index) const { return records[index]; }
+
+  /// @brief Pairs referenced by the records' `pair_id`s.
+  const PairCatalog& catalog() const { return pair_catalog; }
+
+  /// @brief Symbols in pair ID order.
+  const std::vector<std::string>& symbols() const { return symbol_list; }
+
+  /// @brief CSV rows that were not loaded: bad timestamp, malformed or over-long symbol, or an unparseable number.
+  size_t skipped_rows() const { return skipped_row_count; }
+
+private:
+  PairCatalog pair_catalog;
+  std::vector<std::string> symbol_list;
+
+  const TickRecord* records = nullptr;
+  size_t record_count = 0;
+
+  /// @brief Backing store for parsed CSV captures.
+  std::vector<TickRecord> owned_records;
+  size_t skipped_row_count = 0;
+
+  void* mapped_region = nullptr;
+  size_t mapped_size = 0;
+
+  void load_csv(const std::string& path, unsigned num_threads);
+  void add_symbol(const std::string& symbol);
+};
+
+/**
+ * @class TickArchiveWriter
+ * @brief Writes ticks in the binary archive format.
+ */
+class TickArchiveWriter {
+public:
+  /**
+   * @brief Creates the file and writes the header and symbol table.
+   * @throws std::runtime_error if the file cannot be created or a symbol is too long.
+   */
+  TickArchiveWriter(const std::string& path, const std::vector<std::string>& symbols);
+  ~TickArchiveWriter();
+  TickArchiveWriter(const TickArchiveWriter&) = delete;
+  TickArchiveWriter& operator=(const TickArchiveWriter&) = delete;
+
+  void append(const TickRecord& record);
+
+private:
+  std::FILE* file;
+};
+
+/**
+ * @brief Parses a logger timestamp ("YYYY-MM-DD HH:MM:SS[.ffffff][+00:00]", 'T' also accepted).
+ * @return Nanoseconds since the Unix epoch (UTC), or -1 if the text is not a timestamp.
+ */
+int64_t parse_timestamp_ns(const char* text, size_t length);
@@ -0,0 +1,81 @@
+/**
+ * @file timerwheel.cpp
+ * @brief Implements the intrusive hashed timer wheel.
+ */
+
+#include "timerwheel.h"
+
+TimerWheel::TimerWheel(int capacity, int num_slots, int64_t tick_ns, std::pmr::memory_resource* memory)
+  : nodes(capacity, memory), heads(memory), occupied(memory), tick_ns(tick_ns) {
+  int size = 64;
+  while (size < num_slots) {
+    size <<= 1;
+  }
+  this->heads.assign(size, -1);
+  this->occupied.assign(size / 64, 0);
+  this->mask = size - 1;
+}
+
+void TimerWheel::link(int id, int slot) {
+  Node& node = nodes[id];
+  node.slot = slot;
+  node.prev = -1;
+  node.next = heads[slot];
+  if (node.next >= 0) {
+    nodes[node.next].prev = id;
+  }
+  heads[slot] = id;
+  occupied[slot >> 6] |= 1ULL << (slot & 63);
+}
+
+void TimerWheel::unlink(int id) {
+  Node& node = nodes[id];
+  if (node.prev >= 0) {
+    nodes[node.prev].next = node.next;
+  } else {
+    heads[node.slot] = node.next;
+    if (node.next < 0) {
+      occupied[node.slot >> 6] &= ~(1ULL << (node.slot & 63));
+    }
+  }
+  if (node.next >= 0) {
+    nodes[node.next].prev = node.prev;
+  }
+  node.slot = -1;
+}
+
+void TimerWheel::schedule(int id, int64_t deadline_ns) {
+  if (scheduled(id)) {
+    unlink(id);
+  }
+  int64_t tick = deadline_ns / tick_ns;
+  if (tick < current_tick) {
+    tick = current_tick;
+  }
+  nodes[id].deadline_ns = deadline_ns;
+  link(id, static_cast<int>(tick & mask));
+}
+
+void TimerWheel::cancel(int id) {
+  if (scheduled(id)) {
+    unlink(id);
+  }
+}
+
+int64_t TimerWheel::distance_to_occupied(int slot) const {
+  int num_words = static_cast<int>(occupied.size());
+  int word_mask = num_words - 1;
+  int word = slot >> 6;
+  uint64_t bits = occupied[word] & (~0ULL << (slot & 63));
+
+  /* One extra step revisits the starting word's bits below `slot` */
+  for (int step = 0; step <= num_words; step++) {
+    if (bits != 0) {
+      int found = (word << 6) + __builtin_ctzll(bits);
+      return (found - slot) & mask;
+    }
+    word = (word + 1) & word_mask;
+    bits = occupied[word];
+  }
+  return -1;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+/**
+ * @class TimerWheel
+ * @brief A hashed timer wheel with one intrusive timer per integer ID.
+ *
+ * Each ID in [0, capacity) has at most one pending deadline. Scheduling,
+ * rescheduling and cancelling are O(1) list splices into one of `num_slots`
+ * buckets, each `tick_ns` wide; deadlines further out than one revolution stay
+ * in their bucket until a later pass reaches them. A bitmap of non-empty buckets
+ * lets `advance` skip straight to the next bucket with timers, so its cost does
+ * not grow with the time elapsed. All storage is allocated at construction.
+ */
+class TimerWheel {
+public:
+  /**
+   * @param capacity Number of timer IDs.
+   * @param num_slots Buckets in the wheel; rounded up to a power of two of at least 64.
+   * @param tick_ns Width of one bucket.
+   * @param memory Where the nodes and buckets are allocated.
+   */
+  TimerWheel(int capacity, int num_slots, int64_t tick_ns,
+             std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+
+  /**
+   * @brief Sets (or moves) the deadline of timer `id`.
+   * Deadlines already passed fire on the next `advance` that completes a tick.
+   */
+  void schedule(int id, int64_t deadline_ns);
+
+  void cancel(int id);
+
+  bool scheduled(int id) const { return nodes[id].slot >= 0; }
+
+  /**
+   * @brief Fires timers whose deadlines have passed, at most one tick late.
+   *
+   * A bucket is processed once its whole tick lies before `now_ns`, so every timer
+   * with a deadline before `now_ns` rounded down to a tick boundary fires.
+   *
+   * @param on_expire Called with each expired ID, after it has been unscheduled.
+   */
+  template <typename OnExpire>
+  void advance(int64_t now_ns, OnExpire&& on_expire);
+
+private:
+  /**
+   * @struct Node
+   * @brief Intrusive list links of one timer; `slot` is -1 when not scheduled.
+   */
+  struct Node {
+    int prev = -1;
+    int next = -1;
+    int slot = -1;
+    int64_t deadline_ns = 0;
+  };
+
+  std::pmr::vector<Node> nodes;
+  std::pmr::vector<int> heads;
+  /// @brief One bit per bucket, set while the bucket is non-empty.
+  std::pmr::vector<uint64_t> occupied;
+  int64_t mask;
+  int64_t tick_ns;
+  /// @brief The next tick whose bucket has not been processed.
+  int64_t current_tick = 0;
+
+  void link(int id, int slot);
+  void unlink(int id);
+
+  /// @brief Buckets from `slot` (inclusive, wrapping) to the next non-empty one, or -1 if all are empty.
+  int64_t distance_to_occupied(int slot) const;
+};
+
+template <typename OnExpire>
+void TimerWheel::advance(int64_t now_ns, OnExpire&& on_expire) {
+  int64_t end_tick = now_ns / tick_ns;
+  if (end_tick <= current_tick) {
+    return;
+  }
+
+  /* After a gap of a full revolution or more, every bucket is due once */
+  if (end_tick - current_tick > mask + 1) {
+    current_tick = end_tick - (mask + 1);
+  }
+  int64_t horizon_ns = end_tick * tick_ns;
+  while (current_tick < end_tick) {
+    int64_t skip = distance_to_occupied(static_cast<int>(current_tick & mask));
+    if (skip < 0 || current_tick + skip >= end_tick) {
+      current_tick = end_tick;
+      break;
+    }
+    current_tick += skip;
+
+    int slot = static_cast<int>(current_tick & mask);
+    current_tick++;
+    for (int id = heads[slot]; id >= 0;) {
+      int next = nodes[id].next;
+      if (nodes[id].deadline_ns < horizon_ns) {
+        unlink(id);
+        on_expire(id);
+      }
+      id = next;
+    }
+  }
+}
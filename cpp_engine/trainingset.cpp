@@ -0,0 +1,164 @@
+/**
+ * @file trainingset.cpp
+ * @brief Implements parallel extraction of the latency model's training set.
+ *
+ * @details
+ * A day's replay follows the backtester's event order: advance the simulator to
+ * the tick, apply the tick to the book, the feature engine and (for trades) the
+ * graph, then detect and execute. Features are captured when a cycle is sent and
+ * held until the executor reports the cycle finished; the executor keeps at most
+ * one cycle in flight, so one pending row is enough.
+ */
+
+#include "trainingset.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+#include "arbitragegraph.h"
+#include "cycleexecution.h"
+#include "parallel.h"
+
+namespace {
+
+const int64_t NANOS_PER_DAY = 86400LL * 1000000000LL;
+
+/// @brief How long after the day's last tick the simulator keeps running so an in-flight cycle resolves.
+const int64_t DRAIN_HORIZON_NS = 10LL * 1000000000LL;
+
+}
+
+const char* const TrainingSet::TARGET_NAMES[TrainingSet::NUM_TARGETS] = {
+  "tick_to_fill_us",
+  "complete",
+  "realised_pnl_bps",
+};
+
+void TrainingSet::append(const TrainingSet& other) {
+  values.insert(values.end(), other.values.begin(), other.values.end());
+  detections += other.detections;
+}
+
+void TrainingSet::write(const std::string& path) const {
+  std::FILE* file = std::fopen(path.c_str(), "wb");
+  if (file == nullptr) {
+    throw std::runtime_error("Could not create training set: " + path);
+  }
+  size_t written = std::fwrite(values.data(), sizeof(float), values.size(), file);
+  bool failed = std::fclose(file) != 0 || written != values.size();
+  if (failed) {
+    throw std::runtime_error("Could not write training set: " + path);
+  }
+
+  std::ofstream columns(path + ".columns");
+  for (const char* name : FeatureEngine::FEATURE_NAMES) {
+    columns << name << '\n';
+  }
+  for (const char* name : TARGET_NAMES) {
+    columns << name << '\n';
+  }
+  if (!columns) {
+    throw std::runtime_error("Could not write training set columns: " + path + ".columns");
+  }
+}
+
+TrainingSet TrainingSetExtractor::run_day(const TrainingSetConfig& config, size_t first, size_t last,
+                                          uint64_t seed) const {
+  const PairCatalog& catalog = archive.catalog();
+  int valuation_id = catalog.find_currency(config.valuation_currency);
+
+  ArbitrageGraph graph(archive.symbols());
+  FeatureEngine features(catalog.num_pairs());
+  SimulatorConfig simulator_config = config.simulator;
+  simulator_config.seed = seed;
+  ExchangeSimulator simulator(catalog, simulator_config);
+  CycleExecutor executor(catalog, simulator, valuation_id, config.notional, config.limit_tolerance_bps);
+
+  TrainingSet result;
+  float pending[TrainingSet::NUM_COLUMNS];
+
+  auto drain_fills = [&]() {
+    Fill fill;
+    CycleResult cycle;
+    while (simulator.poll_fill(fill)) {
+      if (!executor.on_fill(fill, cycle)) {
+        continue;
+      }
+      float* targets = pending + FeatureEngine::NUM_FEATURES;
+      targets[0] = static_cast<float>(cycle.tick_to_fill_ns() / 1e3);
+      targets[1] = cycle.complete ? 1.0f : 0.0f;
+      targets[2] = static_cast<float>(cycle.realised_pnl / config.notional * 1e4);
+      result.values.insert(result.values.end(), pending, pending + TrainingSet::NUM_COLUMNS);
+    }
+  };
+
+  Opportunity opportunity;
+  int64_t last_ts = 0;
+  for (size_t i = first; i < last; i++) {
+    const TickRecord& tick = archive[i];
+    int64_t ts = tick.receive_ts_ns;
+    last_ts = ts;
+
+    simulator.advance_to(ts);
+    drain_fills();
+    features.on_tick(tick);
+
+    int pair_id = static_cast<int>(tick.pair_id);
+    switch (tick.kind) {
+      case TickKind::Trade:
+        simulator.on_trade(pair_id, tick.price, tick.quantity, ts);
+        break;
+      case TickKind::BestBid:
+        simulator.on_top_of_book(pair_id, OrderSide::Buy, tick.price, tick.quantity, ts);
+        continue;
+      case TickKind::BestAsk:
+        simulator.on_top_of_book(pair_id, OrderSide::Sell, tick.price, tick.quantity, ts);
+        continue;
+    }
+
+    graph.update_price(pair_id, tick.price, tick.exchange_ts_ns, ts);
+    if (!graph.find_arbitrage_cycle(opportunity)) {
+      continue;
+    }
+    result.detections++;
+
+    if (executor.in_flight()) {
+      continue;
+    }
+    features.cycle_features(opportunity, tick, pending);
+    executor.execute(opportunity, ts, ts + config.decision_latency_ns);
+  }
+
+  simulator.advance_to(last_ts + DRAIN_HORIZON_NS);
+  drain_fills();
+  return result;
+}
+
+TrainingSet TrainingSetExtractor::run(const TrainingSetConfig& config, unsigned num_threads) const {
+  if (archive.catalog().find_currency(config.valuation_currency) < 0) {
+    throw std::runtime_error("Valuation currency '" + config.valuation_currency + "' is not traded in the archive");
+  }
+
+  std::vector<std::pair<size_t, size_t>> days;
+  size_t first = 0;
+  for (size_t i = 1; i <= archive.size(); i++) {
+    if (i == archive.size() ||
+        archive[i].receive_ts_ns / NANOS_PER_DAY != archive[first].receive_ts_ns / NANOS_PER_DAY) {
+      days.push_back({first, i});
+      first = i;
+    }
+  }
+
+  std::vector<TrainingSet> day_sets(days.size());
+  parallel_for(days.size(), num_threads, [&](size_t day) {
+    day_sets[day] = run_day(config, days[day].first, days[day].second, config.simulator.seed + day);
+  });
+
+  TrainingSet result;
+  for (const TrainingSet& day_set : day_sets) {
+    result.append(day_set);
+  }
+  return result;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "exchangesimulator.h"
+#include "featureengine.h"
+#include "tickarchive.h"
+
+/**
+ * @struct TrainingSetConfig
+ * @brief Execution model used to label detected cycles with a latency and an outcome.
+ */
+struct TrainingSetConfig {
+  SimulatorConfig simulator;
+  std::string valuation_currency = "USD";
+  double notional = 1000.0;
+  double limit_tolerance_bps = 2.0;
+  /// @brief Time from the triggering tick to the orders leaving the engine.
+  int64_t decision_latency_ns = 0;
+};
+
+/**
+ * @struct TrainingSet
+ * @brief A row-major float32 matrix: one row per executed cycle.
+ *
+ * The first `FeatureEngine::NUM_FEATURES` columns are the features at the
+ * triggering tick; the last three are the targets (tick-to-fill latency, whether
+ * every leg filled, and realised PnL). `write` stores the raw matrix with no
+ * header, so it loads with
+ * `numpy.fromfile(path, dtype=numpy.float32).reshape(-1, NUM_COLUMNS)`, and the
+ * column names next to it in `<path>.columns`.
+ */
+struct TrainingSet {
+  static constexpr int NUM_TARGETS = 3;
+  static constexpr int NUM_COLUMNS = FeatureEngine::NUM_FEATURES + NUM_TARGETS;
+  static const char* const TARGET_NAMES[NUM_TARGETS];
+
+  std::vector<float> values;
+  /// @brief Cycles detected, including those not executed because one was already in flight.
+  size_t detections = 0;
+
+  size_t rows() const { return values.size() / NUM_COLUMNS; }
+
+  void append(const TrainingSet& other);
+
+  /**
+   * @brief Writes the matrix to `path` and the column names to `<path>.columns`.
+   * @throws std::runtime_error if either file cannot be written.
+   */
+  void write(const std::string& path) const;
+};
+
+/**
+ * @class TrainingSetExtractor
+ * @brief Builds the latency model's training set from a tick archive, one UTC day per core.
+ *
+ * Each day is replayed through a cold graph, feature engine, simulator and
+ * executor. Every cycle the executor sends becomes a row once its last leg is
+ * reported; rows are concatenated in day order, so the output is deterministic
+ * for a given archive, configuration and seed.
+ */
+class TrainingSetExtractor {
+public:
+  explicit TrainingSetExtractor(const TickArchive& archive) : archive(archive) {}
+
+  /**
+   * @param num_threads Worker threads; 0 means one per hardware thread.
+   * @throws std::runtime_error if the valuation currency is not traded in the archive.
+   */
+  TrainingSet run(const TrainingSetConfig& config, unsigned num_threads) const;
+
+private:
+  const TickArchive& archive;
+
+  TrainingSet run_day(const TrainingSetConfig& config, size_t first, size_t last, uint64_t seed) const;
+};
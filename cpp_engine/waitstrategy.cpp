@@ -0,0 +1,96 @@
+/**
+ * @file waitstrategy.cpp
+ * @brief Slow paths of the consumer wait strategies: yielding, parking and futex sleeps.
+ *
+ * @details
+ * Blocking waiters sleep on a private futex over `WakeSignal::epoch`. A waiter
+ * reads the epoch, registers as a sleeper and re-checks its condition before
+ * sleeping. A producer publishes, fences and reads the sleeper count, and
+ * bumps the epoch before waking. So either the producer sees the sleeper, or the
+ * sleeper's re-check sees the publication. A wake that lands between the re-check
+ * and the futex call changes the epoch, and FUTEX_WAIT then returns at once.
+ */
+
+#include "waitstrategy.h"
+
+#include <stdexcept>
+#include <thread>
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+
+int64_t thread_cpu_ns() {
+  timespec now;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+  return static_cast<int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+}  // namespace
+
+WaitKind parse_wait_kind(const std::string& name) {
+  if (name == "spin") {
+    return WaitKind::BusySpin;
+  }
+  if (name == "yield") {
+    return WaitKind::SpinYield;
+  }
+  if (name == "park") {
+    return WaitKind::SpinPark;
+  }
+  if (name == "block") {
+    return WaitKind::Blocking;
+  }
+  throw std::invalid_argument("Unknown wait strategy '" + name + "' (expected spin, yield, park or block)");
+}
+
+const char* wait_kind_name(WaitKind kind) {
+  switch (kind) {
+    case WaitKind::BusySpin:
+      return "spin";
+    case WaitKind::SpinYield:
+      return "yield";
+    case WaitKind::SpinPark:
+      return "park";
+    case WaitKind::Blocking:
+      return "block";
+  }
+  return "unknown";
+}
+
+void WakeSignal::wake_all() {
+  epoch.fetch_add(1, std::memory_order_release);
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(&epoch), FUTEX_WAKE_PRIVATE, INT32_MAX, nullptr, nullptr, 0);
+}
+
+void WakeSignal::sleep(uint32_t seen) {
+  static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex word must be a plain 32-bit integer");
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(&epoch), FUTEX_WAIT_PRIVATE, seen, nullptr, nullptr, 0);
+}
+
+WaitStrategy::WaitStrategy(const WaitConfig& config, WakeSignal* signal)
+  : config(config), signal(signal), start_wall_ns(steady_now_ns()), start_cpu_ns(thread_cpu_ns()) {
+  if (config.kind == WaitKind::Blocking && signal == nullptr) {
+    throw std::invalid_argument("The blocking wait strategy needs a WakeSignal");
+  }
+}
+
+void WaitStrategy::back_off() {
+  if (config.kind == WaitKind::SpinPark) {
+    std::this_thread::sleep_for(std::chrono::nanoseconds(config.park_ns));
+    counters.parks++;
+  } else {
+    std::this_thread::yield();
+    counters.yields++;
+  }
+}
+
+WaitStats WaitStrategy::stats() const {
+  WaitStats current = counters;
+  current.wall_ns = steady_now_ns() - start_wall_ns;
+  current.cpu_ns = thread_cpu_ns() - start_cpu_ns;
+  return current;
+}
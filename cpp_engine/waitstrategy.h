@@ -0,0 +1,173 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "clock.h"
+#include "durationhistogram.h"
+
+/**
+ * @enum WaitKind
+ * @brief How an idle consumer thread waits for its next event.
+ */
+enum class WaitKind {
+  BusySpin,   ///< Spins on `pause` forever: lowest wake-up latency, burns a whole core.
+  SpinYield,  ///< Spins for the budget, then yields the core between checks.
+  SpinPark,   ///< Spins for the budget, then sleeps `park_ns` between checks.
+  Blocking    ///< Spins for the budget, then sleeps in the kernel until a producer signals.
+};
+
+/**
+ * @brief Parses a wait strategy name: "spin", "yield", "park" or "block".
+ * @throws std::invalid_argument for any other name.
+ */
+WaitKind parse_wait_kind(const std::string& name);
+
+const char* wait_kind_name(WaitKind kind);
+
+/**
+ * @struct WaitConfig
+ * @brief One consumer's wait strategy.
+ */
+struct WaitConfig {
+  WaitKind kind = WaitKind::SpinYield;
+  /// @brief `pause` iterations before yielding, parking or blocking; ignored by BusySpin.
+  uint32_t spin_budget = 2000;
+  /// @brief Length of one SpinPark sleep.
+  int64_t park_ns = 50000;
+};
+
+/// @brief Spin-loop hint: lets the sibling hyperthread run and saves power while spinning.
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+  _mm_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
+
+/**
+ * @class WakeSignal
+ * @brief Wakes Blocking waiters when the data they wait on may have changed.
+ *
+ * Producers call `notify` after every publish (and a stage that others trail
+ * after advancing its cursor). While no thread is asleep that is a fence and a
+ * load, with no syscall, so only the Blocking strategy pays for the kernel.
+ */
+class WakeSignal {
+public:
+  void notify() {
+    /* Orders the caller's publish before the sleeper count read; pairs with the sleeper's increment */
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleepers.load(std::memory_order_relaxed) != 0) {
+      wake_all();
+    }
+  }
+
+private:
+  friend class WaitStrategy;
+
+  std::atomic<uint32_t> epoch{0};
+  std::atomic<int> sleepers{0};
+
+  void wake_all();
+  /// @brief Sleeps until `epoch` moves past `seen`, or returns at once if it already has.
+  void sleep(uint32_t seen);
+};
+
+/**
+ * @struct WaitStats
+ * @brief What waiting cost one consumer thread.
+ */
+struct WaitStats {
+  /// @brief Times the consumer found nothing to do and had to wait.
+  uint64_t waits = 0;
+  uint64_t spins = 0;
+  uint64_t yields = 0;
+  uint64_t parks = 0;
+  uint64_t sleeps = 0;
+  /// @brief Wall time spent waiting.
+  int64_t idle_ns = 0;
+  /// @brief Wall and CPU time of the thread since the strategy was created.
+  int64_t wall_ns = 0;
+  int64_t cpu_ns = 0;
+  /// @brief From an event's publication to its pickup, for events that found the consumer waiting.
+  DurationHistogram wakeup;
+
+  /// @brief CPU time as a share of wall time: 1.0 is one core burnt.
+  double cpu_share() const { return wall_ns > 0 ? static_cast<double>(cpu_ns) / wall_ns : 0.0; }
+};
+
+/**
+ * @class WaitStrategy
+ * @brief A consumer thread's idle loop: checks for work, spinning, yielding, parking or blocking between checks.
+ *
+ * Every strategy but BusySpin first spins on `pause` for `spin_budget`
+ * iterations, so a thread that is kept busy never leaves user space; only the
+ * first event after a quiet period pays the strategy's wake-up cost. Create the
+ * strategy on the thread that waits: its CPU time is that thread's.
+ */
+class WaitStrategy {
+public:
+  /**
+   * @param signal What Blocking waiters sleep on; producers must `notify` it. Unused by the other strategies.
+   * @throws std::invalid_argument if the strategy is Blocking and `signal` is null.
+   */
+  explicit WaitStrategy(const WaitConfig& config, WakeSignal* signal = nullptr);
+
+  /**
+   * @brief Returns once `ready()` is true.
+   * @return True if the thread had to wait.
+   */
+  template <typename Ready>
+  bool wait_until(Ready&& ready) {
+    if (ready()) {
+      return false;
+    }
+    int64_t start = steady_now_ns();
+    counters.waits++;
+    uint32_t spins = 0;
+    while (!ready()) {
+      if (spins < config.spin_budget || config.kind == WaitKind::BusySpin) {
+        cpu_relax();
+        spins++;
+      } else if (config.kind == WaitKind::Blocking) {
+        uint32_t seen = signal->epoch.load(std::memory_order_acquire);
+        signal->sleepers.fetch_add(1, std::memory_order_seq_cst);
+        if (!ready()) {
+          signal->sleep(seen);
+          counters.sleeps++;
+        }
+        signal->sleepers.fetch_sub(1, std::memory_order_relaxed);
+      } else {
+        back_off();
+      }
+    }
+    counters.spins += spins;
+    counters.idle_ns += steady_now_ns() - start;
+    return true;
+  }
+
+  /// @brief Records the publication-to-pickup latency of an event that ended a wait.
+  void record_wakeup(int64_t latency_ns) { counters.wakeup.add(latency_ns); }
+
+  const WaitConfig& settings() const { return config; }
+
+  /// @brief The counters so far, with wall and CPU time read now; call on the waiting thread.
+  WaitStats stats() const;
+
+private:
+  WaitConfig config;
+  WakeSignal* signal;
+  WaitStats counters;
+  int64_t start_wall_ns;
+  int64_t start_cpu_ns;
+
+  /// @brief One yield or park once the spin budget is spent.
+  void back_off();
+};
@@ -1,82 +1,288 @@
 '''
 Tasks:
 1. Define Config Settings:
-  - Output filename
-  - List of market PRODUCT_IDS to track
-2. Prepare the output file:
-  a. Check if the output CSV file already exists.
-  b. If it does not exist, create it and write the column headers.
-    - timestamp, symbol, price, quantity
-3. Main Data Logging Function:
-  a. Construct the specific connection address (URI) for the Binance WebSocket stream based on the list of PRODUCT_IDS.
-    - base endpoint is: wss://stream.binance.com:9443 or wss://stream.binance.com:443.
-  b. Establish persistent connection to the WebSocket server
-  c. Upon successful connection, start an infinite loop to listen for messages.
-  d. For each message received:
-    i.   Attempt to parse the message as structured JSON data.
-    ii.  Extract the essential trade details: timestamp, symbol, price, and quantity.
-    iii. Append this new trade data as a new line in the output CSV file.
-    iv.  Print the formatted trade data to the console for live monitoring.
-    v.   If any error occurs during this process, print the error and pause briefly before continuing the loop.
+  - Output file prefix, format (csv or binary) and rotation period (none, hour or day)
+  - Products to track (PRODUCT_IDS, or a file with one product per line) and the channels to capture
+  - Number of concurrent connections the products are sharded across
+  - Flush batch size and interval, console summary interval
+2. Prepare the output:
+  a. Every connection has its own writers (see tickwriter.py): ticks are buffered in memory and
+     written by a dedicated task, which flushes when the batch is full or the interval elapses.
+  b. Files rotate by receive time and are named <prefix>_c<connection>_<period>. All connections
+     share one symbol table, so pair IDs agree across their binary files.
+  c. Optionally, raw messages are also recorded with their receive time, for replay_server.py.
+3. Main Data Logging Function (one per connection):
+  a. Connect to the Coinbase WebSocket feed (or a local replay server) and subscribe to the
+     selected channels for this connection's products.
+  b. For each message received:
+    i.   Stamp the local receive time in nanoseconds before doing anything else.
+    ii.  Convert it to ticks:
+           - "match" / "last_match": a trade
+           - "ticker":               best bid and best ask, when they change
+           - "snapshot" / "l2update": applied to a local book; best bid and best ask, when they change
+    iii. Hand the ticks to the connection's writer and count them for the console summary.
+    iv.  If any error occurs, print it, pause briefly and reconnect.
 4. When the script is run directly:
-  a. Start the main data logging function.
+  a. Parse command line options and start the connections, writers and summary.
   b. Keep the program running until the user manually stops it (e.g., with Ctrl+C).
-  c. When stopped, print a confirmation message.
+  c. When stopped, flush buffered ticks and print a confirmation message.
 '''
 
+import argparse
 import asyncio
-import websockets
 import json
-import pandas as pd
+import time
 from datetime import datetime
 
-OUTPUT_FILE = "trade_data_coinbase.csv"
+import websockets
+
+from tickwriter import KIND_BEST_ASK, KIND_BEST_BID, KIND_TRADE, RawMessageWriter, RotatingTickWriter, Tick
+
+OUTPUT_PREFIX = "trade_data_coinbase"
 PRODUCT_IDS = ["BTC-USD", "ETH-USD", "ETH-BTC"]
+CHANNELS = ["matches"]
+FEED_URI = "wss://ws-feed.exchange.coinbase.com"
+RECONNECT_DELAY_S = 5
+
+
+def parse_time_ns(iso_time):
+  '''Coinbase timestamps ("2024-05-01T12:00:00.123456Z") to nanoseconds since the epoch.'''
+  moment = datetime.fromisoformat(iso_time.replace('Z', '+00:00'))
+  return int(moment.timestamp()) * 1_000_000_000 + moment.microsecond * 1000
+
+
+class TopOfBook:
+  '''
+  Level 2 book for one product, kept only to derive the best bid and ask.
+
+  Levels are held in dicts keyed by price; the best price is cached and only
+  recomputed when its own level is removed.
+  '''
+
+  def __init__(self):
+    self.bids = {}
+    self.asks = {}
+    self.best_bid = None
+    self.best_ask = None
+
+  def reset(self, bids, asks):
+    self.bids = {float(price): float(size) for price, size in bids}
+    self.asks = {float(price): float(size) for price, size in asks}
+    self.best_bid = max(self.bids) if self.bids else None
+    self.best_ask = min(self.asks) if self.asks else None
+
+  def apply(self, side, price, size):
+    price = float(price)
+    size = float(size)
+    if side == "buy":
+      if size == 0.0:
+        self.bids.pop(price, None)
+        if price == self.best_bid:
+          self.best_bid = max(self.bids) if self.bids else None
+      else:
+        self.bids[price] = size
+        if self.best_bid is None or price > self.best_bid:
+          self.best_bid = price
+    else:
+      if size == 0.0:
+        self.asks.pop(price, None)
+        if price == self.best_ask:
+          self.best_ask = min(self.asks) if self.asks else None
+      else:
+        self.asks[price] = size
+        if self.best_ask is None or price < self.best_ask:
+          self.best_ask = price
+
+  def top(self):
+    '''(bid, bid size, ask, ask size); missing sides are None.'''
+    bid_size = self.bids[self.best_bid] if self.best_bid is not None else None
+    ask_size = self.asks[self.best_ask] if self.best_ask is not None else None
+    return self.best_bid, bid_size, self.best_ask, ask_size
+
+
+class FeedDecoder:
+  '''
+  Turns one connection's messages into Ticks.
+
+  Quote ticks are only emitted when the top of book moves (price or size), so
+  ticker and level 2 capture do not repeat unchanged quotes.
+  '''
+
+  def __init__(self):
+    self.books = {}
+    self.last_top = {}
+
+  def decode(self, data, receive_ts):
+    kind = data.get("type")
+    symbol = data.get("product_id")
+    if kind in ("match", "last_match"):
+      return [Tick(parse_time_ns(data['time']), receive_ts, symbol, KIND_TRADE,
+                   float(data['price']), float(data['size']))]
+
+    if kind == "ticker":
+      if data.get("best_bid") is None or data.get("best_ask") is None:
+        return []
+      top = (float(data['best_bid']), float(data.get('best_bid_size', 0.0)),
+             float(data['best_ask']), float(data.get('best_ask_size', 0.0)))
+      exchange_ts = parse_time_ns(data['time']) if 'time' in data else receive_ts
+      return self._quote_ticks(symbol, top, exchange_ts, receive_ts)
+
+    if kind == "snapshot":
+      book = self.books.setdefault(symbol, TopOfBook())
+      book.reset(data['bids'], data['asks'])
+      return self._quote_ticks(symbol, book.top(), receive_ts, receive_ts)
 
-try:
-  df = pd.read_csv(OUTPUT_FILE)
-except FileNotFoundError:
-  df = pd.DataFrame(columns=["timestamp", "symbol", "price", "quantity"])
-  df.to_csv(OUTPUT_FILE, index=False)
+    if kind == "l2update":
+      book = self.books.get(symbol)
+      if book is None:
+        return []
+      for side, price, size in data['changes']:
+        book.apply(side, price, size)
+      exchange_ts = parse_time_ns(data['time']) if 'time' in data else receive_ts
+      return self._quote_ticks(symbol, book.top(), exchange_ts, receive_ts)
 
-async def data_logger():
-  uri = f"wss://ws-feed.exchange.coinbase.com"
+    return []
 
+  def _quote_ticks(self, symbol, top, exchange_ts, receive_ts):
+    previous = self.last_top.get(symbol, (None, None, None, None))
+    self.last_top[symbol] = top
+    bid, bid_size, ask, ask_size = top
+    ticks = []
+    if bid is not None and (bid, bid_size) != previous[0:2]:
+      ticks.append(Tick(exchange_ts, receive_ts, symbol, KIND_BEST_BID, bid, bid_size))
+    if ask is not None and (ask, ask_size) != previous[2:4]:
+      ticks.append(Tick(exchange_ts, receive_ts, symbol, KIND_BEST_ASK, ask, ask_size))
+    return ticks
+
+
+class Summary:
+  '''Per-symbol trade and quote counts, printed every `interval` seconds instead of every message.'''
+
+  KIND_NAMES = {KIND_TRADE: "trades", KIND_BEST_BID: "quotes", KIND_BEST_ASK: "quotes"}
+
+  def __init__(self, interval):
+    self.interval = interval
+    self.counts = {}
+    self.last_price = {}
+
+  def record(self, tick):
+    key = (tick.symbol, self.KIND_NAMES[tick.kind])
+    self.counts[key] = self.counts.get(key, 0) + 1
+    if tick.kind == KIND_TRADE:
+      self.last_price[tick.symbol] = tick.price
+
+  async def run(self, writers):
+    while True:
+      await asyncio.sleep(self.interval)
+      symbols = sorted({symbol for symbol, _ in self.counts})
+      parts = []
+      for symbol in symbols:
+        trades = self.counts.get((symbol, "trades"), 0)
+        quotes = self.counts.get((symbol, "quotes"), 0)
+        last = f" @ {self.last_price[symbol]:.4f}" if symbol in self.last_price else ""
+        parts.append(f"{symbol} {trades}t/{quotes}q{last}")
+      written = sum(writer.records_written for writer in writers)
+      pending = sum(writer.pending() for writer in writers)
+      dropped = sum(writer.items_dropped for writer in writers)
+      print(f"{datetime.now():%H:%M:%S} | {' | '.join(parts) or 'no data'} | "
+            f"written {written}, pending {pending}" + (f", dropped {dropped}" if dropped else ""))
+      self.counts.clear()
+
+
+async def data_logger(connection, uri, products, channels, writer, raw_writer, summary):
   subscribe_message = {
     "type": "subscribe",
-    "product_ids": PRODUCT_IDS,
-    "channels": ["matches"]
+    "product_ids": products,
+    "channels": channels
   }
-  
-  async with websockets.connect(uri) as websocket:
-    await websocket.send(json.dumps(subscribe_message))
-    print(f"Connected to Coinbase WebSocket and subscribed to 'matches' for: {PRODUCT_IDS}")
-    
-    while True:
-      try:
-        message = await websocket.recv()
-        data = json.loads(message)
 
-        if data.get("type") == "match":
-          trade_time = datetime.fromisoformat(data['time'].replace('Z', '+00:00'))
-          symbol = data['product_id']
-          price = float(data['price'])
-          quantity = float(data['size'])
+  while True:
+    try:
+      async with websockets.connect(uri, max_size=None) as websocket:
+        await websocket.send(json.dumps(subscribe_message))
+        print(f"[{connection}] Connected to {uri} and subscribed to {channels} for {len(products)} products")
+        decoder = FeedDecoder()
 
-          with open(OUTPUT_FILE, 'a') as f:
-            f.write(f"{trade_time}, {symbol}, {price}, {quantity}\n")
+        async for message in websocket:
+          receive_ts = time.time_ns()
+          # A message that fails to decode or write is skipped; only the connection itself triggers a reconnect
+          try:
+            if raw_writer is not None:
+              raw_writer.add_message(receive_ts, message)
+            for tick in decoder.decode(json.loads(message), receive_ts):
+              writer.add(tick)
+              if summary is not None:
+                summary.record(tick)
+          except Exception as e:
+            print(f"[{connection}] Skipping message that could not be decoded or written: {e!r} in {message[:200]!r}")
 
-          # for debugging purposes:
-          print(f"{trade_time} | {symbol:<10} | Price: {price:<15.4f} | Quantity: {quantity:<15.8f}")
+    except Exception as e:
+      print(f"[{connection}] An error occured: {e}")
+      await asyncio.sleep(RECONNECT_DELAY_S)
+
+
+def load_products(args):
+  if args.products_file is None:
+    return args.products
+  with open(args.products_file) as products_file:
+    return [line.strip() for line in products_file if line.strip() and not line.startswith("#")]
+
+
+async def main(args):
+  products = load_products(args)
+  num_connections = max(1, min(args.connections, len(products)))
+  shards = [products[k::num_connections] for k in range(num_connections)]
+
+  writers = []
+  raw_writers = []
+  for k in range(num_connections):
+    prefix = args.output if num_connections == 1 else f"{args.output}_c{k}"
+    writers.append(RotatingTickWriter(prefix, products, fmt=args.format, rotation=args.rotate,
+                                      flush_records=args.flush_records, flush_seconds=args.flush_seconds))
+    if args.record_raw:
+      raw_writers.append(RawMessageWriter(prefix, rotation=args.rotate, flush_records=args.flush_records,
+                                          flush_seconds=args.flush_seconds))
+  summary = Summary(args.summary_seconds) if args.summary_seconds > 0 else None
+
+  all_writers = writers + raw_writers
+  writer_tasks = [asyncio.create_task(writer.run()) for writer in all_writers]
+  tasks = [asyncio.create_task(data_logger(k, args.uri, shards[k], args.channels, writers[k],
+                                           raw_writers[k] if raw_writers else None, summary))
+           for k in range(num_connections)]
+  if summary is not None:
+    tasks.append(asyncio.create_task(summary.run(writers)))
+  try:
+    # Writer tasks only end once closed, so one finishing early stops the logger instead of buffering forever
+    await asyncio.gather(*tasks, *writer_tasks)
+  finally:
+    for task in tasks:
+      task.cancel()
+    for writer in all_writers:
+      await writer.close()
+    for result in await asyncio.gather(*writer_tasks, return_exceptions=True):
+      if isinstance(result, Exception):
+        print(f"Writer task failed: {result!r}")
 
-      except Exception as e:
-        print(f"An error occured: {e}")
-        # enhance error handling
-        await asyncio.sleep(5)
 
 if __name__ == "__main__":
+  parser = argparse.ArgumentParser(description="Capture Coinbase market data to rotating CSV or binary tick files.")
+  parser.add_argument("--uri", default=FEED_URI, help="feed endpoint, e.g. ws://localhost:8765 for replay_server.py")
+  parser.add_argument("--products", nargs="+", default=PRODUCT_IDS)
+  parser.add_argument("--products-file", help="file with one product per line; overrides --products")
+  parser.add_argument("--channels", nargs="+", default=CHANNELS,
+                      help="any of matches, ticker, level2_batch (or level2 with an authenticated feed)")
+  parser.add_argument("--connections", type=int, default=1, help="concurrent connections to shard products across")
+  parser.add_argument("--output", default=OUTPUT_PREFIX, help="output file prefix (may include a directory)")
+  parser.add_argument("--format", choices=["csv", "binary"], default="csv")
+  parser.add_argument("--rotate", choices=["none", "hour", "day"], default="none")
+  parser.add_argument("--record-raw", action="store_true", help="also record raw messages for replay_server.py")
+  parser.add_argument("--flush-records", type=int, default=1000, help="flush once this many ticks are buffered")
+  parser.add_argument("--flush-seconds", type=float, default=1.0, help="flush at least this often")
+  parser.add_argument("--summary-seconds", type=float, default=10.0, help="console summary interval; 0 disables it")
+  args = parser.parse_args()
+
   try:
-    asyncio.run(data_logger())
+    asyncio.run(main(args))
   except KeyboardInterrupt:
-    print("Data logging stopped.")
-
+    pass
+  print("Data logging stopped.")
@@ -0,0 +1,209 @@
+'''
+End-to-end check of the capture pipeline against a recording, without network access.
+
+Tasks:
+1. Work out what the logger should write: split the products into the logger's
+   connection shards, pass the recorded messages each shard subscribes to through
+   a FeedDecoder, and count ticks per (symbol, kind).
+2. Start replay_server.py on a free port with no pacing, and data_logger.py against
+   it with hourly binary output in a temporary directory.
+3. Wait until the rotated files hold the expected number of records (or time out),
+   then stop the logger with Ctrl+C so it flushes, and stop the server.
+4. Read every rotated file back and check:
+  - each header carries the shared symbol table, so pair IDs agree across files
+  - each record's pair ID is one of its connection's products
+  - each record sits in the file its receive time rotates to
+  - tick counts per symbol and kind equal the expected ones
+5. Print the result and exit non-zero on any mismatch:
+     python replay_check.py captures/coinbase_c0_20240501.jsonl --channels matches ticker level2_batch --connections 2
+'''
+
+import argparse
+import glob
+import json
+import os
+import signal
+import socket
+import subprocess
+import sys
+import tempfile
+import time
+from collections import Counter
+
+from data_logger import CHANNELS, FeedDecoder
+from replay_server import CHANNEL_TYPES, load_recordings
+from tickwriter import HEADER_STRUCT, RECORD_STRUCT, SYMBOL_FIELD_SIZE, TICK_MAGIC, TICK_VERSION, rotated_path
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+KIND_NAMES = {0: "trade", 1: "bid", 2: "ask"}
+
+
+def expected_ticks(messages, shard, channels):
+  '''Ticks per (symbol, kind) that one connection subscribed to `shard` on `channels` should write.'''
+  types = set().union(*(CHANNEL_TYPES.get(channel, set()) for channel in channels))
+  products = set(shard)
+  decoder = FeedDecoder()
+  counts = Counter()
+  for receive_ts, message_type, product, message in messages:
+    if message_type not in types or product not in products:
+      continue
+    # The logger skips messages it cannot decode, so they add nothing here either
+    try:
+      ticks = decoder.decode(json.loads(message), receive_ts)
+    except Exception:
+      continue
+    for tick in ticks:
+      counts[(tick.symbol, tick.kind)] += 1
+  return counts
+
+
+def read_archive(path):
+  '''(symbols, [(receive_ts_ns, pair_id, kind)]) of one binary tick file.'''
+  with open(path, "rb") as archive:
+    data = archive.read()
+  magic, version, count = HEADER_STRUCT.unpack_from(data, 0)
+  if magic != TICK_MAGIC or version != TICK_VERSION:
+    raise ValueError(f"{path}: not a version {TICK_VERSION} tick archive")
+  offset = HEADER_STRUCT.size
+  symbols = []
+  for _ in range(count):
+    symbols.append(data[offset:offset + SYMBOL_FIELD_SIZE].rstrip(b"\0").decode("ascii"))
+    offset += SYMBOL_FIELD_SIZE
+  if (len(data) - offset) % RECORD_STRUCT.size != 0:
+    raise ValueError(f"{path}: truncated record at the end")
+  records = []
+  for fields in RECORD_STRUCT.iter_unpack(data[offset:]):
+    _, receive_ts, pair_id, kind, _, _ = fields
+    records.append((receive_ts, pair_id, kind))
+  return symbols, records
+
+
+def rotated_files(prefix):
+  return sorted(glob.glob(f"{glob.escape(prefix)}_*.bin"))
+
+
+def count_records(prefix):
+  total = 0
+  for path in rotated_files(prefix):
+    size = os.path.getsize(path)
+    with open(path, "rb") as archive:
+      header = archive.read(HEADER_STRUCT.size)
+    if len(header) == HEADER_STRUCT.size:
+      count = HEADER_STRUCT.unpack(header)[2]
+      total += max(0, size - HEADER_STRUCT.size - count * SYMBOL_FIELD_SIZE) // RECORD_STRUCT.size
+  return total
+
+
+def check_connection(prefix, products, shard, expected, errors):
+  '''Checks one connection's rotated files; returns the ticks it wrote per (symbol, kind).'''
+  actual = Counter()
+  files = rotated_files(prefix)
+  if not files and expected:
+    errors.append(f"{prefix}: no rotated binary files were written")
+  for path in files:
+    symbols, records = read_archive(path)
+    if symbols != products:
+      errors.append(f"{path}: symbol table {symbols} is not the shared one {products}")
+      continue
+    for receive_ts, pair_id, kind in records:
+      if pair_id >= len(symbols) or symbols[pair_id] not in shard:
+        errors.append(f"{path}: pair ID {pair_id} is not one of this connection's products {shard}")
+        break
+      if kind not in KIND_NAMES:
+        errors.append(f"{path}: unknown tick kind {kind}")
+        break
+      if rotated_path(prefix, "bin", "hour", receive_ts) != path:
+        errors.append(f"{path}: record received at {receive_ts} belongs in another hour's file")
+        break
+      actual[(symbols[pair_id], kind)] += 1
+
+  for key in sorted(set(expected) | set(actual)):
+    if expected[key] != actual[key]:
+      symbol, kind = key
+      errors.append(f"{prefix}: {symbol} {KIND_NAMES[kind]} ticks: wrote {actual[key]}, expected {expected[key]}")
+  return actual
+
+
+def free_port():
+  with socket.socket() as probe:
+    probe.bind(("localhost", 0))
+    return probe.getsockname()[1]
+
+
+def run(args, workdir):
+  messages = load_recordings(args.recordings)
+  products = args.products or sorted({product for _, _, product, _ in messages if product})
+  num_connections = max(1, min(args.connections, len(products)))
+  shards = [products[k::num_connections] for k in range(num_connections)]
+  output = os.path.join(workdir, "replay")
+  prefixes = [output if num_connections == 1 else f"{output}_c{k}" for k in range(num_connections)]
+  expected = [expected_ticks(messages, shard, args.channels) for shard in shards]
+  expected_total = sum(sum(counts.values()) for counts in expected)
+  print(f"Replaying {len(messages)} messages for {len(products)} products over {num_connections} connections; "
+        f"expecting {expected_total} ticks")
+
+  port = free_port()
+  server_log = open(os.path.join(workdir, "replay_server.log"), "w")
+  logger_log = open(os.path.join(workdir, "data_logger.log"), "w")
+  server = subprocess.Popen([sys.executable, "replay_server.py", *args.recordings, "--port", str(port),
+                             "--speed", "0"], cwd=HERE, stdout=server_log, stderr=subprocess.STDOUT)
+  logger = None
+  try:
+    time.sleep(args.startup_seconds)
+    logger = subprocess.Popen([sys.executable, "data_logger.py", "--uri", f"ws://localhost:{port}",
+                               "--products", *products, "--channels", *args.channels,
+                               "--connections", str(num_connections), "--output", output, "--format", "binary",
+                               "--rotate", "hour", "--flush-seconds", "0.2", "--summary-seconds", "0"],
+                              cwd=HERE, stdout=logger_log, stderr=subprocess.STDOUT)
+    deadline = time.monotonic() + args.timeout
+    while time.monotonic() < deadline and logger.poll() is None:
+      if sum(count_records(prefix) for prefix in prefixes) >= expected_total:
+        break
+      time.sleep(0.2)
+    # Let a few more flush intervals pass, so extra ticks would show up too
+    time.sleep(0.5)
+  finally:
+    if logger is not None and logger.poll() is None:
+      logger.send_signal(signal.SIGINT)
+      try:
+        logger.wait(timeout=10)
+      except subprocess.TimeoutExpired:
+        logger.kill()
+    server.terminate()
+    server.wait()
+    server_log.close()
+    logger_log.close()
+
+  errors = []
+  written = 0
+  for prefix, shard, counts in zip(prefixes, shards, expected):
+    written += sum(check_connection(prefix, products, shard, counts, errors).values())
+  if errors:
+    for name in ("replay_server.log", "data_logger.log"):
+      with open(os.path.join(workdir, name)) as log:
+        print(f"--- {name}\n{log.read()}")
+    for error in errors:
+      print(f"FAILED {error}")
+    return 1
+  print(f"OK: {written} ticks in {sum(len(rotated_files(prefix)) for prefix in prefixes)} rotated files")
+  return 0
+
+
+if __name__ == "__main__":
+  parser = argparse.ArgumentParser(description="Replay a recording through replay_server.py into data_logger.py "
+                                               "and check the rotated binary output.")
+  parser.add_argument("recordings", nargs="+", help=".jsonl files written by data_logger.py --record-raw")
+  parser.add_argument("--products", nargs="+", help="products to subscribe to; defaults to all in the recording")
+  parser.add_argument("--channels", nargs="+", default=CHANNELS)
+  parser.add_argument("--connections", type=int, default=1)
+  parser.add_argument("--timeout", type=float, default=60.0, help="seconds to wait for the expected ticks")
+  parser.add_argument("--startup-seconds", type=float, default=1.0, help="time the replay server gets to listen")
+  parser.add_argument("--keep", help="write the output to this directory instead of a temporary one")
+  args = parser.parse_args()
+  args.recordings = [os.path.abspath(path) for path in args.recordings]
+
+  if args.keep:
+    os.makedirs(args.keep, exist_ok=True)
+    sys.exit(run(args, os.path.abspath(args.keep)))
+  with tempfile.TemporaryDirectory() as workdir:
+    sys.exit(run(args, workdir))
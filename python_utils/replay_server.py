@@ -0,0 +1,88 @@
+'''
+Local stand-in for the Coinbase WebSocket feed that replays recorded messages.
+
+Tasks:
+1. Load one or more .jsonl recordings written by `data_logger.py --record-raw`
+   ("<receive_ts_ns><TAB><message>" per line) and merge them in receive-time order.
+2. Serve a WebSocket endpoint. For each client:
+  a. Wait for its subscribe message and note the requested products and channels.
+  b. Send a "subscriptions" acknowledgement, as the exchange does.
+  c. Replay the recorded messages that match the subscription, paced by their
+     original receive-time gaps divided by --speed (0 sends as fast as possible).
+  d. Keep the connection open once the recording is exhausted, so the logger
+     does not reconnect and capture it again.
+3. Used for end-to-end tests of the logger without network access:
+     python replay_server.py captures/coinbase_c0_20240501.jsonl --port 8765 --speed 0
+     python data_logger.py --uri ws://localhost:8765 --channels matches ticker level2_batch --connections 2
+'''
+
+import argparse
+import asyncio
+import json
+
+import websockets
+
+# Message types each subscribable channel produces
+CHANNEL_TYPES = {
+  "matches": {"match", "last_match"},
+  "ticker": {"ticker"},
+  "level2": {"snapshot", "l2update"},
+  "level2_batch": {"snapshot", "l2update"},
+}
+
+
+def load_recordings(paths):
+  '''Returns [(receive_ts_ns, message type, product, raw message)] sorted by receive time.'''
+  messages = []
+  for path in paths:
+    with open(path) as recording:
+      for line in recording:
+        receive_ts, _, message = line.rstrip("\n").partition("\t")
+        data = json.loads(message)
+        messages.append((int(receive_ts), data.get("type"), data.get("product_id"), message))
+  messages.sort(key=lambda entry: entry[0])
+  return messages
+
+
+async def replay(websocket, messages, speed):
+  subscribe = json.loads(await websocket.recv())
+  products = set(subscribe.get("product_ids", []))
+  channels = subscribe.get("channels", [])
+  types = set().union(*(CHANNEL_TYPES.get(channel, set()) for channel in channels))
+  await websocket.send(json.dumps({"type": "subscriptions", "channels": [
+    {"name": channel, "product_ids": sorted(products)} for channel in channels]}))
+
+  sent = 0
+  previous_ts = None
+  for receive_ts, message_type, product, message in messages:
+    if message_type not in types or product not in products:
+      continue
+    if speed > 0 and previous_ts is not None and receive_ts > previous_ts:
+      await asyncio.sleep((receive_ts - previous_ts) / 1e9 / speed)
+    previous_ts = receive_ts
+    await websocket.send(message)
+    sent += 1
+  print(f"Replayed {sent} messages for {len(products)} products")
+  await websocket.wait_closed()
+
+
+async def main(args):
+  messages = load_recordings(args.recordings)
+  print(f"Loaded {len(messages)} messages; serving on ws://{args.host}:{args.port}")
+  async with websockets.serve(lambda websocket, *_: replay(websocket, messages, args.speed), args.host, args.port,
+                              max_size=None):
+    await asyncio.Future()
+
+
+if __name__ == "__main__":
+  parser = argparse.ArgumentParser(description="Replay recorded feed messages over a local WebSocket.")
+  parser.add_argument("recordings", nargs="+", help=".jsonl files written by data_logger.py --record-raw")
+  parser.add_argument("--host", default="localhost")
+  parser.add_argument("--port", type=int, default=8765)
+  parser.add_argument("--speed", type=float, default=1.0, help="replay speed multiplier; 0 for no pacing")
+  args = parser.parse_args()
+
+  try:
+    asyncio.run(main(args))
+  except KeyboardInterrupt:
+    print("Replay stopped.")
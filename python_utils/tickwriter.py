@@ -0,0 +1,259 @@
+'''
+Buffered, rotating writers shared by the data logger tools.
+
+Records are appended to an in-memory batch by the receiving coroutine and
+written out by a dedicated writer task, either when the batch reaches
+`flush_records` or every `flush_seconds`, whichever comes first. File IO runs
+in a worker thread so the event loop never blocks on disk. A batch that fails
+to write is reported and dropped, and the task carries on with the next one.
+
+Output files rotate by the records' receive time (UTC):
+  - rotation "hour": <prefix>_YYYYMMDD_HH.<ext>
+  - rotation "day":  <prefix>_YYYYMMDD.<ext>
+  - rotation "none": <prefix>.<ext>
+
+Formats:
+  - "csv":    the legacy `timestamp, symbol, price, quantity` capture; trades only.
+  - "binary": the C++ engine's tick archive (cpp_engine/tickarchive.h): a 16-byte
+              header ("ARBTICK1", version, symbol count), 16-byte NUL-padded
+              symbols whose positions are pair IDs, then 40-byte TickRecords.
+              Files can be passed straight to `backtester`.
+  - "jsonl":  raw feed messages prefixed with their receive time (RawMessageWriter),
+              for replay_server.py.
+'''
+
+import asyncio
+import os
+import struct
+from collections import namedtuple
+from datetime import datetime, timezone
+
+TICK_MAGIC = b"ARBTICK1"
+TICK_VERSION = 1
+SYMBOL_FIELD_SIZE = 16
+HEADER_STRUCT = struct.Struct("<8sII")
+# exchange_ts_ns, receive_ts_ns, pair_id, kind, 3 reserved bytes, price, quantity
+RECORD_STRUCT = struct.Struct("<qqIB3xdd")
+
+KIND_TRADE = 0
+KIND_BEST_BID = 1
+KIND_BEST_ASK = 2
+
+Tick = namedtuple("Tick", ["exchange_ts_ns", "receive_ts_ns", "symbol", "kind", "price", "quantity"])
+
+
+def format_ns(ts_ns):
+  '''Formats nanoseconds since the epoch the way the CSV capture always has (microsecond precision).'''
+  return str(datetime.fromtimestamp(ts_ns // 1000 / 1e6, tz=timezone.utc))
+
+
+def encode_header(symbols):
+  '''Binary archive header and symbol table for `symbols`, in pair ID order.'''
+  parts = [HEADER_STRUCT.pack(TICK_MAGIC, TICK_VERSION, len(symbols))]
+  for symbol in symbols:
+    encoded = symbol.encode("ascii")
+    if len(encoded) > SYMBOL_FIELD_SIZE:
+      raise ValueError(f"Symbol too long for the tick archive: {symbol}")
+    parts.append(encoded.ljust(SYMBOL_FIELD_SIZE, b"\0"))
+  return b"".join(parts)
+
+
+class BatchWriter:
+  '''
+  Collects items in memory and writes them from a background task.
+
+  Usage:
+    writer = RotatingTickWriter("captures/coinbase", symbols, fmt="binary", rotation="hour")
+    task = asyncio.create_task(writer.run())
+    writer.add(tick)        # from the receiving coroutine; never blocks
+    ...
+    await writer.close()    # flushes what is left and stops the task
+
+  Subclasses implement `_write_batch`, which runs in a worker thread. If it raises,
+  the batch is counted in `failed_batches` and `items_dropped` and the task keeps
+  running, so a full disk or a bad file loses that batch rather than every later one.
+  '''
+
+  def __init__(self, flush_records=1000, flush_seconds=1.0):
+    self.flush_records = flush_records
+    self.flush_seconds = flush_seconds
+    self.batch = []
+    self.flush_requested = asyncio.Event()
+    self.closing = False
+    self.records_written = 0
+    self.bytes_written = 0
+    self.failed_batches = 0
+    self.items_dropped = 0
+
+  def add(self, item):
+    '''Queues one item for writing.'''
+    self.batch.append(item)
+    if len(self.batch) >= self.flush_records:
+      self.flush_requested.set()
+
+  def pending(self):
+    return len(self.batch)
+
+  async def run(self):
+    '''Writer task: flushes on size, on time, and once more when closed.'''
+    while not self.closing:
+      try:
+        await asyncio.wait_for(self.flush_requested.wait(), timeout=self.flush_seconds)
+      except asyncio.TimeoutError:
+        pass
+      self.flush_requested.clear()
+      await self.flush()
+    await self.flush()
+
+  async def flush(self):
+    '''Writes the current batch; a failure is reported and the batch dropped.'''
+    if not self.batch:
+      return
+    batch, self.batch = self.batch, []
+    try:
+      await asyncio.get_running_loop().run_in_executor(None, self._write_batch, batch)
+    except Exception as e:
+      self.failed_batches += 1
+      self.items_dropped += len(batch)
+      print(f"{type(self).__name__}: dropped a batch of {len(batch)} after a write error: {e!r}")
+
+  async def close(self):
+    self.closing = True
+    self.flush_requested.set()
+
+  def _write_batch(self, batch):
+    raise NotImplementedError
+
+
+def rotated_path(prefix, extension, rotation, receive_ts_ns):
+  '''Output file for a record received at `receive_ts_ns` under `rotation` ("none", "hour" or "day").'''
+  if rotation == "none":
+    return f"{prefix}.{extension}"
+  moment = datetime.fromtimestamp(receive_ts_ns // 1_000_000_000, tz=timezone.utc)
+  stamp = moment.strftime("%Y%m%d_%H" if rotation == "hour" else "%Y%m%d")
+  return f"{prefix}_{stamp}.{extension}"
+
+
+def append_file(path, payload, header=b""):
+  '''Appends `payload` to `path`, creating it (and its directory) with `header` first if it is new.'''
+  directory = os.path.dirname(path)
+  if directory:
+    os.makedirs(directory, exist_ok=True)
+  is_new = not os.path.exists(path) or os.path.getsize(path) == 0
+  with open(path, "ab") as output:
+    if is_new:
+      output.write(header)
+    output.write(payload)
+
+
+class RotatingTickWriter(BatchWriter):
+  '''Writes Ticks to rotating CSV or binary tick archive files.'''
+
+  def __init__(self, prefix, symbols, fmt="csv", rotation="day", flush_records=1000, flush_seconds=1.0):
+    if fmt not in ("csv", "binary"):
+      raise ValueError(f"Unknown format: {fmt}")
+    if rotation not in ("none", "hour", "day"):
+      raise ValueError(f"Unknown rotation: {rotation}")
+    super().__init__(flush_records, flush_seconds)
+
+    self.prefix = prefix
+    self.symbols = list(symbols)
+    self.pair_ids = {symbol: pair_id for pair_id, symbol in enumerate(self.symbols)}
+    self.fmt = fmt
+    self.rotation = rotation
+    self.dropped_unknown_symbol = 0
+    # Rotated path -> the file actually appended to, once its header has been checked
+    self.binary_paths = {}
+
+  def path_for(self, receive_ts_ns):
+    return rotated_path(self.prefix, "bin" if self.fmt == "binary" else "csv", self.rotation, receive_ts_ns)
+
+  def _write_batch(self, batch):
+    '''Groups the batch by output file and appends each group.'''
+    groups = {}
+    for tick in batch:
+      groups.setdefault(self.path_for(tick.receive_ts_ns), []).append(tick)
+
+    for path, ticks in groups.items():
+      if self.fmt == "binary":
+        header = encode_header(self.symbols)
+        path = self._binary_path(path, header)
+        payload = self._encode_binary(ticks)
+      else:
+        header = b"timestamp,symbol,price,quantity\n"
+        payload = self._encode_csv(ticks)
+      append_file(path, payload, header)
+      self.bytes_written += len(payload)
+
+  def _encode_binary(self, ticks):
+    parts = []
+    for tick in ticks:
+      pair_id = self.pair_ids.get(tick.symbol)
+      if pair_id is None:
+        self.dropped_unknown_symbol += 1
+        continue
+      parts.append(RECORD_STRUCT.pack(tick.exchange_ts_ns, tick.receive_ts_ns, pair_id, tick.kind,
+                                      tick.price, tick.quantity))
+    self.records_written += len(parts)
+    return b"".join(parts)
+
+  def _encode_csv(self, ticks):
+    lines = [f"{format_ns(tick.exchange_ts_ns)}, {tick.symbol}, {tick.price}, {tick.quantity}\n"
+             for tick in ticks if tick.kind == KIND_TRADE]
+    self.records_written += len(lines)
+    return "".join(lines).encode("ascii")
+
+  def _binary_path(self, path, header):
+    '''
+    The file to append `path`'s ticks to. Appending is only safe if an existing file
+    maps pair IDs to the same symbols; if it does not (the product list changed
+    between runs), the ticks go to the first of <path>.1.bin, <path>.2.bin, ... that
+    is new or matches.
+    '''
+    resolved = self.binary_paths.get(path)
+    if resolved is not None:
+      return resolved
+    root, extension = os.path.splitext(path)
+    candidate = path
+    suffix = 0
+    while not self._binary_header_matches(candidate, header):
+      suffix += 1
+      candidate = f"{root}.{suffix}{extension}"
+    if suffix > 0:
+      print(f"{path} was written with a different symbol list; writing to {candidate} instead")
+    self.binary_paths[path] = candidate
+    return candidate
+
+  @staticmethod
+  def _binary_header_matches(path, expected):
+    '''True if `path` is new or empty, or starts with `expected`.'''
+    if not os.path.exists(path) or os.path.getsize(path) == 0:
+      return True
+    with open(path, "rb") as existing:
+      return existing.read(len(expected)) == expected
+
+
+class RawMessageWriter(BatchWriter):
+  '''
+  Records raw feed messages as "<receive_ts_ns><TAB><message>" lines in rotating .jsonl files.
+  These are what replay_server.py plays back.
+  '''
+
+  def __init__(self, prefix, rotation="day", flush_records=1000, flush_seconds=1.0):
+    super().__init__(flush_records, flush_seconds)
+    self.prefix = prefix
+    self.rotation = rotation
+
+  def add_message(self, receive_ts_ns, message):
+    self.add((receive_ts_ns, message))
+
+  def _write_batch(self, batch):
+    groups = {}
+    for receive_ts_ns, message in batch:
+      path = rotated_path(self.prefix, "jsonl", self.rotation, receive_ts_ns)
+      groups.setdefault(path, []).append(f"{receive_ts_ns}\t{message}\n")
+    for path, lines in groups.items():
+      payload = "".join(lines).encode("utf-8")
+      append_file(path, payload)
+      self.records_written += len(lines)
+      self.bytes_written += len(payload)